@@ -0,0 +1,443 @@
+/***********************************************************************
+ *          GINSFSM_BENCH.C
+ *
+ *          Micro-benchmarks of the gobj core hot paths.
+ *          Report ns/op and allocations/op (gbmem_malloc calls).
+ *
+ *          The allocations are counted wrapping gbmem_malloc in link time:
+ *              -Wl,--wrap=gbmem_malloc,--wrap=gbmem_strdup,--wrap=gbmem_strndup
+ *
+ *          Usage: ginsfsm_bench [-v] [filter]
+ *              -v      show the log in stdout
+ *              filter  run only the benchmarks whose name contains filter
+ *
+ *          Copyright (c) 2026 Niyamaka.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+#include "../src/ginsfsm.h"
+
+/***************************************************************
+ *              Constants
+ ***************************************************************/
+#define N_SUBSCRIBERS   1000
+
+/***************************************************************
+ *              Structures
+ ***************************************************************/
+typedef struct {
+    hgobj yuno;
+    hgobj target;
+    hgobj publisher[6];     // 1, 10, 1000 subscribers; without and with __filter__
+    hgobj subscriber[N_SUBSCRIBERS];
+    istream ist;
+    char find_path[256];
+} bench_t;
+
+/***************************************************************
+ *              Prototypes
+ ***************************************************************/
+void *__real_gbmem_malloc(size_t size);
+char *__real_gbmem_strdup(const char *str);
+char *__real_gbmem_strndup(const char *str, size_t size);
+void *__real_gbmem_realloc(void *p, size_t new_size);
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE uint64_t allocs = 0;
+PRIVATE bench_t bench;
+PRIVATE const char *bench_filter = 0;
+PRIVATE BOOL verbose = FALSE;
+
+/***************************************************************************
+ *  Count allocations
+ ***************************************************************************/
+void *__wrap_gbmem_malloc(size_t size)
+{
+    allocs++;
+    return __real_gbmem_malloc(size);
+}
+char *__wrap_gbmem_strdup(const char *str)
+{
+    allocs++;
+    return __real_gbmem_strdup(str);
+}
+char *__wrap_gbmem_strndup(const char *str, size_t size)
+{
+    allocs++;
+    return __real_gbmem_strndup(str, size);
+}
+void *__wrap_gbmem_realloc(void *p, size_t new_size)
+{
+    allocs++; // growth paths count as allocations too
+    return __real_gbmem_realloc(p, new_size);
+}
+
+
+
+
+            /***************************************************************
+             *              Synthetic gclasses
+             ***************************************************************/
+
+
+
+
+/*---------------------------------------------*
+ *      Yuno
+ *---------------------------------------------*/
+PRIVATE const sdata_desc_t yuno_attrs[] = {
+/*-ATTR-type------------name----------------flag----------------default---------description---------- */
+SDATA (ASN_UNSIGNED,    "watcher_pid",      SDF_RD,             0,              "Watcher pid"),
+SDATA_END()
+};
+
+PRIVATE const EVENT yuno_input_events[] = {
+    {NULL, 0, 0, 0}
+};
+PRIVATE const EVENT yuno_output_events[] = {
+    {NULL, 0, 0, 0}
+};
+PRIVATE const char *yuno_state_names[] = {
+    "ST_IDLE",
+    NULL
+};
+PRIVATE EV_ACTION YUNO_ST_IDLE[] = {
+    {0,0,0}
+};
+PRIVATE EV_ACTION *yuno_states[] = {
+    YUNO_ST_IDLE,
+    NULL
+};
+PRIVATE FSM yuno_fsm = {
+    yuno_input_events,
+    yuno_output_events,
+    yuno_state_names,
+    yuno_states,
+};
+PRIVATE GCLASS yuno_gclass = {
+    0,  // base
+    "BenchYuno",
+    &yuno_fsm,
+    {0},
+    0,  // lmt
+    yuno_attrs,
+    0,  // priv_size
+    0,  // authz_table
+    0,  // s_user_trace_level
+    0,  // cmds
+    0,  // gcflag
+};
+
+/*---------------------------------------------*
+ *      Bench gclass:
+ *          receiver of events and publisher
+ *---------------------------------------------*/
+PRIVATE const sdata_desc_t bench_attrs[] = {
+/*-ATTR-type------------name----------------flag----------------default---------description---------- */
+SDATA (ASN_INTEGER,     "counter",          SDF_RD|SDF_WR,      0,              "Counter"),
+SDATA (ASN_OCTET_STR,   "label",            SDF_RD|SDF_WR,      "",             "Label"),
+SDATA_END()
+};
+
+PRIVATE int ac_ping(hgobj gobj, const char *event, json_t *kw, hgobj src)
+{
+    KW_DECREF(kw);
+    return 0;
+}
+PRIVATE int ac_message(hgobj gobj, const char *event, json_t *kw, hgobj src)
+{
+    GBUFFER *gbuf = (GBUFFER *)(size_t)kw_get_int(kw, "gbuffer", 0, 0);
+    GBUF_DECREF(gbuf);
+    KW_DECREF(kw);
+    return 0;
+}
+
+PRIVATE const EVENT bench_input_events[] = {
+    {"EV_PING",         0, 0, 0},
+    {"EV_PUBLISHED",    0, 0, 0},
+    {"EV_ON_MESSAGE",   0, 0, 0},
+    {"EV_REFUSED",      0, 0, 0},
+    {NULL, 0, 0, 0}
+};
+PRIVATE const EVENT bench_output_events[] = {
+    {"EV_PUBLISHED",    EVF_NO_WARN_SUBS, 0, 0},
+    {NULL, 0, 0, 0}
+};
+PRIVATE const char *bench_state_names[] = {
+    "ST_IDLE",
+    "ST_OTHER",
+    NULL
+};
+PRIVATE EV_ACTION BENCH_ST_IDLE[] = {
+    {"EV_PING",         ac_ping,        0},
+    {"EV_PUBLISHED",    ac_ping,        0},
+    {"EV_ON_MESSAGE",   ac_message,     0},
+    {0,0,0}
+};
+PRIVATE EV_ACTION BENCH_ST_OTHER[] = {
+    {"EV_REFUSED",      ac_ping,        0},
+    {0,0,0}
+};
+PRIVATE EV_ACTION *bench_states[] = {
+    BENCH_ST_IDLE,
+    BENCH_ST_OTHER,
+    NULL
+};
+PRIVATE FSM bench_fsm = {
+    bench_input_events,
+    bench_output_events,
+    bench_state_names,
+    bench_states,
+};
+PRIVATE GCLASS bench_gclass = {
+    0,  // base
+    "Bench",
+    &bench_fsm,
+    {0},
+    0,  // lmt
+    bench_attrs,
+    0,  // priv_size
+    0,  // authz_table
+    0,  // s_user_trace_level
+    0,  // cmds
+    0,  // gcflag
+};
+
+
+
+
+            /***************************************************************
+             *              Benchmarks
+             ***************************************************************/
+
+
+
+
+/***************************************************************************
+ *  Run `n` times the `fn` and print ns/op, allocs/op (reallocs included)
+ ***************************************************************************/
+PRIVATE void run(const char *name, uint64_t n, void (*fn)(uint64_t i, void *data), void *data)
+{
+    if(bench_filter && !strstr(name, bench_filter)) {
+        return;
+    }
+
+    /*
+     *  Warm up
+     */
+    for(uint64_t i=0; i<n/10 + 1; i++) {
+        fn(i, data);
+    }
+
+    uint64_t allocs0 = allocs;
+    uint64_t t0 = uv_hrtime();
+    for(uint64_t i=0; i<n; i++) {
+        fn(i, data);
+    }
+    uint64_t t1 = uv_hrtime();
+
+    printf("%-40s %10llu ops %12.1f ns/op %10.2f allocs/op\n",
+        name,
+        (unsigned long long)n,
+        (double)(t1 - t0) / n,
+        (double)(allocs - allocs0) / n
+    );
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE void bench_create_destroy(uint64_t i, void *data)
+{
+    hgobj gobj = gobj_create("bench-tmp", &bench_gclass, 0, bench.yuno);
+    gobj_destroy(gobj);
+}
+
+PRIVATE void bench_send_hit(uint64_t i, void *data)
+{
+    gobj_send_event(bench.target, "EV_PING", 0, bench.yuno);
+}
+
+PRIVATE void bench_send_hit_id(uint64_t i, void *data)
+{
+    gobj_send_event_id(bench.target, *(event_id_t *)data, 0, bench.yuno);
+}
+
+/*
+ *  The refused event is logged by _gobj_send_event (LOG_OPT_TRACE_STACK).
+ *  This case runs with the log shut down (see bench_log_off()),
+ *  so it times the dispatch miss and not the log.
+ */
+PRIVATE void bench_send_miss(uint64_t i, void *data)
+{
+    gobj_send_event(bench.target, "EV_REFUSED", 0, bench.yuno);
+}
+
+PRIVATE void bench_publish(uint64_t i, void *data)
+{
+    hgobj publisher = data;
+    gobj_publish_event(publisher, "EV_PUBLISHED", json_pack("{s:i}", "id", 1));
+}
+
+PRIVATE void bench_read_int_attr(uint64_t i, void *data)
+{
+    gobj_read_int32_attr(bench.target, "counter");
+}
+
+PRIVATE void bench_write_int_attr(uint64_t i, void *data)
+{
+    gobj_write_int32_attr(bench.target, "counter", (int32_t)i);
+}
+
+PRIVATE void bench_read_str_attr(uint64_t i, void *data)
+{
+    gobj_read_str_attr(bench.target, "label");
+}
+
+PRIVATE void bench_write_str_attr(uint64_t i, void *data)
+{
+    gobj_write_str_attr(bench.target, "label", (i & 1)? "odd":"even");
+}
+
+PRIVATE void bench_find_gobj(uint64_t i, void *data)
+{
+    gobj_find_gobj(bench.find_path);
+}
+
+PRIVATE void bench_istream_consume(uint64_t i, void *data)
+{
+    char line[] = "GET / HTTP/1.1\r\n";
+    istream_read_until_delimiter(bench.ist, "\r\n", 2, "EV_ON_MESSAGE");
+    istream_consume(bench.ist, line, sizeof(line)-1);
+}
+
+/***************************************************************************
+ *  Build the tree of gobjs
+ ***************************************************************************/
+PRIVATE int setup(void)
+{
+    char name[64];
+
+    gobj_register_yuno("bench", &yuno_gclass, FALSE);
+    gobj_register_gclass(&bench_gclass);
+
+    bench.yuno = gobj_yuno_factory(
+        "", "", "", "", "", "", "", "bench", "", 0
+    );
+    if(!bench.yuno) {
+        printf("Cannot create the yuno\n");
+        return -1;
+    }
+    bench.target = gobj_create("target", &bench_gclass, 0, bench.yuno);
+
+    for(int i=0; i<N_SUBSCRIBERS; i++) {
+        snprintf(name, sizeof(name), "sub-%d", i);
+        bench.subscriber[i] = gobj_create(name, &bench_gclass, 0, bench.yuno);
+    }
+    snprintf(bench.find_path, sizeof(bench.find_path), "%s",
+        gobj_full_name(bench.subscriber[N_SUBSCRIBERS/2])
+    );
+
+    int n_subs[3] = {1, 10, N_SUBSCRIBERS};
+    for(int f=0; f<2; f++) {
+        for(int k=0; k<3; k++) {
+            snprintf(name, sizeof(name), "pub-%d%s", n_subs[k], f?"-filter":"");
+            hgobj publisher = gobj_create(name, &bench_gclass, 0, bench.yuno);
+            bench.publisher[f*3 + k] = publisher;
+            for(int i=0; i<n_subs[k]; i++) {
+                json_t *kw_subs = 0;
+                if(f) {
+                    kw_subs = json_pack("{s:{s:i}}", "__filter__", "id", 1);
+                }
+                gobj_subscribe_event(publisher, "EV_PUBLISHED", kw_subs, bench.subscriber[i]);
+            }
+        }
+    }
+
+    bench.ist = istream_create(bench.target, 4*1024, 32*1024, 0, 0);
+    return 0;
+}
+
+/***************************************************************************
+ *  Log on/off, to keep the log out of the measured paths
+ ***************************************************************************/
+PRIVATE void bench_log_on(const char *argv0)
+{
+    log_startup("ginsfsm_bench", __ginsfsm_version__, argv0);
+    if(verbose) {
+        log_add_handler("stdout", "stdout", LOG_OPT_ALL, 0);
+    }
+}
+PRIVATE void bench_log_off(void)
+{
+    log_end();
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    for(int i=1; i<argc; i++) {
+        if(strcmp(argv[i], "-v")==0) {
+            verbose = TRUE;
+        } else {
+            bench_filter = argv[i];
+        }
+    }
+
+    init_ghelpers_library("ginsfsm_bench");
+    gbmem_startup_system(16*1024*1024, 1024LL*1024*1024*1024);
+    json_set_alloc_funcs(gbmem_malloc, gbmem_free);
+    bench_log_on(argv[0]);
+    init_ginsfsm_library();
+
+    gobj_start_up(
+        0,  // jn_global_settings
+        0,  // startup_persistent_attrs
+        0,  // end_persistent_attrs
+        0,  // load_persistent_attrs
+        0,  // save_persistent_attrs
+        0,  // remove_persistent_attrs
+        0,  // list_persistent_attrs
+        0,  // global_command_parser
+        0,  // global_stats_parser
+        0,  // global_authz_checker
+        0   // global_authenticate_parser
+    );
+    if(setup()<0) {
+        return -1;
+    }
+
+    event_id_t ev_ping = gobj_event_atom("EV_PING");
+
+    run("gobj_create+gobj_destroy",         100000,     bench_create_destroy, 0);
+    run("gobj_send_event hit",              10000000,   bench_send_hit, 0);
+    run("gobj_send_event_id hit",           10000000,   bench_send_hit_id, &ev_ping);
+    bench_log_off();
+    run("gobj_send_event miss",             1000000,    bench_send_miss, 0);
+    bench_log_on(argv[0]);
+    run("gobj_publish_event 1 subs",        1000000,    bench_publish, bench.publisher[0]);
+    run("gobj_publish_event 10 subs",       100000,     bench_publish, bench.publisher[1]);
+    run("gobj_publish_event 1000 subs",     1000,       bench_publish, bench.publisher[2]);
+    run("gobj_publish_event 1 subs filter", 1000000,    bench_publish, bench.publisher[3]);
+    run("gobj_publish_event 10 subs filter",100000,     bench_publish, bench.publisher[4]);
+    run("gobj_publish_event 1000 subs filter", 1000,    bench_publish, bench.publisher[5]);
+    run("gobj_read_int32_attr",             10000000,   bench_read_int_attr, 0);
+    run("gobj_write_int32_attr",            10000000,   bench_write_int_attr, 0);
+    run("gobj_read_str_attr",               10000000,   bench_read_str_attr, 0);
+    run("gobj_write_str_attr",              1000000,    bench_write_str_attr, 0);
+    run("gobj_find_gobj",                   100000,     bench_find_gobj, 0);
+    run("istream_consume (re-armed)",       1000000,    bench_istream_consume, 0);
+
+    ISTREAM_DESTROY(bench.ist);
+    end_ginsfsm_library();
+    log_end();
+    end_ghelpers_library();
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <inttypes.h>
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 #if  defined(WIN32) || defined(_WINDOWS)
 	#include <io.h>
 #else
@@ -20,6 +21,7 @@
  *         Constants
  ****************************************************************/
 #define _FLAG_DESTROYED     0x0001
+#define _FLAG_READ_ONLY     0x0002
 #define IS_DESTROYING(s)    ((s)->_flag & _FLAG_DESTROYED)
 
 /****************************************************************
@@ -55,8 +57,72 @@ typedef struct _SData_t {
     uint64_t _max_suboid;   // maximum oid in this sdata (last oid + 1)
     uint32_t _flag;         // flag
     char *_bf;              // internal buffer
+    struct _sdata_chunk_t *_chunk; // slab chunk of the record, 0 if allocated alone
 } SData_t;
 
+/*
+ *  Slab of the records of a schema: header and buffer in one aligned slot.
+ *  Free slots are reused, linked by their first word in their chunk.
+ *  The chunks start small and double until SDATA_SLAB_CHUNK,
+ *  a schema with a few records costs a few slots.
+ *  A chunk is returned to gbmem when all its slots are free,
+ *  except one full-size spare chunk to not thrash on create/destroy.
+ */
+#define SDATA_SLAB_ALIGN    64
+#define SDATA_SLAB_CHUNK    (64*1024)
+#define SDATA_SLAB_MIN_SLOTS 4
+#define SDATA_HEADER_SIZE   ((sizeof(SData_t) + SDATA_SLAB_ALIGN - 1) & ~(size_t)(SDATA_SLAB_ALIGN - 1))
+
+typedef struct _sdata_chunk_t {
+    struct _sdata_chunk_t *next;    // chunks with free slots
+    struct _sdata_chunk_t *prev;
+    struct _sdata_slab_t *slab;
+    uint32_t n_slots;
+    uint32_t n_alive;
+    void *free_slots;
+} sdata_chunk_t;
+
+typedef struct _sdata_slab_t {
+    uint32_t total_size;    // _total_size of the records
+    uint32_t slot_size;     // header + buffer, multiple of SDATA_SLAB_ALIGN
+    uint32_t max_chunk_slots;   // slots of a SDATA_SLAB_CHUNK chunk
+    uint32_t next_chunk_slots;  // slots of the next chunk, doubling
+    uint32_t n_alive;
+    BOOL orphan;            // the schema index is freed, free the slab with the last record
+    sdata_chunk_t *chunks;  // chunks with free slots, full chunks are unlinked
+    sdata_chunk_t *spare;   // empty chunk kept for reuse
+} sdata_slab_t;
+
+/*
+ *  Hash index of the item names of a schema (case-insensitive).
+ *  Built the first time the schema is used, keyed on the schema pointer.
+ *  The indexes live until sdata_forget_schema() or sdata_free_schema_indexes().
+ */
+typedef struct {
+    const sdata_desc_t *schema;
+    uint32_t mask;          // slots - 1
+    int32_t *slots;         // item index + 1, 0 is empty
+    sdata_slab_t *slab;     // records of the schema
+} schema_index_t;
+
+/*
+ *  Hash index of the primary keys of the rows of an iter.
+ *  Attached with sdata_iter_pkey_index(), keyed on the iter pointer.
+ */
+typedef struct {
+    uint32_t hash;          // hash of the normalized pkey value
+    hsdata hs;              // 0 is empty
+} pkey_entry_t;
+
+typedef struct {
+    dl_list_t *iter;
+    int type;               // type of the pkey item, 0 until the first row
+    uint32_t mask;          // entries - 1
+    uint32_t used;
+    pkey_entry_t *entries;
+    hsdata relink;          // row unlinked while its pkey is rewritten
+} pkey_index_t;
+
 
 /****************************************************************
  *         Data
@@ -83,6 +149,14 @@ PRIVATE int sizeof_types[][2] = {
 
 #define SDATA_METADATA_TYPE uint32_t
 
+PRIVATE schema_index_t *__schema_indexes__ = 0;     // open addressing by schema pointer
+PRIVATE uint32_t __schema_indexes_mask__ = 0;
+PRIVATE uint32_t __schema_indexes_used__ = 0;
+
+PRIVATE pkey_index_t **__pkey_indexes__ = 0;        // open addressing by iter pointer
+PRIVATE uint32_t __pkey_indexes_mask__ = 0;
+PRIVATE uint32_t __pkey_indexes_used__ = 0;
+
 PRIVATE const char *sdata_flag_names[] = {
     "SDF_NOTACCESS",
     "SDF_RD",
@@ -113,6 +187,9 @@ PRIVATE const char *sdata_flag_names[] = {
  *         Prototypes
  ****************************************************************/
 PRIVATE int items_count(register const sdata_desc_t *items);
+PRIVATE schema_index_t *schema_index_get(const sdata_desc_t *schema);
+PRIVATE SData_t *sdata_alloc(const sdata_desc_t *schema);
+PRIVATE void slab_release(sdata_chunk_t *chunk, SData_t *sdata);
 PRIVATE int calculate_size(register SData_t *sdata, int acc);
 PRIVATE void build_default_values(SData_t *sdata);
 PRIVATE void clear_values(SData_t *sdata);
@@ -121,6 +198,8 @@ PRIVATE void set_default(SData_t *sdata, const sdata_desc_t *it, void *value);
 PRIVATE void *item_pointer(hsdata hs, const sdata_desc_t *it);
 PRIVATE json_t *itdesc2json0(const sdata_desc_t *it);
 PRIVATE json_t *itdesc2json(const sdata_desc_t *it);
+PRIVATE void pkey_indexes_unlink(hsdata hs, const sdata_desc_t *it, BOOL relink);
+PRIVATE void pkey_indexes_relink(hsdata hs);
 
 
 
@@ -154,16 +233,12 @@ PUBLIC hsdata sdata_create(
         return 0;
     }
 
-    SData_t *sdata = gbmem_malloc(sizeof(SData_t));
+    /*
+     *  Calculate size of buffer and alloc
+     */
+    SData_t *sdata = sdata_alloc(schema);
     if(!sdata) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_MEMORY_ERROR,
-            "msg",          "%s", "no memory for sdata",
-            "size",         "%d", sizeof(SData_t),
-            NULL
-        );
+        // Error already logged
         return 0;
     }
     sdata->refcount = 1;
@@ -172,27 +247,6 @@ PUBLIC hsdata sdata_create(
         snprintf(sdata->resource, sizeof(sdata->resource), "%s", resource);
     }
 
-    /*
-     *  Calculate size of buffer and alloc
-     */
-    sdata->items = schema;
-    sdata->_total_size = calculate_size(sdata, 0); // idempotent.
-
-    if(sdata->_total_size) {
-        sdata->_bf = gbmem_malloc(sdata->_total_size);
-        if(!sdata->_bf) {
-            log_error(0,
-                "gobj",         "%s", __FILE__,
-                "function",     "%s", __FUNCTION__,
-                "msgset",       "%s", MSGSET_MEMORY_ERROR,
-                "msg",          "%s", "no memory for bf",
-                "size",         "%d", sdata->_total_size,
-                NULL
-            );
-            return 0;
-        }
-    }
-
     /*
      *  Build default values
      */
@@ -224,8 +278,22 @@ PUBLIC void sdata_destroy(hsdata hs)
         );
         return;
     }
+    if(__pkey_indexes_used__) {
+        const sdata_desc_t *it = sdata->items;
+        while(it && it->name) {
+            if(it->flag & SDF_PKEY) {
+                pkey_indexes_unlink(sdata, it, FALSE);
+                break;
+            }
+            it++;
+        }
+    }
     sdata->_flag |=_FLAG_DESTROYED;
     clear_values(sdata);
+    if(sdata->_chunk) {
+        slab_release(sdata->_chunk, sdata);
+        return;
+    }
     GBMEM_FREE(sdata->_bf);
     GBMEM_FREE(sdata);
 }
@@ -271,6 +339,403 @@ PRIVATE int items_count(register const sdata_desc_t *items)
     return n;
 }
 
+/***************************************************************************
+ *  Hash of an item name, case-insensitive
+ ***************************************************************************/
+PRIVATE inline uint32_t name_hash(const char *name)
+{
+    uint32_t h = 2166136261u;   // FNV-1a
+    while(*name) {
+        h ^= (unsigned char)tolower((unsigned char)*name);
+        h *= 16777619u;
+        name++;
+    }
+    return h;
+}
+
+/***************************************************************************
+ *  Hash of a pointer (schemas, iters)
+ ***************************************************************************/
+PRIVATE inline uint32_t pointer_hash(const void *ptr)
+{
+    uint64_t p = (uint64_t)(uintptr_t)ptr;
+    p ^= p >> 33;
+    p *= 0xff51afd7ed558ccdULL;
+    p ^= p >> 33;
+    return (uint32_t)p;
+}
+
+/***************************************************************************
+ *  Build the name index of a schema
+ ***************************************************************************/
+PRIVATE int32_t *schema_index_build(const sdata_desc_t *schema, uint32_t *mask)
+{
+    int n = items_count(schema);
+    uint32_t size = 8;
+    while(size < (uint32_t)n * 2) {
+        size <<= 1;
+    }
+    int32_t *slots = gbmem_malloc(sizeof(int32_t) * size);
+    if(!slots) {
+        return 0;
+    }
+    for(int idx=0; idx<n; idx++) {
+        const char *name = schema[idx].name;
+        uint32_t i = name_hash(name) & (size - 1);
+        BOOL repeated = FALSE;
+        while(slots[i]) {
+            if(strcasecmp(schema[slots[i]-1].name, name)==0) {
+                repeated = TRUE; // the first one wins, like the linear search
+                break;
+            }
+            i = (i + 1) & (size - 1);
+        }
+        if(!repeated) {
+            slots[i] = idx + 1;
+        }
+    }
+    *mask = size - 1;
+    return slots;
+}
+
+/***************************************************************************
+ *  Return the name index of the schema, built on first use.
+ *  Return 0 if no memory (use the linear search).
+ ***************************************************************************/
+PRIVATE schema_index_t *schema_index_get(const sdata_desc_t *schema)
+{
+    if(__schema_indexes__) {
+        uint32_t i = pointer_hash(schema) & __schema_indexes_mask__;
+        while(__schema_indexes__[i].schema) {
+            if(__schema_indexes__[i].schema == schema) {
+                return &__schema_indexes__[i];
+            }
+            i = (i + 1) & __schema_indexes_mask__;
+        }
+    }
+
+    /*
+     *  New schema
+     */
+    if(!__schema_indexes__ || (__schema_indexes_used__ + 1) * 2 > __schema_indexes_mask__ + 1) {
+        uint32_t new_size = __schema_indexes__? (__schema_indexes_mask__ + 1) * 2 : 64;
+        schema_index_t *new_indexes = gbmem_malloc(sizeof(schema_index_t) * new_size);
+        if(!new_indexes) {
+            return 0;
+        }
+        for(uint32_t j=0; __schema_indexes__ && j<=__schema_indexes_mask__; j++) {
+            if(__schema_indexes__[j].schema) {
+                uint32_t i = pointer_hash(__schema_indexes__[j].schema) & (new_size - 1);
+                while(new_indexes[i].schema) {
+                    i = (i + 1) & (new_size - 1);
+                }
+                new_indexes[i] = __schema_indexes__[j];
+            }
+        }
+        GBMEM_FREE(__schema_indexes__);
+        __schema_indexes__ = new_indexes;
+        __schema_indexes_mask__ = new_size - 1;
+    }
+
+    uint32_t mask;
+    int32_t *slots = schema_index_build(schema, &mask);
+    if(!slots) {
+        return 0;
+    }
+    uint32_t i = pointer_hash(schema) & __schema_indexes_mask__;
+    while(__schema_indexes__[i].schema) {
+        i = (i + 1) & __schema_indexes_mask__;
+    }
+    __schema_indexes__[i].schema = schema;
+    __schema_indexes__[i].mask = mask;
+    __schema_indexes__[i].slots = slots;
+    __schema_indexes_used__++;
+    return &__schema_indexes__[i];
+}
+
+/***************************************************************************
+ *  Return the slab of the schema records, create it if not exist.
+ *  Return 0 if the records of the schema must be allocated alone.
+ ***************************************************************************/
+PRIVATE sdata_slab_t *schema_slab_get(const sdata_desc_t *schema, uint32_t total_size)
+{
+    schema_index_t *index = schema_index_get(schema);
+    if(!index) {
+        return 0;
+    }
+    if(!index->slab) {
+        size_t slot_size = SDATA_HEADER_SIZE + total_size;
+        slot_size = (slot_size + SDATA_SLAB_ALIGN - 1) & ~(size_t)(SDATA_SLAB_ALIGN - 1);
+        if(slot_size > SDATA_SLAB_CHUNK/4) {
+            return 0; // too big, it's not worth
+        }
+        sdata_slab_t *slab = gbmem_malloc(sizeof(sdata_slab_t));
+        if(!slab) {
+            return 0;
+        }
+        slab->total_size = total_size;
+        slab->slot_size = (uint32_t)slot_size;
+        slab->max_chunk_slots = (uint32_t)(SDATA_SLAB_CHUNK / slot_size);
+        slab->next_chunk_slots = SDATA_SLAB_MIN_SLOTS;
+        index->slab = slab;
+    }
+    if(index->slab->total_size != total_size) {
+        return 0;
+    }
+    return index->slab;
+}
+
+/***************************************************************************
+ *  Link/unlink the chunk in the list of chunks with free slots
+ ***************************************************************************/
+PRIVATE void slab_link_chunk(sdata_slab_t *slab, sdata_chunk_t *chunk)
+{
+    chunk->prev = 0;
+    chunk->next = slab->chunks;
+    if(slab->chunks) {
+        slab->chunks->prev = chunk;
+    }
+    slab->chunks = chunk;
+}
+
+PRIVATE void slab_unlink_chunk(sdata_slab_t *slab, sdata_chunk_t *chunk)
+{
+    if(chunk->prev) {
+        chunk->prev->next = chunk->next;
+    } else {
+        slab->chunks = chunk->next;
+    }
+    if(chunk->next) {
+        chunk->next->prev = chunk->prev;
+    }
+    chunk->next = chunk->prev = 0;
+}
+
+/***************************************************************************
+ *  Get a zeroed slot from the slab
+ ***************************************************************************/
+PRIVATE SData_t *slab_alloc(sdata_slab_t *slab, sdata_chunk_t **pchunk)
+{
+    sdata_chunk_t *chunk = slab->chunks;
+    if(chunk && chunk == slab->spare && chunk->next) {
+        chunk = chunk->next; // fill the used chunks, let the spare empty
+    }
+    if(!chunk) {
+        /*
+         *  New chunk: header and alignment pad, then the slots.
+         */
+        uint32_t n_slots = slab->next_chunk_slots;
+        if(n_slots > slab->max_chunk_slots) {
+            n_slots = slab->max_chunk_slots;
+        }
+        chunk = gbmem_malloc(
+            sizeof(sdata_chunk_t) + SDATA_SLAB_ALIGN + (size_t)slab->slot_size * n_slots
+        );
+        if(!chunk) {
+            return 0;
+        }
+        chunk->slab = slab;
+        chunk->n_slots = n_slots;
+        if(slab->next_chunk_slots < slab->max_chunk_slots) {
+            slab->next_chunk_slots *= 2;
+        }
+
+        char *first = (char *)(((uintptr_t)(chunk + 1) + SDATA_SLAB_ALIGN - 1) &
+            ~(uintptr_t)(SDATA_SLAB_ALIGN - 1));
+        for(int i=(int)n_slots-1; i>=0; i--) {
+            char *slot = first + (size_t)i * slab->slot_size;
+            *(void **)slot = chunk->free_slots;
+            chunk->free_slots = slot;
+        }
+        slab_link_chunk(slab, chunk);
+    }
+    if(chunk == slab->spare) {
+        slab->spare = 0;
+    }
+
+    SData_t *sdata = chunk->free_slots;
+    chunk->free_slots = *(void **)sdata;
+    if(!chunk->free_slots) {
+        slab_unlink_chunk(slab, chunk);
+    }
+    memset(sdata, 0, slab->slot_size);
+    chunk->n_alive++;
+    slab->n_alive++;
+    *pchunk = chunk;
+    return sdata;
+}
+
+/***************************************************************************
+ *  Free the slab and its chunks, all their slots must be free.
+ ***************************************************************************/
+PRIVATE void slab_free(sdata_slab_t *slab)
+{
+    sdata_chunk_t *chunk = slab->chunks;
+    while(chunk) {
+        sdata_chunk_t *next = chunk->next;
+        gbmem_free(chunk);
+        chunk = next;
+    }
+    gbmem_free(slab);
+}
+
+/***************************************************************************
+ *  Return the slot to its chunk, and the empty chunk to gbmem
+ ***************************************************************************/
+PRIVATE void slab_release(sdata_chunk_t *chunk, SData_t *sdata)
+{
+    sdata_slab_t *slab = chunk->slab;
+
+    if(!chunk->free_slots) {
+        slab_link_chunk(slab, chunk);
+    }
+    *(void **)sdata = chunk->free_slots;
+    chunk->free_slots = sdata;
+    chunk->n_alive--;
+    slab->n_alive--;
+
+    if(!chunk->n_alive) {
+        if(slab->spare || slab->orphan || chunk->n_slots < slab->max_chunk_slots) {
+            slab_unlink_chunk(slab, chunk);
+            gbmem_free(chunk);
+        } else {
+            slab->spare = chunk;
+        }
+        if(!slab->n_alive && !slab->spare) {
+            slab->next_chunk_slots = SDATA_SLAB_MIN_SLOTS; // start small again
+        }
+    }
+    if(slab->orphan && !slab->n_alive) {
+        slab_free(slab);
+    }
+}
+
+/***************************************************************************
+ *  Alloc a record of the schema with its internal buffer,
+ *  in a slot of the schema slab, or alone if there is no slab.
+ ***************************************************************************/
+PRIVATE SData_t *sdata_alloc(const sdata_desc_t *schema)
+{
+    SData_t sizing = {0};
+    sizing.items = schema;
+    uint32_t total_size = calculate_size(&sizing, 0); // idempotent.
+
+    sdata_slab_t *slab = schema_slab_get(schema, total_size);
+    if(slab) {
+        sdata_chunk_t *chunk;
+        SData_t *sdata = slab_alloc(slab, &chunk);
+        if(sdata) {
+            sdata->_chunk = chunk;
+            sdata->items = schema;
+            sdata->_total_size = total_size;
+            if(total_size) {
+                sdata->_bf = (char *)sdata + SDATA_HEADER_SIZE;
+            }
+            return sdata;
+        }
+    }
+
+    SData_t *sdata = gbmem_malloc(sizeof(SData_t));
+    if(!sdata) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for sdata",
+            "size",         "%d", sizeof(SData_t),
+            NULL
+        );
+        return 0;
+    }
+    sdata->items = schema;
+    sdata->_total_size = total_size;
+
+    if(sdata->_total_size) {
+        sdata->_bf = gbmem_malloc(sdata->_total_size);
+        if(!sdata->_bf) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for bf",
+                "size",         "%d", sdata->_total_size,
+                NULL
+            );
+            GBMEM_FREE(sdata);
+            return 0;
+        }
+    }
+    return sdata;
+}
+
+/***************************************************************************
+ *  Free the name index and the slab of a schema,
+ *  before freeing (or reusing the memory of) a dynamic schema.
+ *  A slab with live records is freed when its last record is destroyed.
+ ***************************************************************************/
+PUBLIC void sdata_forget_schema(const sdata_desc_t *schema)
+{
+    if(!__schema_indexes__ || !schema) {
+        return;
+    }
+    uint32_t i = pointer_hash(schema) & __schema_indexes_mask__;
+    while(__schema_indexes__[i].schema != schema) {
+        if(!__schema_indexes__[i].schema) {
+            return;
+        }
+        i = (i + 1) & __schema_indexes_mask__;
+    }
+
+    GBMEM_FREE(__schema_indexes__[i].slots);
+    sdata_slab_t *slab = __schema_indexes__[i].slab;
+    if(slab) {
+        if(slab->n_alive) {
+            slab->orphan = TRUE;
+        } else {
+            slab_free(slab);
+        }
+    }
+    memset(&__schema_indexes__[i], 0, sizeof(schema_index_t));
+    __schema_indexes_used__--;
+
+    /*
+     *  Backward shift of the next slots of the cluster
+     */
+    uint32_t mask = __schema_indexes_mask__;
+    uint32_t j = (i + 1) & mask;
+    while(__schema_indexes__[j].schema) {
+        uint32_t home = pointer_hash(__schema_indexes__[j].schema) & mask;
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            __schema_indexes__[i] = __schema_indexes__[j];
+            memset(&__schema_indexes__[j], 0, sizeof(schema_index_t));
+            i = j;
+        }
+        j = (j + 1) & mask;
+    }
+}
+
+/***************************************************************************
+ *  Free the name indexes and the slabs of the schemas.
+ *  A slab with live records is freed when its last record is destroyed.
+ ***************************************************************************/
+PUBLIC void sdata_free_schema_indexes(void)
+{
+    for(uint32_t j=0; __schema_indexes__ && j<=__schema_indexes_mask__; j++) {
+        GBMEM_FREE(__schema_indexes__[j].slots);
+        sdata_slab_t *slab = __schema_indexes__[j].slab;
+        if(slab) {
+            if(slab->n_alive) {
+                slab->orphan = TRUE;
+            } else {
+                slab_free(slab);
+            }
+        }
+    }
+    GBMEM_FREE(__schema_indexes__);
+    __schema_indexes_mask__ = 0;
+    __schema_indexes_used__ = 0;
+}
+
 /***************************************************************************
  *  Get the idx of item in schema.
  *  Relative to 1
@@ -371,6 +836,7 @@ PRIVATE void clear_value(SData_t *sdata, const sdata_desc_t *it)
     }
 
     if(ASN_IS_ITER(it->type)) {
+        sdata_iter_pkey_index_free(ptr);
         if(rc_iter_size(ptr)>0) {
             rc_free_iter(ptr, FALSE, it->free_fn);
         }
@@ -453,6 +919,7 @@ PRIVATE void set_default(SData_t *sdata, const sdata_desc_t *it, void *value)
                 NULL
             );
         }
+        sdata_iter_pkey_index_free(ptr);
         rc_init_iter(ptr);
     } else if(ASN_IS_DL_LIST(it->type)) {
         if(dl_size(ptr)) {
@@ -536,6 +1003,42 @@ PUBLIC const char * sdata_resource(hsdata hs)
     return sdata->resource;
 }
 
+/***************************************************************************
+ *  Set/reset read-only: the writes are rejected (logged, return -1)
+ ***************************************************************************/
+PUBLIC void sdata_set_read_only(hsdata hs, BOOL read_only)
+{
+    SData_t *sdata = hs;
+    if(!sdata) {
+        return;
+    }
+    if(read_only) {
+        sdata->_flag |= _FLAG_READ_ONLY;
+    } else {
+        sdata->_flag &= ~_FLAG_READ_ONLY;
+    }
+}
+
+/***************************************************************************
+ *  Set the user data of the callbacks
+ ***************************************************************************/
+PUBLIC void sdata_set_user_data(hsdata hs, void *user_data)
+{
+    SData_t *sdata = hs;
+    if(sdata) {
+        sdata->user_data = user_data;
+    }
+}
+
+/***************************************************************************
+ *  Get the user data of the callbacks
+ ***************************************************************************/
+PUBLIC void *sdata_user_data(hsdata hs)
+{
+    SData_t *sdata = hs;
+    return sdata? sdata->user_data : 0;
+}
+
 /***************************************************************************
  * Return sdata table describing the resource
  ***************************************************************************/
@@ -668,6 +1171,19 @@ PUBLIC const sdata_desc_t * sdata_it_desc(const sdata_desc_t *schema, const char
         return 0;
     }
 
+    schema_index_t *index = schema_index_get(schema);
+    if(index) {
+        uint32_t i = name_hash(name) & index->mask;
+        while(index->slots[i]) {
+            const sdata_desc_t *it = &schema[index->slots[i] - 1];
+            if(strcasecmp(it->name, name)==0) {
+                return it;
+            }
+            i = (i + 1) & index->mask;
+        }
+        return 0;
+    }
+
     const sdata_desc_t *it = schema;
     while(it->name) {
         if(strcasecmp(it->name, name)==0) {
@@ -843,16 +1359,37 @@ PUBLIC int sdata_write_by_type(
     SData_t *sdata = hs;
     SData_Value_t old_value = {0};
 
-    if(ASN_IS_STRING(it->type)) {
-        char **s = ptr;
-        char *new_s = 0;
-        if(value.s) {
-            new_s = gbmem_strdup(value.s);
-        }
-        if(*s) {
-            gbmem_free(*s);
-            *s = 0;
-        }
+    if((sdata->_flag & _FLAG_READ_ONLY) && !IS_DESTROYING(sdata)) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_OPERATIONAL_ERROR,
+            "msg",          "%s", "sdata is read-only",
+            "name",         "%s", it->name,
+            NULL
+        );
+        return -1;
+    }
+
+    /*
+     *  The pkey indexes are hashed by the pkey value: rekey the row.
+     */
+    BOOL rekey = FALSE;
+    if((it->flag & SDF_PKEY) && __pkey_indexes_used__ && !IS_DESTROYING(sdata)) {
+        pkey_indexes_unlink(hs, it, TRUE);
+        rekey = TRUE;
+    }
+
+    if(ASN_IS_STRING(it->type)) {
+        char **s = ptr;
+        char *new_s = 0;
+        if(value.s) {
+            new_s = gbmem_strdup(value.s);
+        }
+        if(*s) {
+            gbmem_free(*s);
+            *s = 0;
+        }
         *s = new_s;
     } else if(ASN_IS_JSON(it->type)) {
         json_t **jn = ptr;
@@ -931,9 +1468,16 @@ PUBLIC int sdata_write_by_type(
             "it->type",     "%d", it->type,
             NULL
         );
+        if(rekey) {
+            pkey_indexes_relink(hs);
+        }
         return -1;
     }
 
+    if(rekey) {
+        pkey_indexes_relink(hs);
+    }
+
     if(!IS_DESTROYING(sdata)) {
         if(sdata->post_write_cb) {
             sdata->post_write_cb(sdata->user_data, it->name);
@@ -1869,6 +2413,7 @@ PUBLIC dl_list_t * sdata_sort_iter_by_id(
         rc_add_instance(new_iter, *(keys + i), 0);
     }
 
+    sdata_iter_pkey_index_free(iter);
     rc_free_iter(iter, TRUE, 0);
     gbmem_free(keys);
     return new_iter;
@@ -2311,15 +2856,15 @@ PRIVATE int _sdata_compare_value(
     int type = it->type;
 
     if(ASN_IS_STRING(type)) {
-        return strcasecmp(v->s, pkey);
+        return strcasecmp(v->s?v->s:"", pkey);
     } else if(ASN_IS_SIGNED32(type)) {
-        return (v->i32==atoi(pkey))?0:-1; // TODO return like strcmp
+        return (v->i32==(int32_t)strtoll(pkey, 0, 10))?0:-1; // TODO return like strcmp
     } else if(ASN_IS_UNSIGNED32(type)) {
-        return (v->u32==atoi(pkey))?0:-1; // TODO return like strcmp
+        return (v->u32==(uint32_t)strtoll(pkey, 0, 10))?0:-1; // TODO return like strcmp
     } else if(ASN_IS_SIGNED64(type)) {
-        return (v->i64==atoi(pkey))?0:-1; // TODO return like strcmp
+        return (v->i64==(int64_t)strtoll(pkey, 0, 10))?0:-1; // TODO return like strcmp
     } else if(ASN_IS_UNSIGNED64(type)) {
-        return (v->u64==atoi(pkey))?0:-1; // TODO return like strcmp
+        return (v->u64==(uint64_t)strtoull(pkey, 0, 10))?0:-1; // TODO return like strcmp
     } else if(type == ASN_FLOAT) {
         return (v->f==atof(pkey))?0:-1; // TODO return like strcmp
     } else if(type == ASN_DOUBLE) {
@@ -2338,11 +2883,452 @@ PRIVATE int _sdata_compare_value(
     }
 }
 
+/***************************************************************************
+ *  Normalize the primary key `pkey` to the type of the pkey item,
+ *  as _sdata_compare_value() does.
+ ***************************************************************************/
+PRIVATE SData_Value_t pkey_str2value(int type, const char *pkey)
+{
+    SData_Value_t v = {0};
+
+    if(ASN_IS_STRING(type)) {
+        v.s = (char *)pkey;
+    } else if(ASN_IS_SIGNED32(type)) {
+        v.i32 = (int32_t)strtoll(pkey, 0, 10);
+    } else if(ASN_IS_UNSIGNED32(type)) {
+        v.u32 = (uint32_t)strtoll(pkey, 0, 10);
+    } else if(ASN_IS_SIGNED64(type)) {
+        v.i64 = (int64_t)strtoll(pkey, 0, 10);
+    } else if(ASN_IS_UNSIGNED64(type)) {
+        v.u64 = (uint64_t)strtoull(pkey, 0, 10);
+    } else if(type == ASN_FLOAT || type == ASN_DOUBLE) {
+        v.f = atof(pkey);
+    }
+    return v;
+}
+
+/***************************************************************************
+ *  Hash of a normalized primary key value
+ ***************************************************************************/
+PRIVATE uint32_t pkey_value_hash(int type, const SData_Value_t *v)
+{
+    uint64_t x;
+
+    if(ASN_IS_STRING(type)) {
+        return name_hash(v->s?v->s:""); // case-insensitive, like strcasecmp
+    } else if(ASN_IS_SIGNED32(type)) {
+        x = (uint64_t)(int64_t)v->i32;
+    } else if(ASN_IS_UNSIGNED32(type)) {
+        x = v->u32;
+    } else if(ASN_IS_SIGNED64(type)) {
+        x = (uint64_t)v->i64;
+    } else if(ASN_IS_UNSIGNED64(type)) {
+        x = v->u64;
+    } else if(type == ASN_FLOAT || type == ASN_DOUBLE) {
+        double f = v->f;
+        if(f == 0) {
+            f = 0; // -0.0 == 0.0
+        }
+        memcpy(&x, &f, sizeof(x));
+    } else {
+        return 0;
+    }
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (uint32_t)x;
+}
+
+/***************************************************************************
+ *  Compare two normalized primary key values
+ ***************************************************************************/
+PRIVATE BOOL pkey_value_equal(int type, const SData_Value_t *v1, const SData_Value_t *v2)
+{
+    if(ASN_IS_STRING(type)) {
+        return strcasecmp(v1->s?v1->s:"", v2->s?v2->s:"")==0? TRUE : FALSE;
+    } else if(ASN_IS_SIGNED32(type)) {
+        return v1->i32 == v2->i32;
+    } else if(ASN_IS_UNSIGNED32(type)) {
+        return v1->u32 == v2->u32;
+    } else if(ASN_IS_SIGNED64(type)) {
+        return v1->i64 == v2->i64;
+    } else if(ASN_IS_UNSIGNED64(type)) {
+        return v1->u64 == v2->u64;
+    } else if(type == ASN_FLOAT || type == ASN_DOUBLE) {
+        return v1->f == v2->f;
+    }
+    return FALSE;
+}
+
+/***************************************************************************
+ *  Return the pkey index of the iter, 0 if it has not.
+ ***************************************************************************/
+PRIVATE pkey_index_t *pkey_index_get(dl_list_t *iter)
+{
+    if(!__pkey_indexes__) {
+        return 0;
+    }
+    uint32_t i = pointer_hash(iter) & __pkey_indexes_mask__;
+    while(__pkey_indexes__[i]) {
+        if(__pkey_indexes__[i]->iter == iter) {
+            return __pkey_indexes__[i];
+        }
+        i = (i + 1) & __pkey_indexes_mask__;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Insert the row in the pkey index, if its pkey is not already there.
+ ***************************************************************************/
+PRIVATE int pkey_index_insert(pkey_index_t *index, hsdata hs)
+{
+    SData_Value_t v;
+    const sdata_desc_t *it = _row_pkey(hs, &v);
+    if(!it) {
+        // Error already logged
+        return -1;
+    }
+    if(!index->type) {
+        index->type = it->type;
+    }
+
+    if(!index->entries || (index->used + 1) * 2 > index->mask + 1) {
+        uint32_t new_size = index->entries? (index->mask + 1) * 2 : 64;
+        pkey_entry_t *new_entries = gbmem_malloc(sizeof(pkey_entry_t) * new_size);
+        if(!new_entries) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for pkey index",
+                "size",         "%d", (int)new_size,
+                NULL
+            );
+            return -1;
+        }
+        for(uint32_t j=0; index->entries && j<=index->mask; j++) {
+            if(index->entries[j].hs) {
+                uint32_t i = index->entries[j].hash & (new_size - 1);
+                while(new_entries[i].hs) {
+                    i = (i + 1) & (new_size - 1);
+                }
+                new_entries[i] = index->entries[j];
+            }
+        }
+        GBMEM_FREE(index->entries);
+        index->entries = new_entries;
+        index->mask = new_size - 1;
+    }
+
+    uint32_t hash = pkey_value_hash(it->type, &v);
+    uint32_t i = hash & index->mask;
+    while(index->entries[i].hs) {
+        if(index->entries[i].hs == hs) {
+            return 0;
+        }
+        if(index->entries[i].hash == hash) {
+            SData_Value_t v2;
+            const sdata_desc_t *it2 = _row_pkey(index->entries[i].hs, &v2);
+            if(it2 && pkey_value_equal(it->type, &v, &v2)) {
+                return 0; // the first one wins, like the linear search
+            }
+        }
+        i = (i + 1) & index->mask;
+    }
+    index->entries[i].hash = hash;
+    index->entries[i].hs = hs;
+    index->used++;
+    return 0;
+}
+
+/***************************************************************************
+ *  Build a pkey index for the iter: hash of the normalized SDF_PKEY value
+ *  to the row. sdata_iter_search_by_pkey() will use it.
+ *  Use sdata_iter_add()/sdata_iter_remove() to keep it updated,
+ *  the writes of the pkey item and sdata_destroy() update it too.
+ ***************************************************************************/
+PUBLIC int sdata_iter_pkey_index(dl_list_t *iter)
+{
+    if(!iter) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "iter NULL",
+            NULL
+        );
+        return -1;
+    }
+    if(pkey_index_get(iter)) {
+        return 0;
+    }
+
+    if(!__pkey_indexes__ || (__pkey_indexes_used__ + 1) * 2 > __pkey_indexes_mask__ + 1) {
+        uint32_t new_size = __pkey_indexes__? (__pkey_indexes_mask__ + 1) * 2 : 16;
+        pkey_index_t **new_indexes = gbmem_malloc(sizeof(pkey_index_t *) * new_size);
+        if(!new_indexes) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for pkey indexes",
+                NULL
+            );
+            return -1;
+        }
+        for(uint32_t j=0; __pkey_indexes__ && j<=__pkey_indexes_mask__; j++) {
+            if(__pkey_indexes__[j]) {
+                uint32_t i = pointer_hash(__pkey_indexes__[j]->iter) & (new_size - 1);
+                while(new_indexes[i]) {
+                    i = (i + 1) & (new_size - 1);
+                }
+                new_indexes[i] = __pkey_indexes__[j];
+            }
+        }
+        GBMEM_FREE(__pkey_indexes__);
+        __pkey_indexes__ = new_indexes;
+        __pkey_indexes_mask__ = new_size - 1;
+    }
+
+    pkey_index_t *index = gbmem_malloc(sizeof(pkey_index_t));
+    if(!index) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for pkey index",
+            NULL
+        );
+        return -1;
+    }
+    index->iter = iter;
+
+    hsdata hs; rc_instance_t *i_hs;
+    i_hs = rc_first_instance(iter, (rc_resource_t **)&hs);
+    while(i_hs) {
+        pkey_index_insert(index, hs);
+        i_hs = rc_next_instance(i_hs, (rc_resource_t **)&hs);
+    }
+
+    uint32_t i = pointer_hash(iter) & __pkey_indexes_mask__;
+    while(__pkey_indexes__[i]) {
+        i = (i + 1) & __pkey_indexes_mask__;
+    }
+    __pkey_indexes__[i] = index;
+    __pkey_indexes_used__++;
+    return 0;
+}
+
+/***************************************************************************
+ *  Free the pkey index of the iter, if it has.
+ *  Call it before rc_free_iter(), the sdata iter items free it themselves.
+ ***************************************************************************/
+PUBLIC void sdata_iter_pkey_index_free(dl_list_t *iter)
+{
+    if(!__pkey_indexes__) {
+        return;
+    }
+    uint32_t mask = __pkey_indexes_mask__;
+    uint32_t i = pointer_hash(iter) & mask;
+    while(__pkey_indexes__[i]) {
+        if(__pkey_indexes__[i]->iter == iter) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    pkey_index_t *index = __pkey_indexes__[i];
+    if(!index) {
+        return;
+    }
+    GBMEM_FREE(index->entries);
+    gbmem_free(index);
+    __pkey_indexes__[i] = 0;
+    __pkey_indexes_used__--;
+
+    /*
+     *  Backward shift of the next slots of the cluster
+     */
+    uint32_t j = (i + 1) & mask;
+    while(__pkey_indexes__[j]) {
+        uint32_t home = pointer_hash(__pkey_indexes__[j]->iter) & mask;
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            __pkey_indexes__[i] = __pkey_indexes__[j];
+            __pkey_indexes__[j] = 0;
+            i = j;
+        }
+        j = (j + 1) & mask;
+    }
+
+    if(!__pkey_indexes_used__) {
+        GBMEM_FREE(__pkey_indexes__);
+        __pkey_indexes_mask__ = 0;
+    }
+}
+
+/***************************************************************************
+ *  Add the row to the iter, updating the pkey index if the iter has.
+ ***************************************************************************/
+PUBLIC int sdata_iter_add(dl_list_t *iter, hsdata hs)
+{
+    rc_add_instance(iter, hs, 0);
+    pkey_index_t *index = pkey_index_get(iter);
+    if(index) {
+        return pkey_index_insert(index, hs);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Delete the row from the pkey index, `hash` is the hash of its pkey.
+ *  Return TRUE if it was indexed.
+ ***************************************************************************/
+PRIVATE BOOL pkey_index_delete(pkey_index_t *index, uint32_t hash, hsdata hs)
+{
+    if(!index->entries) {
+        return FALSE;
+    }
+    uint32_t mask = index->mask;
+    uint32_t i = hash & mask;
+    while(index->entries[i].hs) {
+        if(index->entries[i].hs == hs) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    if(!index->entries[i].hs) {
+        return FALSE;
+    }
+    index->entries[i].hs = 0;
+    index->entries[i].hash = 0;
+    index->used--;
+
+    /*
+     *  Backward shift of the next slots of the cluster
+     */
+    uint32_t j = (i + 1) & mask;
+    while(index->entries[j].hs) {
+        uint32_t home = index->entries[j].hash & mask;
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            index->entries[i] = index->entries[j];
+            index->entries[j].hs = 0;
+            index->entries[j].hash = 0;
+            i = j;
+        }
+        j = (j + 1) & mask;
+    }
+    return TRUE;
+}
+
+/***************************************************************************
+ *  Delete the row from all the pkey indexes, `it` is its SDF_PKEY item.
+ *  With `relink` the indexes remember it for pkey_indexes_relink().
+ ***************************************************************************/
+PRIVATE void pkey_indexes_unlink(hsdata hs, const sdata_desc_t *it, BOOL relink)
+{
+    if(!__pkey_indexes__) {
+        return;
+    }
+    void *ptr = item_pointer(hs, it);
+    if(!ptr) {
+        // Error already logged
+        return;
+    }
+    SData_Value_t v = sdata_read_by_type(hs, it, ptr);
+    uint32_t hash = pkey_value_hash(it->type, &v);
+
+    for(uint32_t i=0; i<=__pkey_indexes_mask__; i++) {
+        pkey_index_t *index = __pkey_indexes__[i];
+        if(index && pkey_index_delete(index, hash, hs) && relink) {
+            index->relink = hs;
+        }
+    }
+}
+
+/***************************************************************************
+ *  Insert again the row in the pkey indexes where it was unlinked.
+ ***************************************************************************/
+PRIVATE void pkey_indexes_relink(hsdata hs)
+{
+    for(uint32_t i=0; __pkey_indexes__ && i<=__pkey_indexes_mask__; i++) {
+        pkey_index_t *index = __pkey_indexes__[i];
+        if(index && index->relink == hs) {
+            index->relink = 0;
+            pkey_index_insert(index, hs);
+        }
+    }
+}
+
+/***************************************************************************
+ *  Remove the row from the pkey index of the iter, if the iter has.
+ *  Call it before removing the row from the iter.
+ ***************************************************************************/
+PUBLIC int sdata_iter_pkey_remove(dl_list_t *iter, hsdata hs)
+{
+    pkey_index_t *index = pkey_index_get(iter);
+    if(!index || !index->entries) {
+        return 0;
+    }
+    SData_Value_t v;
+    const sdata_desc_t *it = _row_pkey(hs, &v);
+    if(!it) {
+        // Error already logged
+        return -1;
+    }
+    pkey_index_delete(index, pkey_value_hash(it->type, &v), hs);
+    return 0;
+}
+
+/***************************************************************************
+ *  Remove the row from the iter, updating the pkey index if the iter has.
+ *  The row is not destroyed.
+ ***************************************************************************/
+PUBLIC int sdata_iter_remove(dl_list_t *iter, hsdata hs)
+{
+    size_t idx;
+    rc_instance_t *i_hs = rc_instance_index(iter, hs, &idx);
+    if(!i_hs) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "row NOT FOUND in iter",
+            NULL
+        );
+        return -1;
+    }
+    sdata_iter_pkey_remove(iter, hs);
+    rc_delete_instance(i_hs, 0);
+    return 0;
+}
+
 /***************************************************************************
  *  Search and return the row of the `ht` table with a `v` primary key
+ *  Using the pkey index of the iter if it has.
  ***************************************************************************/
 PUBLIC hsdata sdata_iter_search_by_pkey(dl_list_t *iter, const char *pkey)
 {
+    pkey_index_t *index = pkey_index_get(iter);
+    if(index) {
+        if(!index->entries || !index->type) {
+            return 0;
+        }
+        SData_Value_t q = pkey_str2value(index->type, pkey);
+        uint32_t hash = pkey_value_hash(index->type, &q);
+        uint32_t i = hash & index->mask;
+        while(index->entries[i].hs) {
+            if(index->entries[i].hash == hash) {
+                SData_Value_t v;
+                const sdata_desc_t *it = _row_pkey(index->entries[i].hs, &v);
+                if(it && _sdata_compare_value(it, &v, pkey)==0) {
+                    return index->entries[i].hs;
+                }
+            }
+            i = (i + 1) & index->mask;
+        }
+        return 0;
+    }
+
     hsdata hs; rc_instance_t *i_hs;
     i_hs = rc_first_instance(iter, (rc_resource_t **)&hs);
     while(i_hs) {
@@ -2360,6 +3346,215 @@ PUBLIC hsdata sdata_iter_search_by_pkey(dl_list_t *iter, const char *pkey)
     return 0;
 }
 
+/***************************************************************************
+ *  Compare the value of an item with a filter value, like
+ *  cmp_two_simple_json() does with the item converted by item2json().
+ *  Return TRUE if equal.
+ ***************************************************************************/
+PRIVATE BOOL match_item_value(SData_t *sdata, const sdata_desc_t *it, json_t *jn_filter_value)
+{
+    void *ptr = item_pointer(sdata, it);
+    if(!ptr) {
+        // error already logged.
+        return FALSE;
+    }
+    int type = it->type;
+
+    if(ASN_IS_STRING(type)) {
+        if(json_is_string(jn_filter_value)) {
+            const char *s = sdata_read_by_type(sdata, it, ptr).s;
+            return strcmp(s?s:"", json_string_value(jn_filter_value))==0? TRUE : FALSE;
+        }
+
+    } else if(ASN_IS_JSON(type)) {
+        json_t *jn = sdata_read_by_type(sdata, it, ptr).j;
+        if(!jn) {
+            jn = json_null();
+        }
+        if(json_is_string(jn) && json_is_string(jn_filter_value)) {
+            return strcmp(json_string_value(jn), json_string_value(jn_filter_value))==0? TRUE : FALSE;
+        }
+        return cmp_two_simple_json(jn, jn_filter_value)==0? TRUE : FALSE;
+
+    } else if(ASN_IS_BOOLEAN(type)) {
+        if(json_is_boolean(jn_filter_value)) {
+            BOOL b = sdata_read_by_type(sdata, it, ptr).b;
+            return (b? TRUE : FALSE) == (json_is_true(jn_filter_value)? TRUE : FALSE);
+        }
+
+    } else if(ASN_IS_POINTER(type) || ASN_IS_NATURAL_NUMBER(type)) {
+        if(json_is_integer(jn_filter_value) || json_is_real(jn_filter_value)) {
+            SData_Value_t v = sdata_read_by_type(sdata, it, ptr);
+            json_int_t i;
+            if(ASN_IS_POINTER(type)) {
+                i = (json_int_t)(size_t)v.p;
+            } else if(ASN_IS_SIGNED32(type)) {
+                i = v.i32;
+            } else if(ASN_IS_UNSIGNED32(type)) {
+                i = v.u32;
+            } else if(ASN_IS_SIGNED64(type)) {
+                i = v.i64;
+            } else {
+                i = (json_int_t)v.u64;
+            }
+            if(json_is_integer(jn_filter_value)) {
+                return i == json_integer_value(jn_filter_value)? TRUE : FALSE;
+            }
+            return (double)i == json_real_value(jn_filter_value)? TRUE : FALSE;
+        }
+
+    } else if(ASN_IS_REAL_NUMBER(type)) {
+        if(json_is_real(jn_filter_value)) {
+            return sdata_read_by_type(sdata, it, ptr).f == json_real_value(jn_filter_value)? TRUE : FALSE;
+        }
+        if(json_is_integer(jn_filter_value)) {
+            return sdata_read_by_type(sdata, it, ptr).f ==
+                (double)json_integer_value(jn_filter_value)? TRUE : FALSE;
+        }
+    }
+
+    /*
+     *  Mixed types or iters: slow path, convert only this item.
+     */
+    json_t *jn = item2json(sdata, it->name, -1, 0);
+    BOOL matched = cmp_two_simple_json(jn, jn_filter_value)==0? TRUE : FALSE;
+    JSON_DECREF(jn);
+    return matched;
+}
+
+/***************************************************************************
+ *  Match a key of the filter, firstly by path, secondly the key as full key.
+ ***************************************************************************/
+PRIVATE BOOL match_item_key(
+    SData_t *sdata,
+    sdata_flag_t include_flag,
+    sdata_flag_t exclude_flag,
+    const char *key,
+    json_t *jn_filter_value)
+{
+    const sdata_desc_t *it;
+
+    const char *p = strchr(key, '`');
+    if(p) {
+        char name[128];
+        int ln = (int)(p - key);
+        if(ln < (int)sizeof(name)) {
+            memcpy(name, key, ln);
+            name[ln] = 0;
+            it = sdata_it_desc(sdata->items, name);
+            if(it && ASN_IS_JSON(it->type) &&
+                    !(exclude_flag && (it->flag & exclude_flag)) &&
+                    (include_flag == -1 || (it->flag & include_flag))) {
+                void *ptr = item_pointer(sdata, it);
+                json_t *jn = ptr? sdata_read_by_type(sdata, it, ptr).j : 0;
+                json_t *jn_record_value = jn? kw_get_dict_value(jn, p+1, 0, 0) : 0;
+                if(jn_record_value) {
+                    if(json_is_string(jn_record_value) && json_is_string(jn_filter_value)) {
+                        return strcmp(
+                            json_string_value(jn_record_value),
+                            json_string_value(jn_filter_value)
+                        )==0? TRUE : FALSE;
+                    }
+                    return cmp_two_simple_json(jn_record_value, jn_filter_value)==0? TRUE : FALSE;
+                }
+            }
+        }
+    }
+
+    it = sdata_it_desc(sdata->items, key);
+    if(!it) {
+        return FALSE;
+    }
+    if(exclude_flag && (it->flag & exclude_flag)) {
+        return FALSE;
+    }
+    if(!(include_flag == -1 || (it->flag & include_flag))) {
+        return FALSE;
+    }
+    return match_item_value(sdata, it, jn_filter_value);
+}
+
+/***************************************************************************
+ *  Match a filter level (_kw_match_simple semantic):
+ *      array:  OR of the items, empty is false.
+ *      object: AND of the keys, empty is false.
+ *              A complex value (array/object) is evaluated as a nested filter
+ *              and the next keys are ignored.
+ *      others: false.
+ ***************************************************************************/
+PRIVATE BOOL match_level(
+    SData_t *sdata,
+    sdata_flag_t include_flag,
+    sdata_flag_t exclude_flag,
+    json_t *jn_filter)
+{
+    if(json_is_array(jn_filter)) {
+        size_t idx;
+        json_t *jn_item;
+        json_array_foreach(jn_filter, idx, jn_item) {
+            if(match_level(sdata, include_flag, exclude_flag, jn_item)) {
+                return TRUE;
+            }
+        }
+        return FALSE;
+
+    } else if(json_is_object(jn_filter) && json_object_size(jn_filter)>0) {
+        const char *key;
+        json_t *jn_value;
+        json_object_foreach(jn_filter, key, jn_value) {
+            if(json_is_array(jn_value) || json_is_object(jn_value)) {
+                return match_level(sdata, include_flag, exclude_flag, jn_value);
+            }
+            if(!match_item_key(sdata, include_flag, exclude_flag, key, jn_value)) {
+                return FALSE;
+            }
+        }
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/***************************************************************************
+ *  Like kw_match_simple(sdata2json(hs), jn_filter) without converting to json:
+ *  only the items named in the filter are read.
+ ***************************************************************************/
+PRIVATE BOOL match_simple(
+    SData_t *sdata,
+    sdata_flag_t include_flag,
+    sdata_flag_t exclude_flag,
+    json_t *jn_filter) // not owned
+{
+    if(!jn_filter) {
+        return TRUE;
+    }
+    if(json_is_object(jn_filter)) {
+        if(json_object_size(jn_filter)==0) {
+            return TRUE;
+        }
+        return match_level(sdata, include_flag, exclude_flag, jn_filter);
+    }
+    if(json_is_array(jn_filter)) {
+        if(json_array_size(jn_filter)==0) {
+            return TRUE;
+        }
+        size_t idx;
+        json_t *jn_item;
+        json_array_foreach(jn_filter, idx, jn_item) {
+            if(json_is_object(jn_item)) {
+                if(match_level(sdata, include_flag, exclude_flag, jn_item)) {
+                    return TRUE;
+                }
+            } else if(json_is_array(jn_item)) {
+                if(match_simple(sdata, include_flag, exclude_flag, jn_item)) {
+                    return TRUE;
+                }
+            }
+        }
+    }
+    return FALSE;
+}
+
 /***************************************************************************
  *  Find the first resource matching the filter
  ***************************************************************************/
@@ -2375,17 +3570,13 @@ PUBLIC hsdata sdata_iter_find_one(
     hsdata hs; rc_instance_t *i_hs;
     i_hs = rc_first_instance(iter, (rc_resource_t **)&hs);
     while(i_hs) {
-        json_t *jn_data = sdata2json(hs, -1, 0);
-        JSON_INCREF(jn_filter);
-        if(kw_match_simple(jn_data, jn_filter)) {
+        if(match_simple(hs, -1, 0, jn_filter)) {
             if(i_hs_) {
                 *i_hs_ = i_hs;
             }
             JSON_DECREF(jn_filter);
-            JSON_DECREF(jn_data);
             return hs;
         }
-        JSON_DECREF(jn_data);
         i_hs = rc_next_instance(i_hs, (rc_resource_t **)&hs);
     }
     JSON_DECREF(jn_filter);
@@ -2395,7 +3586,8 @@ PUBLIC hsdata sdata_iter_find_one(
 /***************************************************************************
  *  Return TRUE if all keys in jn_filter dict match with sdata's key
  *  Only compare str/int/real/bool items
- *  If match_fn is null then kw_match_simple() is used
+ *  If match_fn is null then kw_match_simple() is used,
+ *  natively, without converting the sdata to json.
  ***************************************************************************/
 PUBLIC BOOL sdata_match(
     hsdata hs,
@@ -2408,8 +3600,10 @@ PUBLIC BOOL sdata_match(
     )
 )
 {
-    if(!match_fn) {
-        match_fn = kw_match_simple;
+    if(!match_fn || match_fn == kw_match_simple) {
+        BOOL matched = match_simple(hs, include_flag, exclude_flag, jn_filter);
+        JSON_DECREF(jn_filter);
+        return matched;
     }
 
     json_t *kw = sdata2json(hs, include_flag, exclude_flag);
@@ -2437,9 +3631,6 @@ PUBLIC dl_list_t * sdata_iter_match(
     )
 )
 {
-    if(!match_fn) {
-        match_fn = kw_match_simple;
-    }
     // Return always an iter, although empty.
     dl_list_t *user_iter = rc_init_iter(0);
 
@@ -2583,6 +3774,16 @@ PUBLIC int sdata_iter_load_persistent(
         return -1;
     }
 
+    /*
+     *  Index the pkeys while loading, if the iter has not its own index.
+     */
+    BOOL temp_index = FALSE;
+    if(!pkey_index_get(iter) && rc_iter_size(iter) > 8) {
+        if(sdata_iter_pkey_index(iter)==0) {
+            temp_index = TRUE;
+        }
+    }
+
     const char *pkey;
     json_t *value;
     json_object_foreach(jn_dict, pkey, value) {
@@ -2593,6 +3794,9 @@ PUBLIC int sdata_iter_load_persistent(
         json2sdata(hsrow, value, SDF_PERSIST, not_found_cb, user_data);
     }
 
+    if(temp_index) {
+        sdata_iter_pkey_index_free(iter);
+    }
     JSON_DECREF(jn_dict);
     return 0;
 }
@@ -2672,7 +3876,7 @@ PRIVATE hsdata iter_load_from_dict(
         0,
         0
     );
-    rc_add_instance(iter, hsrow, 0);
+    sdata_iter_add(iter, hsrow);
 
     /*
      *  Check required attributes.
@@ -397,6 +397,9 @@ PUBLIC void sdata_destroy(hsdata hs);  // Compatible free(), no puede retornar i
  *----------------------------------*/
 
 PUBLIC const char * sdata_resource(hsdata hs);
+PUBLIC void sdata_set_read_only(hsdata hs, BOOL read_only); // writes rejected, except in destroy
+PUBLIC void sdata_set_user_data(hsdata hs, void *user_data); // user_data of the callbacks
+PUBLIC void *sdata_user_data(hsdata hs);
 
 /*
  *  Return sdata desc describing resource.
@@ -414,6 +417,18 @@ PUBLIC json_t *schema2json(
 
 PUBLIC const sdata_desc_t* sdata_schema(hsdata hs);
 PUBLIC const sdata_desc_t * sdata_it_desc(const sdata_desc_t *schema, const char *name);
+/*
+ *  Name lookups use a hash index by schema, built the first time the schema is used
+ *  (sdata_it_desc() too: the lookups are not thread-safe, like the rest of sdata).
+ *  The records of a schema are allocated in a slab of the schema (header and buffer together),
+ *  in gbmem chunks, starting with a few slots and doubling up to 64KB,
+ *  that are returned when all their records are destroyed.
+ *  The index is keyed on the schema pointer:
+ *  a dynamic schema must be forgotten before freeing it (or reusing its memory),
+ *  free all the indexes and slabs at end.
+ */
+PUBLIC void sdata_forget_schema(const sdata_desc_t *schema);
+PUBLIC void sdata_free_schema_indexes(void);
 
 
 /*----------------------------------*
@@ -605,6 +620,26 @@ PUBLIC int json2sdata_iter(
 /*---------------------------------*
  *      Search/Match functions
  *---------------------------------*/
+/*
+ *  Search the row with the primary key (SDF_PKEY item) `pkey`.
+ *  Linear search, or hash search if the iter has a pkey index.
+ */
+PUBLIC hsdata sdata_iter_search_by_pkey(dl_list_t *iter, const char *pkey);
+
+/*
+ *  Pkey index of an iter: hash of the normalized pkey value to the row.
+ *  Add the rows with sdata_iter_add() and remove them with sdata_iter_remove().
+ *  Writing the pkey item rekeys the row, sdata_destroy() unindexes it.
+ *  Free the index before rc_free_iter() of an own iter,
+ *  the iter items of sdata free it when cleared.
+ *  Duplicated pkeys: the first row wins, like the linear search.
+ */
+PUBLIC int sdata_iter_pkey_index(dl_list_t *iter);
+PUBLIC void sdata_iter_pkey_index_free(dl_list_t *iter);
+PUBLIC int sdata_iter_add(dl_list_t *iter, hsdata hs); // rc_add_instance() updating the pkey index
+PUBLIC int sdata_iter_remove(dl_list_t *iter, hsdata hs); // remove from iter, not destroyed
+PUBLIC int sdata_iter_pkey_remove(dl_list_t *iter, hsdata hs); // only from the pkey index
+
 /*
  *  Find the first resource matching the filter
  */
@@ -615,8 +650,9 @@ PUBLIC hsdata sdata_iter_find_one(
 );
 
 /*
- *  Return iter with matched resources (free with with rc_free_iter(iter, TRUE, 0);)
- *  If match_fn is null then kw_match_simple() is used
+ *  Return TRUE if the resource match the filter.
+ *  If match_fn is null (or kw_match_simple) the sdata values are compared natively,
+ *  without converting the resource to json, else match_fn(sdata2json(hs), jn_filter) is used.
  */
 PUBLIC BOOL sdata_match(
     hsdata hs,
@@ -44,6 +44,7 @@
 #else
 	#include <unistd.h>
 	#include <strings.h>
+	#include <sched.h>
 	#include <sys/utsname.h>
 #endif
 #include "10_gobj.h"
@@ -134,6 +135,44 @@ typedef struct {
     int8_t last_state;
 } SMachine_t;
 
+/*
+ *  Compiled fsm, one per gclass.
+ *  The event is located with one hash lookup (case-insensitive) over input_events,
+ *  and the action with one index into the dense [state][event] array.
+ */
+typedef struct {
+    const EV_ACTION *ev_action; // 0 if the event is not accepted in this state
+    int next_state;             // index of next state, -1 if none or unknown
+} fsm_cell_t;
+
+typedef struct {
+    const FSM *fsm;             // fsm compiled, must match the mach->fsm to be used.
+    int n_states;
+    int n_events;
+    uint32_t hash_mask;
+    int *hash_slots;            // index of input event + 1, 0 is free slot
+    int *atom_slots;            // index of input event + 1 by atom, 0 is free slot
+    event_id_t *event_ids;      // atom of input events
+    fsm_cell_t *cells;          // n_states * n_events
+    struct _latency_histogram_t **latency; // n_states * n_events, created on first use
+    fsm_dispatcher_fn dispatcher; // generated dispatcher, verified against cells
+} fsm_table_t;
+
+/*
+ *  Histogram of action latencies, log-linear with fixed buckets:
+ *  16 linear sub-buckets by each power of two (error < 6.25%), up to 2^40 ns.
+ */
+#define LATENCY_SUB_BITS    4
+#define LATENCY_SUB_COUNT   (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_EXP     40
+#define LATENCY_BUCKETS     ((LATENCY_MAX_EXP - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+
+typedef struct _latency_histogram_t {
+    uint64_t count;
+    uint64_t max_ns;
+    uint32_t buckets[LATENCY_BUCKETS];
+} latency_histogram_t;
+
 /*
  *
  */
@@ -198,8 +237,219 @@ typedef struct _GObj_t {
     char oid_changed;
     uint32_t __gobj_trace_level__;
     uint32_t __gobj_no_trace_level__;
+    uint32_t __trace_mask__;        // cached effective gobj_trace_level()
+    uint32_t __no_trace_mask__;     // cached effective gobj_no_trace_level()
+    uint32_t __trace_flags__;       // cached TRACE_FLAG_MACHINE_* (see refresh_trace_masks)
+    uint32_t __trace_generation__;  // __trace_generation__ of cached masks, 0 = stale
+    uint32_t __posted_events__; // events in the yuno's queue with this gobj as dst or src
+    uint64_t __instance_id__;   // unique in the yuno, never reused (see gobj_instance_id())
+    struct _subs_index_t *subs_index; // dl_subscriptions indexed by event, created on demand
+    struct _state_listener_t *state_listeners;
+    int n_state_listeners;
+    struct _publish_stats_t *publish_stats;     // open addressing by event_id, created on first publication
+    uint32_t n_publish_stats;
+    uint32_t publish_stats_mask;                // slots - 1
 } GObj_t;
 
+/*
+ *  Subscription __filter__ compiled at subscribe time,
+ *  with the kw_match_simple() semantic.
+ *  The nodes are in prefix order, `size` is the number of nodes of the subtree.
+ */
+typedef enum {
+    FILTER_OP_FALSE = 0,
+    FILTER_OP_TRUE,
+    FILTER_OP_ANY,              // OR of the children
+    FILTER_OP_ALL,              // AND of the children
+    FILTER_OP_EQUAL,            // kw value equal to the constant
+} filter_op_t;
+
+typedef struct {
+    filter_op_t op;
+    int size;
+    char *key;                  // owned
+    BOOL is_path;               // key with path delimiter, resolve with kw_get_dict_value()
+    json_t *value;              // constant, owned reference
+    json_type type;             // type of the constant
+} filter_node_t;
+
+typedef struct {
+    int n;
+    int size;
+    filter_node_t *nodes;
+} filter_prog_t;
+
+/*
+ *  Publish plan, resolved at subscribe time:
+ *  the per subscription steps applied to the kw before to send it.
+ */
+typedef json_t * (*trans_filter_fn)(json_t *kw);
+
+typedef struct {
+    int n_local_keys;
+    char **local_keys;          // keys to remove (__local__), owned
+    json_t *global_overlay;     // dict to update the kw (__global__), owned reference
+    json_t *jn_trans_filters;   // __config__`__trans_filter__, owned reference
+    uint32_t trans_generation;  // generation of the resolved trans_fns
+    int n_trans_fns;
+    trans_filter_fn *trans_fns;
+} publish_plan_t;
+
+/*
+ *  Coalescing/rate limit of a subscription (__coalesce_ms__, __max_rate__).
+ *  Only the latest kw by event is kept, delivered by a core's libuv timer.
+ */
+typedef struct {
+    event_id_t event_id;
+    json_t *kw;
+} throttle_pending_t;
+
+typedef struct _subs_throttle_t {
+    uv_timer_t timer;                   // timer.data is the throttle
+    BOOL timer_init;                    // timer created, on the first throttled publication
+    struct _subscription_t *sub;        // 0 when the subscription is gone (closing)
+    struct _GObj_t *publisher;
+    uint64_t interval_ms;
+    BOOL leading;                       // deliver at once if the interval is elapsed (__max_rate__)
+    uint64_t last_delivery;             // loop time of the last delivery
+    int n_pending;
+    int size_pending;
+    throttle_pending_t *pending;
+} subs_throttle_t;
+
+/*
+ *  Native subscription record, used in the publishing.
+ *  The hsdata of subscription_desc is kept as the public view (handle)
+ *  of the subscription: rc iters, gobj_find_subscriptions(), mt_subscription_*().
+ *  The view is read-only once subscribed (mt_subscription_added() can still write it,
+ *  the record is reloaded on each write), so the strings and jsons
+ *  point to the view's ones, don't free them.
+ *  __config__, __global__ and __local__ are only read when loading.
+ */
+typedef struct _subscription_t {
+    hsdata subs;                // compat view, its user_data is the record
+    uint64_t seq;               // subscription order
+    struct _GObj_t *subscriber;
+    event_id_t event_id;        // 0 catch-all (empty event) or pattern
+    const char *event;          // subscribed event, "" catch-all
+    const char *pattern;        // event pattern (prefix or glob), 0 if not a pattern (is event)
+    struct _subs_bucket_t *bucket;  // bucket of the index with the subscription
+    int pos;                    // position in the bucket
+    uint32_t id_hash;           // identity hash: subscriber and event
+    struct _subscription_t *id_next;    // next in the identity hash chain
+    struct _subscription_t *id_prev;    // previous in the chain, 0 if first (O(1) removal)
+    const char *renamed_event;  // 0 if not renamed
+    subs_flag_t subs_flag;
+    json_t *__filter__;
+    filter_prog_t *filter_prog; // compiled __filter__, 0 if not compilable
+    publish_plan_t plan;
+    subs_throttle_t *throttle;  // 0 if no __coalesce_ms__ or __max_rate__
+    BOOL changes_kw;            // __local__, __global__ or __trans_filter__ change the kw
+} subscription_t;
+
+/*
+ *  Index of the publisher's subscriptions by event.
+ *  Each bucket keeps the subscription order (seq),
+ *  publishing merges the event bucket with the catch-all bucket.
+ */
+typedef struct _subs_bucket_t {
+    event_id_t event_id;        // 0 in catch-all bucket (empty event)
+    int n;
+    int size;
+    int holes;                  // removed entries, pending of compaction
+    subscription_t **entries;   // 0 if removed
+} subs_bucket_t;
+
+/*
+ *  Trie of the pattern subscriptions, keyed by the literal prefix
+ *  of the pattern (until the first '*' or '?'), case-insensitive.
+ *  Empty leaf nodes are pruned when their bucket empties (not while publishing).
+ */
+typedef struct _subs_trie_node_t {
+    struct _subs_trie_node_t *child;    // first child
+    struct _subs_trie_node_t *sibling;  // next sibling
+    char c;
+    subs_bucket_t bucket;               // patterns with the prefix of this node
+} subs_trie_node_t;
+
+/*
+ *  Cursor of a bucket in the publishing merge
+ */
+typedef struct {
+    subs_bucket_t *bucket;
+    int n;                      // entries when the publication started
+    int i;
+    BOOL pattern;               // trie bucket, the pattern must be checked
+} subs_cursor_t;
+
+#define SUBS_CURSORS 16         // cursors in stack by publication
+
+typedef struct {
+    subs_cursor_t *cursors;
+    int n;
+    int size;
+} subs_cursors_t;
+
+typedef struct _subs_index_t {
+    subs_bucket_t catch_all;
+    subs_trie_node_t *trie;     // pattern subscriptions
+    subs_bucket_t **slots;      // open addressing by event_id, buckets don't move
+    uint32_t mask;              // slots - 1
+    uint32_t used;
+    subscription_t **id_slots;  // identity hash (subscriber, event), chained
+    uint32_t id_mask;           // id_slots - 1
+    uint32_t id_count;
+    int publishing;             // publications in course (nested)
+    int tombstones;             // entries removed while publishing
+} subs_index_t;
+
+/*
+ *  Publish stats of a publisher by event, see gobj_set_publish_stats()
+ */
+typedef struct _publish_stats_t {
+    event_id_t event_id;        // 0 is free slot
+    uint64_t publications;
+    uint64_t skipped;           // not published by mt_publish_event
+    uint64_t matched;           // subscriptions of the event
+    uint64_t filtered;          // discarded by pre-filter or filter
+    uint64_t deliveries;        // sent with gobj_send_event()
+    uint64_t queued;            // posted to the event queue or kept by the throttle
+    uint64_t copies;            // kw duplicated
+    uint64_t owned;             // __own_event__ short-circuits
+    uint64_t time_ns;
+} publish_stats_t;
+
+/*
+ *  Lightweight listener of state changes, see gobj_add_state_listener()
+ */
+typedef struct _state_listener_t {
+    gobj_state_listener_fn cb;
+    void *user_data;
+} state_listener_t;
+
+/*
+ *  Yuno's queue of posted events
+ */
+typedef struct {
+    GObj_t *dst;    // 0 if dst was freed before the delivery
+    GObj_t *src;
+    event_id_t event_id;
+    json_t *kw;
+} posted_event_t;
+
+/*
+ *  Yuno's mailbox, events sent from foreign threads.
+ *  Intrusive multi-producer/single-consumer queue (D. Vyukov),
+ *  producers only do an atomic exchange, the consumer is the yuno's loop.
+ */
+typedef struct _mailbox_node_t {
+    struct _mailbox_node_t *next;
+    GObj_t *dst;    // Not dereferenced until it's found in the live gobjs (yuno's thread)
+    uint64_t dst_instance_id;   // dst is valid only if it's still the same instance
+    char *kw;       // serialized kw, parsed in the yuno's thread, points into `event` buffer
+    char event[];
+} mailbox_node_t;
+
 
 /****************************************************************
  *         Data
@@ -267,9 +517,51 @@ PRIVATE json_t *__jn_unique_named_dict__ = 0;  // Dict unique_name:(json_int_t)(
 PRIVATE dl_list_t dl_gclass = {0};
 PRIVATE dl_list_t dl_service = {0};
 PRIVATE dl_list_t dl_trans_filter = {0};
+PRIVATE uint32_t __trans_filter_generation__ = 1;    // changes when the trans filters change
 
 PRIVATE kw_match_fn __publish_event_match__ = kw_match_simple;
 
+/*
+ *  Event atoms
+ */
+PRIVATE char **__event_atoms__ = 0;             // atom -> name, atom 0 is not used
+PRIVATE uint32_t __event_atoms_count__ = 0;     // including atom 0
+PRIVATE uint32_t __event_atoms_size__ = 0;
+PRIVATE event_id_t *__event_atoms_hash__ = 0;   // open addressing, 0 is free slot
+PRIVATE uint32_t __event_atoms_hash_mask__ = 0;
+
+/*
+ *  Yuno's queue of posted events (run-to-completion)
+ */
+PRIVATE posted_event_t *__event_queue__ = 0;    // ring buffer
+PRIVATE uint32_t __event_queue_size__ = 0;      // power of 2
+PRIVATE uint32_t __event_queue_head__ = 0;
+PRIVATE uint32_t __event_queue_count__ = 0;
+PRIVATE uint32_t __event_queue_batch_size__ = 1024;     // max events by loop iteration
+PRIVATE uint64_t __event_queue_max_drain_ns__ = 5000000;// max time draining by loop iteration
+PRIVATE uv_loop_t *__event_queue_loop__ = 0;
+PRIVATE uv_check_t __event_queue_check__;
+PRIVATE uv_idle_t __event_queue_idle__;
+PRIVATE int __event_queue_closing__ = 0;        // handles closed by stop, waiting the close callback
+
+PRIVATE mailbox_node_t __mailbox_stub__ = {0};
+PRIVATE mailbox_node_t *__mailbox_head__ = &__mailbox_stub__;  // producers push here
+PRIVATE mailbox_node_t *__mailbox_tail__ = &__mailbox_stub__;  // consumer pops here
+PRIVATE int __mailbox_wakeup_pending__ = 0;  // coalesce the wakeups of loop
+PRIVATE int __mailbox_producers__ = 0;       // producers inside gobj_send_event_from_thread()
+PRIVATE uv_async_t __mailbox_async__;
+
+/*
+ *  Live gobjs, to validate the dst of mailbox events (yuno's thread only)
+ */
+PRIVATE GObj_t **__live_gobjs__ = 0;    // open addressing by pointer, 0 is free slot
+PRIVATE uint32_t __live_gobjs_mask__ = 0;
+PRIVATE uint32_t __live_gobjs_used__ = 0;
+PRIVATE uint64_t __last_instance_id__ = 0;
+
+PRIVATE BOOL __action_latency_enabled__ = FALSE;
+PRIVATE BOOL __publish_stats_enabled__ = FALSE;
+
 /*
  *  Global trace levels
  */
@@ -288,6 +580,29 @@ PRIVATE const trace_level_t s_global_trace_level[16] = {
 {"states",          "Trace change of states"},
 {0, 0},
 };
+#ifdef NOT_INCLUDE_TRACING
+/*
+ *  Tracing compiled out (cmake -DGINSFSM_TRACING=OFF)
+ */
+#define __trace_gobj_create_delete__(gobj)  (0)
+#define __trace_gobj_create_delete2__(gobj) (0)
+#define __trace_gobj_subscriptions__(gobj)  (0)
+#define __trace_gobj_start_stop__(gobj)     (0)
+#define __trace_gobj_oids__(gobj)           (0)
+#define __trace_gobj_uv__(gobj)             (0)
+#define __trace_gobj_ev_kw__(gobj)          (0)
+#define __trace_gobj_authzs__(gobj)         (0)
+#define __trace_gobj_subscriptions2__(gobj) (0)
+#define __trace_gobj_states__(gobj)         (0)
+#define __trace_gobj_monitor__(gobj)        (0)
+#define __trace_gobj_event_monitor__(gobj)  (0)
+
+#define is_machine_tracing(gobj)            (FALSE)
+#define is_machine_not_tracing(gobj)        (TRUE)
+#define monitor_gobj(m, gobj)
+#define monitor_event(m, event, src, dst)
+#define monitor_state(gobj)
+#else
 #define __trace_gobj_create_delete__(gobj)  (gobj_trace_level(gobj) & TRACE_CREATE_DELETE)
 #define __trace_gobj_create_delete2__(gobj) (gobj_trace_level(gobj) & TRACE_CREATE_DELETE2)
 #define __trace_gobj_subscriptions__(gobj)  (gobj_trace_level(gobj) & TRACE_SUBSCRIPTIONS)
@@ -303,11 +618,25 @@ PRIVATE const trace_level_t s_global_trace_level[16] = {
 //#define __trace_gobj_event_monitor__(gobj)  (gobj_trace_level(gobj) & TRACE_EVENT_MONITOR)
 #define __trace_gobj_monitor__(gobj)        (0)
 #define __trace_gobj_event_monitor__(gobj)  (0)
+#endif
 
 PRIVATE uint32_t __global_trace_level__ = 0;
 PRIVATE volatile uint32_t __panic_trace__ = 0;
 PRIVATE uint32_t __deep_trace__ = 0;
 
+/*
+ *  Any change of trace levels, trace filters, panic or deep trace
+ *  bumps the generation and invalidates the cached masks of all gobjs.
+ */
+PRIVATE uint32_t __trace_generation__ = 1;
+PRIVATE json_t *__jn_trace_filtered_attrs__ = 0;    // attr name: number of gclasses filtering it
+#define TRACE_FLAG_MACHINE_TRACING      0x0001
+#define TRACE_FLAG_MACHINE_NOT_TRACING  0x0002
+#define INVALIDATE_TRACE_MASKS()                        \
+    if(++__trace_generation__ == 0) {                   \
+        __trace_generation__ = 1;                       \
+    }
+
 /*
  *  Strings of enum gcflag_t gcflag
  */
@@ -424,7 +753,31 @@ PRIVATE json_t *__2key__ = 0;
  *         Prototypes
  ****************************************************************/
 PRIVATE BOOL _change_state(GObj_t * gobj, const char *new_state);
+PRIVATE BOOL _change_state_index(GObj_t * gobj, int new_state);
+PRIVATE int _gobj_send_event(
+    GObj_t * dst,
+    const char *event,
+    const EVENT *ev_desc,
+    json_t *kw,
+    GObj_t * src
+);
 PRIVATE void free_gclass_reg(gclass_register_t *gclass_reg);
+PRIVATE void update_trace_filtered_attrs(void);
+PRIVATE int fsm_table_create(GCLASS *gclass);
+PRIVATE int fsm_dispatcher_check(
+    GCLASS *gclass,
+    fsm_table_t *fsm_table,
+    fsm_dispatcher_fn dispatcher
+);
+PRIVATE void intern_gclass_events(GCLASS *gclass);
+PRIVATE void free_event_atoms(void);
+PRIVATE void purge_posted_events(GObj_t *gobj);
+PRIVATE void free_event_queue(void);
+PRIVATE int live_gobj_add(GObj_t *gobj);
+PRIVATE void live_gobj_remove(GObj_t *gobj);
+PRIVATE void record_action_latency(fsm_table_t *fsm_table, fsm_cell_t *cell, uint64_t ns);
+PRIVATE publish_stats_t *publish_stats_get(GObj_t *publisher, event_id_t event_id);
+PRIVATE void fsm_table_destroy(GCLASS *gclass);
 PRIVATE void free_service_reg(service_register_t *srv_reg);
 PRIVATE void free_trans_filter(trans_filter_t *trans_reg);
 PRIVATE void gobj_free(hgobj gobj);
@@ -441,9 +794,12 @@ PRIVATE hgobj _create_yuno(
 );
 PRIVATE service_register_t * _find_service(const char *service);
 
+#ifndef NOT_INCLUDE_TRACING
 PRIVATE char *tab(char *bf, int bflen);
 PRIVATE inline BOOL is_machine_tracing(GObj_t * gobj);
+PRIVATE void refresh_trace_masks(GObj_t *gobj);
 PRIVATE inline BOOL is_machine_not_tracing(GObj_t * gobj);
+#endif
 
 PRIVATE int gobj_write_json_parameters(
     GObj_t * gobj,
@@ -462,6 +818,7 @@ PRIVATE int on_post_write_stats_it_cb(
     SData_Value_t old_v,
     SData_Value_t new_v
 );
+#ifndef NOT_INCLUDE_TRACING
 PRIVATE void monitor_gobj(
     monitor_gobj_t monitor_gobj,
     GObj_t *gobj
@@ -479,8 +836,20 @@ PRIVATE void monitor_event(
 PRIVATE void monitor_state(
     GObj_t *gobj
 );
+#endif
 
 PRIVATE int _delete_subscriptions(GObj_t * publisher);
+PRIVATE void notify_state_changed(GObj_t * gobj);
+PRIVATE subscription_t *subs_index_add(GObj_t *publisher, hsdata subs, const char *event);
+PRIVATE int subscription_load(subscription_t *sub);
+PRIVATE int publish_plan_build(publish_plan_t *plan, json_t *__config__, json_t *__global__, json_t *__local__);
+PRIVATE int publish_plan_resolve_trans(publish_plan_t *plan);
+PRIVATE void publish_plan_free(publish_plan_t *plan);
+PRIVATE void subs_index_remove(GObj_t *publisher, hsdata subs);
+PRIVATE void subs_index_free(GObj_t *publisher);
+PRIVATE BOOL subs_index_has_subscribers(GObj_t *publisher, const char *event);
+PRIVATE void subs_bucket_free(subs_bucket_t *bucket);
+PRIVATE void subs_bucket_compact(subs_bucket_t *bucket);
 PRIVATE int _delete_subscribings(GObj_t * subscriber);
 
 PRIVATE int print_attr_not_found(void *user_data, const char *attr)
@@ -669,6 +1038,9 @@ PUBLIC void gobj_end(void)
     while((trans_reg=dl_first(&dl_trans_filter))) {
         free_trans_filter(trans_reg);
     }
+    free_event_queue();
+    free_event_atoms();
+    sdata_free_schema_indexes();
     JSON_DECREF(jn_treedb_schema_gobjs);
     JSON_DECREF(__2key__);
 
@@ -731,6 +1103,8 @@ PUBLIC int gobj_register_yuno(
 
     dl_add(&dl_gclass, gclass_reg);
 
+    intern_gclass_events(gclass);
+
     return 0;
 }
 
@@ -741,6 +1115,9 @@ PRIVATE void free_gclass_reg(gclass_register_t *gclass_reg)
 {
     dl_delete(&dl_gclass, gclass_reg, 0);
     JSON_DECREF(gclass_reg->gclass->__jn_trace_filter__);
+    update_trace_filtered_attrs();
+    INVALIDATE_TRACE_MASKS()
+    fsm_table_destroy(gclass_reg->gclass);
     if(gclass_reg->to_free) {
         GBMEM_FREE(gclass_reg->gclass);
     }
@@ -766,6 +1143,7 @@ PRIVATE void free_trans_filter(trans_filter_t *trans_reg)
     dl_delete(&dl_trans_filter, trans_reg, 0);
     GBMEM_FREE(trans_reg->name);
     GBMEM_FREE(trans_reg);
+    __trans_filter_generation__++;
 }
 
 /***************************************************************************
@@ -948,6 +1326,8 @@ PUBLIC int gobj_register_gclass(GCLASS *gclass)
     gclass_reg->gclass = gclass;
     dl_insert(&dl_gclass, gclass_reg);
 
+    intern_gclass_events(gclass);
+
     return 0;
 }
 
@@ -1402,6 +1782,7 @@ PRIVATE int register_transformation_filter(const char *name, json_t * (trans_fil
     trans_reg->name = gbmem_strdup(name);
     trans_reg->transformation_fn = trans_filter;
     dl_add(&dl_trans_filter, trans_reg);
+    __trans_filter_generation__++;
 
     return 0;
 }
@@ -1424,6 +1805,186 @@ PRIVATE json_t *webix_trans_filter(
 
 
 
+                    /*---------------------------------*
+                     *  SECTION: Event atoms
+                     *---------------------------------*/
+
+
+
+
+/***************************************************************************
+ *  Case-insensitive hash of event name
+ ***************************************************************************/
+PRIVATE inline uint32_t event_name_hash(const char *event)
+{
+    register uint32_t h = 2166136261u; // FNV-1a
+    register const unsigned char *p = (const unsigned char *)event;
+
+    while(*p) {
+        h ^= (uint32_t)tolower(*p);
+        h *= 16777619u;
+        p++;
+    }
+    return h;
+}
+
+/***************************************************************************
+ *  Hash of atom
+ ***************************************************************************/
+PRIVATE inline uint32_t event_atom_hash(event_id_t event_id)
+{
+    return event_id * 2654435761u;
+}
+
+/***************************************************************************
+ *  Return the hash slot of event name, free or with the atom of name.
+ ***************************************************************************/
+PRIVATE inline uint32_t event_atom_slot(const char *event)
+{
+    uint32_t i = event_name_hash(event) & __event_atoms_hash_mask__;
+    while(__event_atoms_hash__[i]) {
+        if(strcasecmp(__event_atoms__[__event_atoms_hash__[i]], event)==0) {
+            break;
+        }
+        i = (i + 1) & __event_atoms_hash_mask__;
+    }
+    return i;
+}
+
+/***************************************************************************
+ *  Grow the atom table
+ ***************************************************************************/
+PRIVATE int grow_event_atoms(void)
+{
+    uint32_t new_size = __event_atoms_size__? __event_atoms_size__ * 2 : 256;
+
+    char **new_atoms = gbmem_malloc(sizeof(char *) * new_size);
+    event_id_t *new_hash = gbmem_malloc(sizeof(event_id_t) * new_size * 2);
+    if(!new_atoms || !new_hash) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for event atoms",
+            "size",         "%d", (int)new_size,
+            NULL
+        );
+        GBMEM_FREE(new_atoms);
+        GBMEM_FREE(new_hash);
+        return -1;
+    }
+    if(__event_atoms__) {
+        memcpy(new_atoms, __event_atoms__, sizeof(char *) * __event_atoms_count__);
+        GBMEM_FREE(__event_atoms__);
+    } else {
+        __event_atoms_count__ = 1; // atom 0 is not used
+    }
+    GBMEM_FREE(__event_atoms_hash__);
+
+    __event_atoms__ = new_atoms;
+    __event_atoms_size__ = new_size;
+    __event_atoms_hash__ = new_hash;
+    __event_atoms_hash_mask__ = new_size * 2 - 1;
+
+    /*
+     *  Rehash
+     */
+    for(event_id_t id=1; id<__event_atoms_count__; id++) {
+        __event_atoms_hash__[event_atom_slot(__event_atoms__[id])] = id;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Free the atom table
+ ***************************************************************************/
+PRIVATE void free_event_atoms(void)
+{
+    for(event_id_t id=1; id<__event_atoms_count__; id++) {
+        GBMEM_FREE(__event_atoms__[id]);
+    }
+    GBMEM_FREE(__event_atoms__);
+    GBMEM_FREE(__event_atoms_hash__);
+    __event_atoms_count__ = 0;
+    __event_atoms_size__ = 0;
+    __event_atoms_hash_mask__ = 0;
+}
+
+/***************************************************************************
+ *  Intern the event name, return his atom.
+ *  The names are case-insensitive, the first spelling interned is kept.
+ ***************************************************************************/
+PUBLIC event_id_t gobj_event_atom(const char *event)
+{
+    if(empty_string(event)) {
+        return 0;
+    }
+    if(__event_atoms_count__ >= __event_atoms_size__) {
+        if(grow_event_atoms()<0) {
+            return 0;
+        }
+    }
+    uint32_t i = event_atom_slot(event);
+    if(__event_atoms_hash__[i]) {
+        return __event_atoms_hash__[i];
+    }
+
+    char *name = gbmem_strdup(event);
+    if(!name) {
+        return 0;
+    }
+    event_id_t id = __event_atoms_count__++;
+    __event_atoms__[id] = name;
+    __event_atoms_hash__[i] = id;
+    return id;
+}
+
+/***************************************************************************
+ *  Return the atom of event name, 0 if it's not interned
+ ***************************************************************************/
+PUBLIC event_id_t gobj_find_event_atom(const char *event)
+{
+    if(empty_string(event) || !__event_atoms_hash__) {
+        return 0;
+    }
+    return __event_atoms_hash__[event_atom_slot(event)];
+}
+
+/***************************************************************************
+ *  Return the name of atom, NULL if it's not valid
+ ***************************************************************************/
+PUBLIC const char *gobj_event_atom_name(event_id_t event_id)
+{
+    if(event_id == 0 || event_id >= __event_atoms_count__) {
+        return 0;
+    }
+    return __event_atoms__[event_id];
+}
+
+/***************************************************************************
+ *  Intern the input and output events of gclass
+ ***************************************************************************/
+PRIVATE void intern_gclass_events(GCLASS *gclass)
+{
+    const FSM *fsm = gclass->fsm;
+    if(!fsm) {
+        return;
+    }
+    if(fsm->input_events) {
+        for(int i=0; fsm->input_events[i].event!=0; i++) {
+            gobj_event_atom(fsm->input_events[i].event);
+        }
+    }
+    if(fsm->output_events) {
+        for(int i=0; fsm->output_events[i].event!=0; i++) {
+            gobj_event_atom(fsm->output_events[i].event);
+        }
+    }
+}
+
+
+
+
                     /*---------------------------------*
                      *  SECTION: Creation functions
                      *---------------------------------*/
@@ -1698,82 +2259,357 @@ PRIVATE int smachine_check(GCLASS *gclass)
         }
     }
 
+    /*
+     *  Compile the dispatch table
+     */
+    fsm_table_create(gclass);
+
     return 0;
 }
 
 /***************************************************************************
- *  Create gobj
+ *  Compile the fsm of gclass in a dispatch table.
+ *  Semantic is the same as the linear search:
+ *  the first matching input event and the first matching action win.
  ***************************************************************************/
-PRIVATE hgobj _gobj_create(
-    const char *name_,
-    GCLASS *gclass,
-    GObj_t *parent,
-    json_t *kw,
-    GObj_t *yuno,
-    obflag_t obflag)
+PRIVATE int fsm_table_create(GCLASS *gclass)
 {
-    GObj_t *gobj;
+    const FSM *fsm = gclass->fsm;
+    int n_states = 0;
+    int n_events = 0;
+    uint32_t hash_size = 8;
 
-    /*--------------------------------*
-     *      Check forbidden chars
-     *      in GClass's name
-     *--------------------------------*/
-    if(strchr(gclass->gclass_name, '.')) {
-        log_error(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "GClass name CANNOT have '.' char",
-            "gclass",       "%s", gclass->gclass_name,
-            NULL
-        );
-        JSON_DECREF(kw);
-        return (hgobj)0;
+    fsm_table_destroy(gclass);
+    if(!fsm || !fsm->states || !fsm->state_names || !fsm->input_events) {
+        return -1;
     }
-    if(strchr(gclass->gclass_name, '`')) {
-        log_error(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "GClass name CANNOT have '`' char",
-            "gclass",       "%s", gclass->gclass_name,
-            NULL
-        );
-        JSON_DECREF(kw);
-        return (hgobj)0;
+    while(fsm->state_names[n_states]) {
+        n_states++;
     }
-    if(strchr(gclass->gclass_name, '^')) {
-        log_error(LOG_OPT_TRACE_STACK,
+    while(fsm->input_events[n_events].event) {
+        n_events++;
+    }
+    while(hash_size < (uint32_t)n_events * 2) {
+        hash_size <<= 1;
+    }
+
+    fsm_table_t *fsm_table = gbmem_malloc(sizeof(fsm_table_t));
+    int *hash_slots = gbmem_malloc(sizeof(int) * hash_size);
+    int *atom_slots = gbmem_malloc(sizeof(int) * hash_size);
+    event_id_t *event_ids = gbmem_malloc(sizeof(event_id_t) * (n_events + 1));
+    fsm_cell_t *cells = gbmem_malloc(sizeof(fsm_cell_t) * (n_states * n_events + 1));
+    if(!fsm_table || !hash_slots || !atom_slots || !event_ids || !cells) {
+        log_error(0,
             "gobj",         "%s", __FILE__,
             "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "GClass name CANNOT have '^' char",
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for fsm table",
             "gclass",       "%s", gclass->gclass_name,
             NULL
         );
-        JSON_DECREF(kw);
-        return (hgobj)0;
+        GBMEM_FREE(fsm_table);
+        GBMEM_FREE(hash_slots);
+        GBMEM_FREE(atom_slots);
+        GBMEM_FREE(event_ids);
+        GBMEM_FREE(cells);
+        return -1;
     }
+    fsm_table->fsm = fsm;
+    fsm_table->n_states = n_states;
+    fsm_table->n_events = n_events;
+    fsm_table->hash_mask = hash_size - 1;
+    fsm_table->hash_slots = hash_slots;
+    fsm_table->atom_slots = atom_slots;
+    fsm_table->event_ids = event_ids;
+    fsm_table->cells = cells;
 
-    /*--------------------------------*
-     *      Check forbidden chars
-     *      in gobj's name
-     *--------------------------------*/
-    if(!empty_string(name_)) {
-// WARNING no lo puedo poner, el '.' es usado cuando le pongo el nombre el peername a un gobj
-//         if(strchr(name_, '.')) {
-//             log_error(LOG_OPT_TRACE_STACK,
-//                 "gobj",         "%s", __FILE__,
-//                 "function",     "%s", __FUNCTION__,
-//                 "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-//                 "msg",          "%s", "GObj name CANNOT have '.' char",
-//                 "gclass",       "%s", gclass->gclass_name,
-//                 "name",         "%s", name_,
-//                 NULL
-//             );
-//             JSON_DECREF(kw);
-//             return (hgobj)0;
-//         }
+    /*
+     *  Hash of input events
+     */
+    for(int ev=0; ev<n_events; ev++) {
+        const char *event = fsm->input_events[ev].event;
+        uint32_t i = event_name_hash(event) & fsm_table->hash_mask;
+        BOOL repeated = FALSE;
+        while(hash_slots[i]) {
+            if(strcasecmp(fsm->input_events[hash_slots[i]-1].event, event)==0) {
+                repeated = TRUE; // Keep the first one
+                break;
+            }
+            i = (i + 1) & fsm_table->hash_mask;
+        }
+        if(!repeated) {
+            hash_slots[i] = ev + 1;
+
+            /*
+             *  Hash of atoms, the same atom of repeated names
+             */
+            event_id_t event_id = gobj_event_atom(event);
+            event_ids[ev] = event_id;
+            if(event_id) {
+                i = event_atom_hash(event_id) & fsm_table->hash_mask;
+                while(atom_slots[i]) {
+                    i = (i + 1) & fsm_table->hash_mask;
+                }
+                atom_slots[i] = ev + 1;
+            }
+        }
+    }
+
+    /*
+     *  Dense [state][event] table
+     */
+    for(int st=0; st<n_states; st++) {
+        fsm_cell_t *row = cells + st * n_events;
+        for(int ev=0; ev<n_events; ev++) {
+            row[ev].next_state = -1;
+        }
+        const EV_ACTION *ev_action = fsm->states[st];
+        while(ev_action && ev_action->event) {
+            const EVENT *ev_desc = 0;
+            uint32_t i = event_name_hash(ev_action->event) & fsm_table->hash_mask;
+            while(hash_slots[i]) {
+                if(strcasecmp(fsm->input_events[hash_slots[i]-1].event, ev_action->event)==0) {
+                    ev_desc = &fsm->input_events[hash_slots[i]-1];
+                    break;
+                }
+                i = (i + 1) & fsm_table->hash_mask;
+            }
+            if(ev_desc) {
+                fsm_cell_t *cell = row + (ev_desc - fsm->input_events);
+                if(!cell->ev_action) {
+                    cell->ev_action = ev_action;
+                    if(ev_action->next_state) {
+                        for(int nx=0; nx<n_states; nx++) {
+                            if(strcasecmp(fsm->state_names[nx], ev_action->next_state)==0) {
+                                cell->next_state = nx;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+            ev_action++;
+        }
+    }
+
+    gclass->__fsm_table__ = fsm_table;
+
+    /*
+     *  Generated dispatcher, must agree with the tables in every cell
+     */
+    if(gclass->__fsm_dispatcher__) {
+        if(fsm_dispatcher_check(gclass, fsm_table, gclass->__fsm_dispatcher__)==0) {
+            fsm_table->dispatcher = gclass->__fsm_dispatcher__;
+        }
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Check that the dispatcher resolves every (state, event)
+ *  to the same EV_ACTION and next state than the table walk
+ ***************************************************************************/
+PRIVATE int fsm_dispatcher_check(
+    GCLASS *gclass,
+    fsm_table_t *fsm_table,
+    fsm_dispatcher_fn dispatcher)
+{
+    for(int st=0; st<fsm_table->n_states; st++) {
+        for(int ev=0; ev<fsm_table->n_events; ev++) {
+            fsm_cell_t *cell = fsm_table->cells + st * fsm_table->n_events + ev;
+            int next_state = -1;
+            const EV_ACTION *ev_action = dispatcher(st, ev, &next_state);
+            if(ev_action != cell->ev_action || next_state != cell->next_state) {
+                log_error(0,
+                    "gobj",         "%s", __FILE__,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+                    "msg",          "%s", "fsm dispatcher doesn't match the fsm, ignored. Regenerate it",
+                    "gclass",       "%s", gclass->gclass_name,
+                    "state",        "%s", fsm_table->fsm->state_names[st],
+                    "event",        "%s", fsm_table->fsm->input_events[ev].event,
+                    NULL
+                );
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Set the specialized dispatcher of gclass (generated by ginsfsm_fsmgen)
+ ***************************************************************************/
+PUBLIC int gobj_set_fsm_dispatcher(GCLASS *gclass, fsm_dispatcher_fn dispatcher)
+{
+    if(!gclass) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gclass NULL",
+            NULL
+        );
+        return -1;
+    }
+    gclass->__fsm_dispatcher__ = dispatcher;
+
+    fsm_table_t *fsm_table = gclass->__fsm_table__;
+    if(fsm_table) {
+        fsm_table->dispatcher = 0;
+        if(dispatcher) {
+            if(fsm_dispatcher_check(gclass, fsm_table, dispatcher)<0) {
+                return -1;
+            }
+            fsm_table->dispatcher = dispatcher;
+        }
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Free the compiled fsm
+ ***************************************************************************/
+PRIVATE void fsm_table_destroy(GCLASS *gclass)
+{
+    fsm_table_t *fsm_table = gclass->__fsm_table__;
+    if(fsm_table) {
+        GBMEM_FREE(fsm_table->hash_slots);
+        GBMEM_FREE(fsm_table->atom_slots);
+        GBMEM_FREE(fsm_table->event_ids);
+        if(fsm_table->latency) {
+            for(int i=0; i<fsm_table->n_states * fsm_table->n_events; i++) {
+                GBMEM_FREE(fsm_table->latency[i]);
+            }
+            GBMEM_FREE(fsm_table->latency);
+        }
+        GBMEM_FREE(fsm_table->cells);
+        GBMEM_FREE(fsm_table);
+        gclass->__fsm_table__ = 0;
+    }
+    gclass->fsm_checked = FALSE;
+}
+
+/***************************************************************************
+ *  Return the index of input event, -1 if not found
+ ***************************************************************************/
+PRIVATE inline int fsm_table_event_index(fsm_table_t *fsm_table, const char *event)
+{
+    uint32_t i = event_name_hash(event) & fsm_table->hash_mask;
+    register int *hash_slots = fsm_table->hash_slots;
+    const EVENT *input_events = fsm_table->fsm->input_events;
+
+    while(hash_slots[i]) {
+        if(strcasecmp(input_events[hash_slots[i]-1].event, event)==0) {
+            return hash_slots[i]-1;
+        }
+        i = (i + 1) & fsm_table->hash_mask;
+    }
+    return -1;
+}
+
+/***************************************************************************
+ *  Return the index of input event by atom, -1 if not found
+ ***************************************************************************/
+PRIVATE inline int fsm_table_event_index_by_atom(fsm_table_t *fsm_table, event_id_t event_id)
+{
+    uint32_t i = event_atom_hash(event_id) & fsm_table->hash_mask;
+    register int *atom_slots = fsm_table->atom_slots;
+
+    while(atom_slots[i]) {
+        if(fsm_table->event_ids[atom_slots[i]-1] == event_id) {
+            return atom_slots[i]-1;
+        }
+        i = (i + 1) & fsm_table->hash_mask;
+    }
+    return -1;
+}
+
+/***************************************************************************
+ *  Return the compiled fsm of gobj, if it's usable
+ ***************************************************************************/
+PRIVATE inline fsm_table_t *gobj_fsm_table(GObj_t *gobj)
+{
+    fsm_table_t *fsm_table = gobj->gclass->__fsm_table__;
+    if(fsm_table && fsm_table->fsm == gobj->mach->fsm) {
+        return fsm_table;
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Create gobj
+ ***************************************************************************/
+PRIVATE hgobj _gobj_create(
+    const char *name_,
+    GCLASS *gclass,
+    GObj_t *parent,
+    json_t *kw,
+    GObj_t *yuno,
+    obflag_t obflag)
+{
+    GObj_t *gobj;
+
+    /*--------------------------------*
+     *      Check forbidden chars
+     *      in GClass's name
+     *--------------------------------*/
+    if(strchr(gclass->gclass_name, '.')) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "GClass name CANNOT have '.' char",
+            "gclass",       "%s", gclass->gclass_name,
+            NULL
+        );
+        JSON_DECREF(kw);
+        return (hgobj)0;
+    }
+    if(strchr(gclass->gclass_name, '`')) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "GClass name CANNOT have '`' char",
+            "gclass",       "%s", gclass->gclass_name,
+            NULL
+        );
+        JSON_DECREF(kw);
+        return (hgobj)0;
+    }
+    if(strchr(gclass->gclass_name, '^')) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "GClass name CANNOT have '^' char",
+            "gclass",       "%s", gclass->gclass_name,
+            NULL
+        );
+        JSON_DECREF(kw);
+        return (hgobj)0;
+    }
+
+    /*--------------------------------*
+     *      Check forbidden chars
+     *      in gobj's name
+     *--------------------------------*/
+    if(!empty_string(name_)) {
+// WARNING no lo puedo poner, el '.' es usado cuando le pongo el nombre el peername a un gobj
+//         if(strchr(name_, '.')) {
+//             log_error(LOG_OPT_TRACE_STACK,
+//                 "gobj",         "%s", __FILE__,
+//                 "function",     "%s", __FUNCTION__,
+//                 "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+//                 "msg",          "%s", "GObj name CANNOT have '.' char",
+//                 "gclass",       "%s", gclass->gclass_name,
+//                 "name",         "%s", name_,
+//                 NULL
+//             );
+//             JSON_DECREF(kw);
+//             return (hgobj)0;
+//         }
         if(strchr(name_, '`')) {
             log_error(LOG_OPT_TRACE_STACK,
                 "gobj",         "%s", __FILE__,
@@ -1818,6 +2654,8 @@ PRIVATE hgobj _gobj_create(
         JSON_DECREF(kw);
         return (hgobj)0;
     }
+    live_gobj_add(gobj);
+    gobj->__instance_id__ = ++__last_instance_id__;
 
     /*--------------------------------*
      *      Alloc private data
@@ -1978,6 +2816,7 @@ PRIVATE hgobj _gobj_create(
     if(gobj->obflag & (obflag_unique_name)) {
         gobj_load_persistent_attrs(gobj, 0);
     }
+    gobj->__trace_generation__ = 0; // attrs (maybe filtered) are loaded now
 
     /*--------------------------------------*
      *      Add to parent
@@ -2674,6 +3513,15 @@ PUBLIC void gobj_destroy(hgobj gobj_)
 PRIVATE void gobj_free(hgobj gobj_)
 {
     register GObj_t * gobj = gobj_;
+
+    /*--------------------------------*
+     *  Discard posted events
+     *--------------------------------*/
+    if(gobj->__posted_events__) {
+        purge_posted_events(gobj);
+    }
+    live_gobj_remove(gobj);
+
     /*--------------------------------*
      *      Delete smachine
      *--------------------------------*/
@@ -2687,6 +3535,17 @@ PRIVATE void gobj_free(hgobj gobj_)
      *--------------------------------*/
     rc_free_iter(&gobj->dl_subscriptions, FALSE, sdata_destroy);
     rc_free_iter(&gobj->dl_subscribings, FALSE, sdata_destroy);
+    subs_index_free(gobj);
+
+    /*--------------------------------*
+     *      Delete state listeners
+     *--------------------------------*/
+    GBMEM_FREE(gobj->publish_stats);
+    if(gobj->state_listeners) {
+        gbmem_free(gobj->state_listeners);
+        gobj->state_listeners = 0;
+        gobj->n_state_listeners = 0;
+    }
 
     /*--------------------------------*
      *      Delete attr
@@ -2694,6 +3553,7 @@ PRIVATE void gobj_free(hgobj gobj_)
     if(gobj->hsdata_attr) {
         sdata_destroy(gobj->hsdata_attr);
         gobj->hsdata_attr = 0;
+        gobj->__trace_generation__ = 0;
     }
 
     /*--------------------------------*
@@ -2862,6 +3722,9 @@ PUBLIC GCLASS *gobj_subclass_gclass(GCLASS *base, const char *gclass_name)
     memcpy(gclass, base, sizeof(GCLASS));
     gclass->gclass_name = gclass_name;
     gclass->base = base;
+    gclass->fsm_checked = FALSE;    // the fsm can be changed, compile again
+    gclass->__fsm_table__ = 0;
+    gclass->__fsm_dispatcher__ = 0; // generated for the base's fsm
     return gclass;
 }
 
@@ -5788,1159 +6651,3592 @@ PUBLIC dl_list_t *gobj_filter_childs_by_re_name(dl_list_t *dl_childs, const char
 
 
 /***************************************************************************
- *
+ *  Return the bucket of event_id (0 is the catch-all bucket)
  ***************************************************************************/
-PRIVATE hsdata _create_subscription(
-    GObj_t * publisher,
-    const char *event,
-    json_t *kw, // not owned
-    GObj_t * subscriber)
+PRIVATE subs_bucket_t *subs_index_bucket(
+    subs_index_t *subs_index,
+    event_id_t event_id,
+    BOOL create)
 {
-    hsdata subs = sdata_create(subscription_desc, 0, 0, 0, 0, 0);
-    sdata_write_str(subs, "event", event);
-    sdata_write_pointer(subs, "subscriber", subscriber);
-    sdata_write_pointer(subs, "publisher", publisher);
-    subs_flag_t subs_flag = 0;
-
-    if(kw) {
-        json_t *__config__ = kw_get_dict(kw, "__config__", 0, 0);
-        json_t *__global__ = kw_get_dict(kw, "__global__", 0, 0);
-        json_t *__local__ = kw_get_dict(kw, "__local__", 0, 0);
-        json_t *__filter__ = kw_get_dict_value(kw, "__filter__", 0, 0);
-        const char *__service__ = kw_get_str(kw, "__service__", 0, 0);
-
-        if(__global__) { // HACK __global__ the first. __config__ can write in this area.
-            json_t *kw_clone = kw_duplicate(__global__);
-            sdata_write_json(subs, "__global__", kw_clone); // Incref
-            kw_decref(kw_clone); // Incref above
+    if(!event_id) {
+        return &subs_index->catch_all;
+    }
+    if(subs_index->slots) {
+        uint32_t i = event_atom_hash(event_id) & subs_index->mask;
+        while(subs_index->slots[i]) {
+            if(subs_index->slots[i]->event_id == event_id) {
+                return subs_index->slots[i];
+            }
+            i = (i + 1) & subs_index->mask;
         }
-        if(__config__) {
-            json_t *kw_clone = kw_duplicate(__config__);
-            sdata_write_json(subs, "__config__", kw_clone); // Incref
-            kw_decref(kw_clone); // Incref above
-            if(kw_has_key(kw_clone, "__rename_event_name__")) {
-                const char *renamed_event = kw_get_str(kw_clone, "__rename_event_name__", 0, 0);
-                sdata_write_str(subs, "renamed_event", renamed_event);
-                json_object_del(kw_clone, "__rename_event_name__");
-                subs_flag |= __rename_event_name__;
+    }
+    if(!create) {
+        return 0;
+    }
 
-                // Get/Create __global__
-                json_t *kw_global = sdata_read_json(subs, "__global__");
-                if(!kw_global) {
-                    kw_global = json_object();
-                    sdata_write_json(subs, "__global__", kw_global);
-                    kw_decref(kw_global); // Incref above
-                }
-                kw_set_dict_value(
-                    kw_global,
-                    "__original_event_name__",
-                    json_string(event)
-                );
-            }
-            if(kw_has_key(kw_clone, "__hard_subscription__")) {
-                BOOL hard_subscription = kw_get_bool(kw_clone, "__hard_subscription__", 0, 0);
-                json_object_del(kw_clone, "__hard_subscription__");
-                if(hard_subscription) {
-                    subs_flag |= __hard_subscription__;
-                }
-            }
-            if(kw_has_key(kw_clone, "__first_shot__")) {
-                BOOL first_short = kw_get_bool(kw_clone, "__first_short__", 0, 0);
-                // don't delete, external use
-                if(first_short) {
-                    subs_flag |= __first_shot__;
+    /*
+     *  Grow the slots at 50% load
+     */
+    if(!subs_index->slots || (subs_index->used + 1) * 2 > subs_index->mask + 1) {
+        uint32_t new_size = subs_index->slots? (subs_index->mask + 1) * 2 : 8;
+        subs_bucket_t **new_slots = gbmem_malloc(sizeof(subs_bucket_t *) * new_size);
+        if(!new_slots) {
+            return 0;
+        }
+        if(subs_index->slots) {
+            for(uint32_t j=0; j<=subs_index->mask; j++) {
+                subs_bucket_t *bucket = subs_index->slots[j];
+                if(bucket) {
+                    uint32_t i = event_atom_hash(bucket->event_id) & (new_size - 1);
+                    while(new_slots[i]) {
+                        i = (i + 1) & (new_size - 1);
+                    }
+                    new_slots[i] = bucket;
                 }
             }
-            if(kw_has_key(kw_clone, "__share_kw__")) {
-                BOOL share_kw = kw_get_bool(kw_clone, "__share_kw__", 0, 0);
-                json_object_del(kw_clone, "__share_kw__");
-                if(share_kw) {
-                    subs_flag |= __share_kw__;
-                }
-            }
-            if(kw_has_key(kw_clone, "__own_event__")) {
-                BOOL own_event= kw_get_bool(kw_clone, "__own_event__", 0, 0);
-                json_object_del(kw_clone, "__own_event__");
-                if(own_event) {
-                    subs_flag |= __own_event__;
-                }
-            }
-        }
-        if(__local__) {
-            json_t *kw_clone = kw_duplicate(__local__);
-            sdata_write_json(subs, "__local__", kw_clone); // Incref
-            kw_decref(kw_clone); // Incref above
-        }
-        if(__filter__) {
-            json_t *kw_clone = kw_duplicate(__filter__);
-            sdata_write_json(subs, "__filter__", kw_clone); // Incref
-            kw_decref(kw_clone); // Incref above
-        }
-        if(__service__) {
-            sdata_write_str(subs, "__service__", __service__);
+            gbmem_free(subs_index->slots);
         }
+        subs_index->slots = new_slots;
+        subs_index->mask = new_size - 1;
     }
 
-    return subs;
+    subs_bucket_t *bucket = gbmem_malloc(sizeof(subs_bucket_t));
+    if(!bucket) {
+        return 0;
+    }
+    bucket->event_id = event_id;
+    uint32_t i = event_atom_hash(event_id) & subs_index->mask;
+    while(subs_index->slots[i]) {
+        i = (i + 1) & subs_index->mask;
+    }
+    subs_index->slots[i] = bucket;
+    subs_index->used++;
+    return bucket;
 }
 
 /***************************************************************************
- *  Return a iter of subscriptions (sdata),
- *  filtering by matching:
- *      event,kw (__config__, __global__, __local__, __filter__),subscriber
- *  Free return with rc_free_iter(iter, TRUE, FALSE);
+ *  Append a node to the filter program, return its index or -1
  ***************************************************************************/
-PRIVATE dl_list_t * _find_subscription(
-    dl_list_t *dl_subs,
-    GObj_t * publisher,
-    const char *event,
-    json_t *kw, // owned
-    GObj_t * subscriber,
-    BOOL strict)
+PRIVATE int filter_prog_emit(filter_prog_t *prog, filter_op_t op)
 {
-    BOOL (*_match)(json_t *, json_t *) = 0;
-    if(strict) {
-        _match = kw_is_identical; // WARNING don't decref anything
-    } else {
-        _match = kw_match_simple; // WARNING decref second parameter
+    if(prog->n >= prog->size) {
+        int new_size = prog->size? prog->size * 2 : 8;
+        filter_node_t *new_nodes = gbmem_malloc(sizeof(filter_node_t) * new_size);
+        if(!new_nodes) {
+            return -1;
+        }
+        if(prog->nodes) {
+            memcpy(new_nodes, prog->nodes, sizeof(filter_node_t) * prog->n);
+            gbmem_free(prog->nodes);
+        }
+        prog->nodes = new_nodes;
+        prog->size = new_size;
     }
+    int idx = prog->n++;
+    filter_node_t *node = &prog->nodes[idx];
+    memset(node, 0, sizeof(filter_node_t));
+    node->op = op;
+    node->size = 1;
+    return idx;
+}
 
-    dl_list_t *iter = rc_init_iter(NULL);
-    json_t *__config__ = kw_get_dict(kw, "__config__", 0, 0);
-    json_t *__global__ = kw_get_dict(kw, "__global__", 0, 0);
-    json_t *__local__ = kw_get_dict(kw, "__local__", 0, 0);
-    json_t *__filter__ = kw_get_dict_value(kw, "__filter__", 0, 0);
-
-    hsdata subs;
-    rc_instance_t *i_subs = rc_first_instance(dl_subs, (rc_resource_t **)&subs);
-    while(i_subs) {
-        hsdata next_subs; rc_instance_t *next_i_subs;
-        next_i_subs = rc_next_instance(i_subs, (rc_resource_t **)&next_subs);
-
-        BOOL match = TRUE;
-
-        if(publisher) {
-            GObj_t *publisher_  = sdata_read_pointer(subs, "publisher");
-            if(publisher != publisher_) {
-                match = FALSE;
+/***************************************************************************
+ *  Compile a filter level (_kw_match_simple semantic):
+ *      array:  OR of the items, empty is false.
+ *      object: AND of the keys, empty is false.
+ *              A complex value (array/object) is evaluated as a nested filter
+ *              and the next keys are ignored.
+ *      others: false.
+ ***************************************************************************/
+PRIVATE int filter_prog_compile_level(filter_prog_t *prog, json_t *jn_filter)
+{
+    int idx;
+    if(json_is_array(jn_filter)) {
+        idx = filter_prog_emit(prog, FILTER_OP_ANY);
+        if(idx < 0) {
+            return -1;
+        }
+        size_t i;
+        json_t *jn_item;
+        json_array_foreach(jn_filter, i, jn_item) {
+            if(filter_prog_compile_level(prog, jn_item) < 0) {
+                return -1;
             }
         }
 
-        if(subscriber) {
-            GObj_t *subscriber_  = sdata_read_pointer(subs, "subscriber");
-            if(subscriber != subscriber_) {
-                match = FALSE;
+    } else if(json_is_object(jn_filter) && json_object_size(jn_filter)>0) {
+        idx = filter_prog_emit(prog, FILTER_OP_ALL);
+        if(idx < 0) {
+            return -1;
+        }
+        const char *key;
+        json_t *jn_value;
+        json_object_foreach(jn_filter, key, jn_value) {
+            if(json_is_array(jn_value) || json_is_object(jn_value)) {
+                if(filter_prog_compile_level(prog, jn_value) < 0) {
+                    return -1;
+                }
+                break;
             }
+            int i = filter_prog_emit(prog, FILTER_OP_EQUAL);
+            if(i < 0) {
+                return -1;
+            }
+            filter_node_t *node = &prog->nodes[i];
+            node->key = gbmem_strdup(key);
+            if(!node->key) {
+                return -1;
+            }
+            node->is_path = strchr(key, '`')? TRUE : FALSE;
+            node->value = json_incref(jn_value);
+            node->type = json_typeof(jn_value);
         }
 
-        if(event) {
-            const char *event_ = sdata_read_str(subs, "event");
-            if(!event_ || strcasecmp(event, event_)!=0) {
-                match = FALSE;
-            }
+    } else {
+        return filter_prog_emit(prog, FILTER_OP_FALSE);
+    }
+
+    prog->nodes[idx].size = prog->n - idx;
+    return idx;
+}
+
+/***************************************************************************
+ *  Free the filter program
+ ***************************************************************************/
+PRIVATE void filter_prog_free(filter_prog_t *prog)
+{
+    if(prog) {
+        for(int i=0; i<prog->n; i++) {
+            GBMEM_FREE(prog->nodes[i].key);
+            JSON_DECREF(prog->nodes[i].value);
         }
+        GBMEM_FREE(prog->nodes);
+        gbmem_free(prog);
+    }
+}
 
-        if(__config__) {
-            json_t *kw_config = sdata_read_json(subs, "__config__");
-            if(kw_config) {
-                if(!strict) { // HACK decref when calling _match (kw_match_simple)
-                    KW_INCREF(__config__);
+/***************************************************************************
+ *  Compile the subscription __filter__ (kw_match_simple semantic)
+ *  Return 0 if it cannot be compiled, the publishing will interpret it.
+ ***************************************************************************/
+PRIVATE filter_prog_t *filter_prog_compile(json_t *jn_filter)
+{
+    filter_prog_t *prog = gbmem_malloc(sizeof(filter_prog_t));
+    if(!prog) {
+        return 0;
+    }
+    int ret;
+    if(json_is_object(jn_filter)) {
+        if(json_object_size(jn_filter)==0) {
+            ret = filter_prog_emit(prog, FILTER_OP_TRUE);
+        } else {
+            ret = filter_prog_compile_level(prog, jn_filter);
+        }
+
+    } else if(json_is_array(jn_filter)) {
+        /*
+         *  Top level array: empty is true, OR of the items.
+         *  Array items are top level filters, objects are filter levels.
+         */
+        if(json_array_size(jn_filter)==0) {
+            ret = filter_prog_emit(prog, FILTER_OP_TRUE);
+        } else {
+            ret = filter_prog_emit(prog, FILTER_OP_ANY);
+            size_t i;
+            json_t *jn_item;
+            json_array_foreach(jn_filter, i, jn_item) {
+                if(ret < 0) {
+                    break;
                 }
-                if(!_match(kw_config, __config__)) {
-                    match = FALSE;
+                filter_prog_t *sub_prog;
+                if(json_is_object(jn_item)) {
+                    if(filter_prog_compile_level(prog, jn_item) < 0) {
+                        ret = -1;
+                    }
+                } else if(json_is_array(jn_item)) {
+                    sub_prog = filter_prog_compile(jn_item);
+                    if(!sub_prog) {
+                        ret = -1;
+                        break;
+                    }
+                    for(int j=0; j<sub_prog->n && ret >= 0; j++) {
+                        int k = filter_prog_emit(prog, sub_prog->nodes[j].op);
+                        if(k < 0) {
+                            ret = -1;
+                        } else {
+                            // move the node, with its key and value
+                            prog->nodes[k] = sub_prog->nodes[j];
+                            memset(&sub_prog->nodes[j], 0, sizeof(filter_node_t));
+                        }
+                    }
+                    filter_prog_free(sub_prog);
+                } else {
+                    if(filter_prog_emit(prog, FILTER_OP_FALSE) < 0) {
+                        ret = -1;
+                    }
                 }
-            } else {
-                match = FALSE;
+            }
+            if(ret >= 0) {
+                prog->nodes[0].size = prog->n;
             }
         }
-        if(__global__) {
-            json_t *kw_global = sdata_read_json(subs, "__global__");
-            if(kw_global) {
-                if(!strict) { // HACK decref when calling _match (kw_match_simple)
-                    KW_INCREF(__global__);
+
+    } else {
+        ret = filter_prog_emit(prog, FILTER_OP_FALSE);
+    }
+
+    if(ret < 0) {
+        filter_prog_free(prog);
+        return 0;
+    }
+    return prog;
+}
+
+/***************************************************************************
+ *  Evaluate a node of the filter program against the kw
+ ***************************************************************************/
+PRIVATE BOOL filter_node_match(const filter_node_t *node, json_t *kw)
+{
+    switch(node->op) {
+        case FILTER_OP_TRUE:
+            return TRUE;
+
+        case FILTER_OP_ANY:
+            {
+                const filter_node_t *end = node + node->size;
+                for(const filter_node_t *child = node + 1; child < end; child += child->size) {
+                    if(filter_node_match(child, kw)) {
+                        return TRUE;
+                    }
                 }
-                if(!_match(kw_global, __global__)) {
-                    match = FALSE;
+                return FALSE;
+            }
+
+        case FILTER_OP_ALL:
+            {
+                const filter_node_t *end = node + node->size;
+                for(const filter_node_t *child = node + 1; child < end; child += child->size) {
+                    if(!filter_node_match(child, kw)) {
+                        return FALSE;
+                    }
                 }
-            } else {
-                match = FALSE;
+                return TRUE;
             }
-        }
-        if(__local__) {
-            json_t *kw_local = sdata_read_json(subs, "__local__");
-            if(kw_local) {
-                if(!strict) { // HACK decref when calling _match (kw_match_simple)
-                    KW_INCREF(__local__);
+
+        case FILTER_OP_EQUAL:
+            {
+                /*
+                 *  Firstly by path, secondly the key as full key
+                 */
+                json_t *jn_record_value = 0;
+                if(node->is_path) {
+                    jn_record_value = kw_get_dict_value(kw, node->key, 0, 0);
                 }
-                if(!_match(kw_local, __local__)) {
-                    match = FALSE;
+                if(!jn_record_value) {
+                    jn_record_value = json_object_get(kw, node->key);
                 }
-            } else {
-                match = FALSE;
-            }
-        }
-        if(__filter__) {
-            json_t *jn_filter = sdata_read_json(subs, "__filter__");
-            if(jn_filter) {
-                if(!strict) { // HACK decref when calling _match (kw_match_simple)
-                    KW_INCREF(__filter__);
+                if(!jn_record_value) {
+                    return FALSE;
                 }
-                if(!_match(jn_filter, __filter__)) {
-                    match = FALSE;
+                if(node->type == JSON_STRING && json_is_string(jn_record_value)) {
+                    return strcmp(
+                        json_string_value(jn_record_value),
+                        json_string_value(node->value)
+                    )==0? TRUE : FALSE;
                 }
-            } else {
-                match = FALSE;
+                if(node->type == JSON_INTEGER && json_is_integer(jn_record_value)) {
+                    return json_integer_value(jn_record_value) ==
+                        json_integer_value(node->value)? TRUE : FALSE;
+                }
+                return cmp_two_simple_json(jn_record_value, node->value)==0? TRUE : FALSE;
             }
-        }
-
-        if(match) {
-            rc_add_instance(iter, subs, 0);
-        }
 
-        i_subs = next_i_subs;
-        subs = next_subs;
+        case FILTER_OP_FALSE:
+        default:
+            return FALSE;
     }
-
-    KW_DECREF(kw)
-    return iter;
 }
 
 /***************************************************************************
- *  Return the schema of subcriptions hsdata
+ *  Throttle: the timer is closed, free the memory
  ***************************************************************************/
-PUBLIC const sdata_desc_t *gobj_subscription_schema(void)
+PRIVATE void on_throttle_close(uv_handle_t *handle)
 {
-    return subscription_desc;
+    subs_throttle_t *throttle = handle->data;
+    GBMEM_FREE(throttle->pending);
+    gbmem_free(throttle);
 }
 
 /***************************************************************************
- *  Return number of subcriptions
+ *  Throttle: deliver the latest kw of each pending event
  ***************************************************************************/
-PUBLIC size_t gobj_subscriptions_size(
-    hgobj publisher_
-)
+PRIVATE void on_throttle_timer(uv_timer_t *handle)
 {
-    GObj_t * publisher = publisher_;
-    return dl_size(&publisher->dl_subscriptions);
-}
+    subs_throttle_t *throttle = handle->data;
 
-/***************************************************************************
- *  Return number of subcribings
- ***************************************************************************/
-PUBLIC size_t gobj_subscribings_size(hgobj subscriber_)
-{
-    GObj_t * subscriber = subscriber_;
-    return dl_size(&subscriber->dl_subscribings);
+    /*
+     *  Detach the pending list, publications while delivering are pending again
+     */
+    throttle_pending_t *pending = throttle->pending;
+    int n_pending = throttle->n_pending;
+    throttle->pending = 0;
+    throttle->n_pending = 0;
+    throttle->size_pending = 0;
+    throttle->last_delivery = uv_now(handle->loop);
+
+    for(int i=0; i<n_pending; i++) {
+        /*
+         *  The subscription can be removed by a previous delivery,
+         *  the throttle memory lives until the close callback.
+         */
+        subscription_t *sub = throttle->sub;
+        if(!sub || !sub->subscriber || (sub->subscriber->obflag & obflag_destroyed)) {
+            KW_DECREF(pending[i].kw);
+            continue;
+        }
+        gobj_send_event(
+            sub->subscriber,
+            gobj_event_atom_name(pending[i].event_id),
+            pending[i].kw,
+            throttle->publisher
+        );
+    }
+    GBMEM_FREE(pending);
 }
 
 /***************************************************************************
- *  Return a iter of subscriptions (sdata) in the publisher gobj,
- *  filtering by matching: event,kw (__config__, __global__, __local__, __filter__),subscriber
- *  Free return with rc_free_iter(iter, TRUE, FALSE);
+ *  Throttle: free, pending publications are discarded
  ***************************************************************************/
-PUBLIC dl_list_t * gobj_find_subscriptions(
-    hgobj publisher_,
-    const char *event,
-    json_t *kw,
-    hgobj subscriber)
+PRIVATE void subs_throttle_free(subs_throttle_t *throttle)
 {
-    GObj_t * publisher = publisher_;
-    return _find_subscription(&publisher->dl_subscriptions, publisher_, event, kw, subscriber, FALSE);
+    if(!throttle) {
+        return;
+    }
+    throttle->sub = 0;
+    for(int i=0; i<throttle->n_pending; i++) {
+        KW_DECREF(throttle->pending[i].kw);
+    }
+    throttle->n_pending = 0;
+    if(!throttle->timer_init) {
+        on_throttle_close((uv_handle_t *)&throttle->timer);
+        return;
+    }
+    uv_timer_stop(&throttle->timer);
+    uv_close((uv_handle_t *)&throttle->timer, on_throttle_close);
 }
 
 /***************************************************************************
- *  Return a iter of subscribings (sdata) of the subcriber gobj,
- *  filtering by matching: event,kw (__config__, __global__, __local__, __filter__), publisher
- *  Free return with rc_free_iter(iter, TRUE, FALSE);
+ *  Throttle: setup from __config__`__coalesce_ms__ and __config__`__max_rate__
+ *      __coalesce_ms__:  publications are delivered at the end of the window,
+ *                        only the latest kw by event.
+ *      __max_rate__:     maximum deliveries by second, a publication is delivered
+ *                        at once if the interval is elapsed, else coalesced.
  ***************************************************************************/
-PUBLIC dl_list_t *gobj_find_subscribings(
-    hgobj subscriber_,
-    const char *event,
-    json_t *kw,             // kw (__config__, __global__, __local__, __filter__)
-    hgobj publisher
-)
+PRIVATE int subs_throttle_setup(subscription_t *sub)
 {
-    GObj_t * subscriber = subscriber_;
-    return _find_subscription(&subscriber->dl_subscribings, publisher, event, kw, subscriber, FALSE);
+    json_int_t coalesce_ms = 0;
+    double max_rate = 0;
+    json_t *__config__ = sdata_read_json(sub->subs, "__config__");
+    if(__config__) {
+        coalesce_ms = kw_get_int(__config__, "__coalesce_ms__", 0, KW_WILD_NUMBER);
+        max_rate = kw_get_real(__config__, "__max_rate__", 0, KW_WILD_NUMBER);
+    }
+    uint64_t interval_ms = coalesce_ms > 0? (uint64_t)coalesce_ms : 0;
+    if(max_rate > 0) {
+        uint64_t rate_ms = (uint64_t)(1000.0 / max_rate);
+        if(rate_ms == 0) {
+            rate_ms = 1;
+        }
+        if(rate_ms > interval_ms) {
+            interval_ms = rate_ms;
+        }
+    }
+
+    if(!interval_ms) {
+        if(sub->throttle) {
+            subs_throttle_free(sub->throttle);
+            sub->throttle = 0;
+        }
+        return 0;
+    }
+    if(sub->throttle) {
+        sub->throttle->interval_ms = interval_ms;
+        sub->throttle->leading = coalesce_ms > 0? FALSE : TRUE;
+        return 0;
+    }
+
+    subs_throttle_t *throttle = gbmem_malloc(sizeof(subs_throttle_t));
+    if(!throttle) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for subscription throttle",
+            NULL
+        );
+        return -1;
+    }
+    throttle->timer.data = throttle;
+    throttle->sub = sub;
+    throttle->publisher = sdata_read_pointer(sub->subs, "publisher");
+    throttle->interval_ms = interval_ms;
+    throttle->leading = coalesce_ms > 0? FALSE : TRUE;
+    sub->throttle = throttle;
+    return 0;
 }
 
 /***************************************************************************
- *  Delete subscription
+ *  Throttle: a publication.
+ *  Return TRUE if it must be sent now,
+ *  FALSE if the kw is kept (owned) to be delivered by the timer.
  ***************************************************************************/
-PRIVATE int _delete_subscription(hsdata subs, BOOL force, BOOL not_inform)
+PRIVATE BOOL subs_throttle_publication(
+    subs_throttle_t *throttle,
+    const char *event,
+    json_t *kw)
 {
-    GObj_t * publisher = sdata_read_pointer(subs, "publisher");
-    GObj_t * subscriber = sdata_read_pointer(subs, "subscriber");
-    const char *event = sdata_read_str(subs, "event");
-    BOOL hard_subscription = (sdata_read_uint64(subs, "subs_flag") & __hard_subscription__)?1:0;
+    /*
+     *  The timer is created with the first publication,
+     *  the subscription can be done before gobj_start_event_queue()
+     */
+    if(!throttle->timer_init) {
+        if(!__event_queue_loop__) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+                "msg",          "%s", "__coalesce_ms__ and __max_rate__ require gobj_start_event_queue(), sent now",
+                "event",        "%s", event,
+                NULL
+            );
+            return TRUE;
+        }
+        uv_timer_init(__event_queue_loop__, &throttle->timer);
+        throttle->timer_init = TRUE;
+    }
+    uv_loop_t *loop = throttle->timer.loop;
+    uint64_t now = uv_now(loop);
 
-    /*-------------------------------*
-     *  Check if hard subscription
-     *-------------------------------*/
-    if(hard_subscription) {
-        if(!force) {
-            return -1;
+    if(throttle->leading && !throttle->n_pending &&
+            (!throttle->last_delivery || now - throttle->last_delivery >= throttle->interval_ms)) {
+        throttle->last_delivery = now;
+        return TRUE;
+    }
+
+    /*
+     *  Keep only the latest kw by event
+     */
+    event_id_t event_id = gobj_event_atom(event);
+    for(int i=0; i<throttle->n_pending; i++) {
+        if(throttle->pending[i].event_id == event_id) {
+            KW_DECREF(throttle->pending[i].kw);
+            throttle->pending[i].kw = kw;
+            return FALSE;
+        }
+    }
+    if(throttle->n_pending >= throttle->size_pending) {
+        int new_size = throttle->size_pending? throttle->size_pending * 2 : 2;
+        throttle_pending_t *new_pending = gbmem_malloc(sizeof(throttle_pending_t) * new_size);
+        if(!new_pending) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for throttle pending",
+                "event",        "%s", event,
+                NULL
+            );
+            return TRUE;
+        }
+        if(throttle->pending) {
+            memcpy(new_pending, throttle->pending, sizeof(throttle_pending_t) * throttle->n_pending);
+            gbmem_free(throttle->pending);
         }
+        throttle->pending = new_pending;
+        throttle->size_pending = new_size;
+    }
+    throttle->pending[throttle->n_pending].event_id = event_id;
+    throttle->pending[throttle->n_pending].kw = kw;
+    throttle->n_pending++;
+
+    if(!uv_is_active((uv_handle_t *)&throttle->timer)) {
+        uint64_t timeout = throttle->interval_ms;
+        if(throttle->leading) {
+            uint64_t elapsed = now - throttle->last_delivery;
+            timeout = elapsed < throttle->interval_ms? throttle->interval_ms - elapsed : 0;
+        }
+        uv_timer_start(&throttle->timer, on_throttle_timer, timeout, 0);
     }
+    return FALSE;
+}
 
-    /*-----------------------------*
-     *  Trace
-     *-----------------------------*/
-    if(__trace_gobj_subscriptions__(subscriber) || __trace_gobj_subscriptions__(publisher) ||
-        __trace_gobj_subscriptions2__(subscriber) || __trace_gobj_subscriptions2__(publisher)
-    ) {
-        trace_machine("💜💜👎 %s unsubscribing event '%s' of %s",
-            gobj_full_name(subscriber),
-            event,
-            gobj_full_name(publisher)
-        );
+/***************************************************************************
+ *  Free the native record
+ ***************************************************************************/
+PRIVATE void subscription_free(subscription_t *sub)
+{
+    if(sub) {
+        filter_prog_free(sub->filter_prog);
+        publish_plan_free(&sub->plan);
+        subs_throttle_free(sub->throttle);
+        gbmem_free(sub);
+    }
+}
 
-        if(1 || __trace_gobj_ev_kw__(subscriber) || __trace_gobj_ev_kw__(publisher)) {
-            json_t *kw_config = sdata_read_json(subs, "__config__");
-            json_t *kw_global = sdata_read_json(subs, "__global__");
-            json_t *kw_local = sdata_read_json(subs, "__local__");
-            json_t *jn_filter = sdata_read_json(subs, "__filter__");
-            json_t *kww = json_object();
-            if(kw_config) {
-                json_object_set(kww, "__config__", kw_config);
-            }
-            if(kw_global) {
-                json_object_set(kww, "__global__", kw_global);
-            }
-            if(kw_local) {
-                json_object_set(kww, "__local__", kw_local);
+/***************************************************************************
+ *  Is the event a pattern subscription? (prefix or glob with '*' and '?')
+ ***************************************************************************/
+PRIVATE BOOL is_event_pattern(const char *event)
+{
+    return (event && strpbrk(event, "*?"))? TRUE : FALSE;
+}
+
+/***************************************************************************
+ *  Glob matching, case-insensitive.
+ *  '*' matches any sequence, '?' matches any character.
+ ***************************************************************************/
+PRIVATE BOOL event_glob_match(const char *pattern, const char *event)
+{
+    const char *star = 0;
+    const char *retry = 0;
+
+    while(*event) {
+        if(*pattern == '*') {
+            star = pattern++;
+            retry = event;
+        } else if(*pattern == '?' ||
+                (*pattern && tolower((unsigned char)*pattern) == tolower((unsigned char)*event))) {
+            pattern++;
+            event++;
+        } else if(star) {
+            pattern = star + 1;
+            event = ++retry;
+        } else {
+            return FALSE;
+        }
+    }
+    while(*pattern == '*') {
+        pattern++;
+    }
+    return *pattern? FALSE : TRUE;
+}
+
+/***************************************************************************
+ *  Return the trie node of the literal prefix of the pattern
+ ***************************************************************************/
+PRIVATE subs_trie_node_t *subs_trie_node(
+    subs_index_t *subs_index,
+    const char *pattern,
+    BOOL create)
+{
+    if(!subs_index->trie) {
+        if(!create) {
+            return 0;
+        }
+        subs_index->trie = gbmem_malloc(sizeof(subs_trie_node_t));
+        if(!subs_index->trie) {
+            return 0;
+        }
+    }
+    subs_trie_node_t *node = subs_index->trie;
+    for(const char *p=pattern; *p && *p != '*' && *p != '?'; p++) {
+        char c = tolower((unsigned char)*p);
+        subs_trie_node_t *child = node->child;
+        while(child && child->c != c) {
+            child = child->sibling;
+        }
+        if(!child) {
+            if(!create) {
+                return 0;
             }
-            if(jn_filter) {
-                json_object_set(kww, "__filter__", jn_filter);
+            child = gbmem_malloc(sizeof(subs_trie_node_t));
+            if(!child) {
+                return 0;
             }
-            log_debug_json(0, kww, "kww");
-            json_decref(kww);
+            child->c = c;
+            child->sibling = node->child;
+            node->child = child;
         }
+        node = child;
     }
+    return node;
+}
 
-    /*------------------------------------------------*
-     *      Inform (BEFORE) of subscription removed
-     *------------------------------------------------*/
-    if(!(publisher->obflag & obflag_destroyed)) {
-        if(!not_inform) {
-            if(publisher->gclass->gmt.mt_subscription_deleted) {
-                publisher->gclass->gmt.mt_subscription_deleted(
-                    publisher,
-                    subs
-                );
+/***************************************************************************
+ *  Walk the trie along the event,
+ *  calling cb with the bucket of each node (prefix of event) with patterns.
+ *  Stop and return the first non zero return of cb.
+ ***************************************************************************/
+PRIVATE int subs_trie_walk(
+    subs_index_t *subs_index,
+    const char *event,
+    int (*cb)(subs_bucket_t *bucket, void *user_data),
+    void *user_data)
+{
+    subs_trie_node_t *node = subs_index->trie;
+    const char *p = event;
+    while(node) {
+        if(node->bucket.n > 0) {
+            int ret = cb(&node->bucket, user_data);
+            if(ret) {
+                return ret;
             }
         }
+        if(!*p) {
+            break;
+        }
+        char c = tolower((unsigned char)*p++);
+        subs_trie_node_t *child = node->child;
+        while(child && child->c != c) {
+            child = child->sibling;
+        }
+        node = child;
     }
+    return 0;
+}
 
-    /*--------------------------------*
-     *      Delete subscription
-     *--------------------------------*/
-    rc_delete_resource(subs, sdata_destroy);
+/***************************************************************************
+ *  Free the trie
+ ***************************************************************************/
+PRIVATE void subs_trie_free(subs_trie_node_t *node)
+{
+    while(node) {
+        subs_trie_node_t *sibling = node->sibling;
+        subs_trie_free(node->child);
+        subs_bucket_free(&node->bucket);
+        gbmem_free(node);
+        node = sibling;
+    }
+}
+PRIVATE void subs_trie_compact(subs_trie_node_t **link)
+{
+    while(*link) {
+        subs_trie_node_t *node = *link;
+        subs_trie_compact(&node->child);
+        subs_bucket_compact(&node->bucket);
+        if(!node->child && node->bucket.n == 0) {
+            *link = node->sibling;
+            subs_bucket_free(&node->bucket);
+            gbmem_free(node);
+        } else {
+            link = &node->sibling;
+        }
+    }
+}
+
+/***************************************************************************
+ *  Prune the empty leaf nodes along the literal prefix of the pattern.
+ *  Return TRUE if the node is empty, to be pruned by the caller.
+ ***************************************************************************/
+PRIVATE BOOL subs_trie_prune(subs_trie_node_t *node, const char *p)
+{
+    if(*p && *p != '*' && *p != '?') {
+        char c = tolower((unsigned char)*p);
+        subs_trie_node_t **link = &node->child;
+        while(*link && (*link)->c != c) {
+            link = &(*link)->sibling;
+        }
+        if(*link && subs_trie_prune(*link, p+1)) {
+            subs_trie_node_t *child = *link;
+            *link = child->sibling;
+            subs_bucket_free(&child->bucket);
+            gbmem_free(child);
+        }
+    }
+    return (!node->child && node->bucket.n == 0)? TRUE : FALSE;
+}
+PRIVATE void subs_trie_prune_pattern(subs_index_t *subs_index, const char *pattern)
+{
+    if(subs_index->trie && subs_trie_prune(subs_index->trie, pattern)) {
+        subs_bucket_free(&subs_index->trie->bucket);
+        GBMEM_FREE(subs_index->trie);
+    }
+}
 
+/***************************************************************************
+ *  Identity hash of a subscription: subscriber and event (case-insensitive)
+ ***************************************************************************/
+PRIVATE uint32_t subscription_id_hash(GObj_t *subscriber, const char *event)
+{
+    uint64_t h = 14695981039346656037ULL;   // FNV-1a
+    uintptr_t p = (uintptr_t)subscriber;
+    for(size_t i=0; i<sizeof(p); i++) {
+        h ^= (p >> (i*8)) & 0xFF;
+        h *= 1099511628211ULL;
+    }
+    for(const char *c=event? event : ""; *c; c++) {
+        h ^= (unsigned char)tolower((unsigned char)*c);
+        h *= 1099511628211ULL;
+    }
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+/***************************************************************************
+ *  Identity hash: add
+ ***************************************************************************/
+PRIVATE int subs_id_add(subs_index_t *subs_index, subscription_t *sub)
+{
+    if(subs_index->id_count >= (subs_index->id_slots? subs_index->id_mask + 1 : 0)) {
+        uint32_t new_size = subs_index->id_slots? (subs_index->id_mask + 1) * 2 : 16;
+        subscription_t **new_slots = gbmem_malloc(sizeof(subscription_t *) * new_size);
+        if(!new_slots) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for subscriptions identity hash",
+                NULL
+            );
+            return -1;
+        }
+        for(uint32_t i=0; subs_index->id_slots && i<=subs_index->id_mask; i++) {
+            subscription_t *s = subs_index->id_slots[i];
+            while(s) {
+                subscription_t *next = s->id_next;
+                subscription_t **slot = &new_slots[s->id_hash & (new_size - 1)];
+                s->id_prev = 0;
+                s->id_next = *slot;
+                if(*slot) {
+                    (*slot)->id_prev = s;
+                }
+                *slot = s;
+                s = next;
+            }
+        }
+        GBMEM_FREE(subs_index->id_slots);
+        subs_index->id_slots = new_slots;
+        subs_index->id_mask = new_size - 1;
+    }
+    sub->id_hash = subscription_id_hash(sub->subscriber, sub->event);
+    subscription_t **slot = &subs_index->id_slots[sub->id_hash & subs_index->id_mask];
+    sub->id_prev = 0;
+    sub->id_next = *slot;
+    if(*slot) {
+        (*slot)->id_prev = sub;
+    }
+    *slot = sub;
+    subs_index->id_count++;
     return 0;
 }
 
 /***************************************************************************
- *  Delete all subscriptions as subscriber
- *  WARNING Use only in destroying gobj
+ *  Identity hash: remove, O(1) with the chain back-pointer
  ***************************************************************************/
-PRIVATE int _delete_subscribings(GObj_t * subscriber)
+PRIVATE void subs_id_remove(subs_index_t *subs_index, subscription_t *sub)
 {
-    hsdata subs; rc_instance_t *i_subs;
+    if(sub->id_prev) {
+        sub->id_prev->id_next = sub->id_next;
+    } else {
+        subs_index->id_slots[sub->id_hash & subs_index->id_mask] = sub->id_next;
+    }
+    if(sub->id_next) {
+        sub->id_next->id_prev = sub->id_prev;
+    }
+    sub->id_next = sub->id_prev = 0;
+    subs_index->id_count--;
+}
 
-    while((i_subs=rc_first_instance(&subscriber->dl_subscribings, (rc_resource_t **)&subs))) {
-        rc_delete_resource(subs, sdata_destroy);
+/***************************************************************************
+ *  Load the native record from the subscription view
+ ***************************************************************************/
+PRIVATE int subscription_load(subscription_t *sub)
+{
+    hsdata subs = sub->subs;
+    const char *renamed_event = sdata_read_str(subs, "renamed_event");
+    const char *event = sdata_read_str(subs, "event");
+
+    filter_prog_free(sub->filter_prog);
+    sub->filter_prog = 0;
+    publish_plan_free(&sub->plan);
+    sub->subscriber = sdata_read_pointer(subs, "subscriber");
+    sub->renamed_event = empty_string(renamed_event)? 0 : renamed_event;
+    sub->event = event? event : "";
+    sub->pattern = is_event_pattern(sub->event)? sub->event : 0;
+    sub->subs_flag = sdata_read_uint64(subs, "subs_flag");
+    sub->__filter__ = sdata_read_json(subs, "__filter__");
+    sub->filter_prog = sub->__filter__? filter_prog_compile(sub->__filter__) : 0;
+
+    json_t *__global__ = sdata_read_json(subs, "__global__");
+    json_t *__local__ = sdata_read_json(subs, "__local__");
+    publish_plan_build(&sub->plan, sdata_read_json(subs, "__config__"), __global__, __local__);
+    if(subs_throttle_setup(sub) < 0) {
+        return -1;
     }
+    sub->changes_kw = (__local__ || __global__ || sub->plan.jn_trans_filters)?
+        TRUE : FALSE;
     return 0;
 }
 
 /***************************************************************************
- *  Delete all subscriptions as subscriber
- *  WARNING Use only in destroying gobj
+ *  Written the subscription view (by mt_subscription_added()): reload the record,
+ *  it points to the view's strings and jsons.
  ***************************************************************************/
-PRIVATE int _delete_subscriptions(GObj_t * publisher)
+PRIVATE int on_subscription_view_write(void *user_data, const char *name)
 {
-    hsdata subs; rc_instance_t *i_subs;
-
-    while((i_subs=rc_first_instance(&publisher->dl_subscriptions, (rc_resource_t **)&subs))) {
-        rc_delete_resource(subs, sdata_destroy);
+    subscription_t *sub = user_data;
+    if(sub) {
+        subscription_load(sub);
     }
     return 0;
 }
 
 /***************************************************************************
- *  Subscribe to an event
- *
- *  event is only one event (not a string list like ginsfsm).
- *
- *  IDEMPOTENT function
- *
- *  See .h
+ *  Add the subscription to the publisher's index
+ *  Return the native record
  ***************************************************************************/
-PUBLIC hsdata gobj_subscribe_event(
-    hgobj publisher_,
-    const char *event,
-    json_t *kw,
-    hgobj subscriber_)
+PRIVATE subscription_t *subs_index_add(GObj_t *publisher, hsdata subs, const char *event)
 {
-    GObj_t * publisher = publisher_;
-    GObj_t * subscriber = subscriber_;
+    static uint64_t subs_seq = 0;
 
-    /*---------------------*
-     *  Check something
-     *---------------------*/
-    if(!publisher) {
+    if(!publisher->subs_index) {
+        publisher->subs_index = gbmem_malloc(sizeof(subs_index_t));
+        if(!publisher->subs_index) {
+            log_error(0,
+                "gobj",         "%s", gobj_full_name(publisher),
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for subscriptions index",
+                NULL
+            );
+            return 0;
+        }
+    }
+    event_id_t event_id = 0;
+    subs_bucket_t *bucket = 0;
+    if(is_event_pattern(event)) {
+        subs_trie_node_t *node = subs_trie_node(publisher->subs_index, event, TRUE);
+        bucket = node? &node->bucket : 0;
+    } else {
+        event_id = empty_string(event)? 0 : gobj_event_atom(event);
+        bucket = subs_index_bucket(publisher->subs_index, event_id, TRUE);
+    }
+    if(!bucket) {
         log_error(0,
-            "gobj",         "%s", __FILE__,
+            "gobj",         "%s", gobj_full_name(publisher),
             "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "publisher NULL",
-            "event",        "%s", event?event:"",
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for subscriptions bucket",
+            "event",        "%s", event,
             NULL
         );
-        KW_DECREF(kw)
         return 0;
     }
-    if(!subscriber) {
+    if(bucket->n >= bucket->size) {
+        int new_size = bucket->size? bucket->size * 2 : 4;
+        subscription_t **new_entries = gbmem_malloc(sizeof(subscription_t *) * new_size);
+        if(!new_entries) {
+            log_error(0,
+                "gobj",         "%s", gobj_full_name(publisher),
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for subscriptions bucket",
+                "event",        "%s", event,
+                NULL
+            );
+            return 0;
+        }
+        if(bucket->entries) {
+            memcpy(new_entries, bucket->entries, sizeof(subscription_t *) * bucket->n);
+            gbmem_free(bucket->entries);
+        }
+        bucket->entries = new_entries;
+        bucket->size = new_size;
+    }
+    subscription_t *sub = gbmem_malloc(sizeof(subscription_t));
+    if(!sub) {
         log_error(0,
-            "gobj",         "%s", __FILE__,
+            "gobj",         "%s", gobj_full_name(publisher),
             "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "subscriber NULL",
-            "event",        "%s", event?event:"",
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for subscription",
+            "event",        "%s", event,
             NULL
         );
-        KW_DECREF(kw)
+        return 0;
+    }
+    sub->subs = subs;
+    sub->seq = ++subs_seq;
+    sub->event_id = event_id;
+    sub->filter_prog = 0;
+    memset(&sub->plan, 0, sizeof(publish_plan_t));
+    sub->throttle = 0;
+    if(subscription_load(sub) < 0) {
+        subscription_free(sub);
+        if(is_event_pattern(event) && bucket->n == 0) {
+            subs_trie_prune_pattern(publisher->subs_index, event);
+        }
         return 0;
     }
 
-    /*-------------------------------------------------*
-     *  Check AUTHZ
-     *-------------------------------------------------*/
-//     const EVENT *output_event = gobj_output_event(publisher, event);
-//         if(output_event->authz & EV_AUTHZ_SUBSCRIBE) {
-//             const char *event = output_event->event?output_event->event:"";
-//             /*
-//              *  AUTHZ Required
-//              */
-//             json_t *kw_authz = json_pack("{s:s}",
-//                 "event", event
-//             );
-//             if(kw) {
-//                 json_object_set(kw_authz, "kw", kw);
-//             } else {
-//                 json_object_set_new(kw_authz, "kw", json_object());
-//             }
-//             if(!gobj_user_has_authz(
-//                 publisher_,
-//                 "__subscribe_event__",
-//                 kw_authz,
-//                 subscriber_
-//             )) {
-//                 log_error(0,
-//                     "gobj",         "%s", gobj_full_name(publisher_),
-//                     "function",     "%s", __FUNCTION__,
-//                     "msgset",       "%s", MSGSET_OAUTH_ERROR,
-//                     "msg",          "%s", "No permission to subscribe event",
-//                     //"user",         "%s", gobj_get_user(subscriber_),
-//                     "gclass",       "%s", gobj_gclass_name(publisher_),
-//                     "event",        "%s", event?event:"",
-//                     NULL
-//                 );
-//                 KW_DECREF(kw)
-//                 return 0;
-//             }
-//         }
-//         output_event_list++;
-//     }
-
-    /*-------------------------------------------------*
-     *
-     *-------------------------------------------------*/
-    if(empty_string(event) || strchr(event, '*')) {
-        event = "";
-    }
-
-    /*--------------------------------------------------------------*
-     *  Event must be in output event list
-     *  You can avoid this with gcflag_no_check_output_events flag
-     *--------------------------------------------------------------*/
-    if(!empty_string(event)) {
-        if(!(publisher->gclass->gcflag & gcflag_no_check_output_events)) {
-            const EVENT *output_event = gobj_output_event(publisher, event);
-            if(!output_event) {
-                log_error(0,
-                    "gobj",         "%s", __FILE__,
-                    "function",     "%s", __FUNCTION__,
-                    "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-                    "msg",          "%s", "event NOT in output event list",
-                    "event",        "%s", event,
-                    "publisher",    "%s", gobj_full_name(publisher),
-                    "subscriber",   "%s", gobj_full_name(subscriber),
-                    NULL
-                );
-            }
+    if(subs_id_add(publisher->subs_index, sub) < 0) {
+        subscription_free(sub);
+        if(is_event_pattern(event) && bucket->n == 0) {
+            subs_trie_prune_pattern(publisher->subs_index, event);
         }
-    }
-
-    /*------------------------------*
-     *  Find repeated subscription
-     *------------------------------*/
-    KW_INCREF(kw);
-    dl_list_t *dl_subs = _find_subscription(
-        &publisher->dl_subscriptions,
-        publisher,
-        event,
-        kw,
-        subscriber,
-        TRUE
-    );
-    int size = rc_iter_size(dl_subs);
-    if(size > 0) {
-        log_warning(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "subscription(s) REPEATED, will be deleted and override",
-            "event",        "%s", event,
-            "publisher",    "%s", gobj_full_name(publisher),
-            "subscriber",   "%s", gobj_full_name(subscriber),
-            NULL
-        );
-        gobj_unsubscribe_list(dl_subs, FALSE, FALSE);
-    }
-    rc_free_iter(dl_subs, TRUE, 0);
-
-    /*-----------------------------*
-     *  Create subscription
-     *-----------------------------*/
-    hsdata subs = _create_subscription(
-        publisher,
-        event,
-        kw,  // not owned
-        subscriber
-    );
-    if(!subs) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "_create_subscription() FAILED",
-            "event",        "%s", event?event:"*",
-            "publisher",    "%s", gobj_full_name(publisher),
-            "subscriber",   "%s", gobj_full_name(subscriber),
-            NULL
-        );
-        KW_DECREF(kw)
         return 0;
     }
-    rc_add_instance(&publisher->dl_subscriptions, subs, 0);
-    rc_add_instance(&subscriber->dl_subscribings, subs, 0);
 
-    /*-----------------------------*
-     *  Trace
-     *-----------------------------*/
-    if(__trace_gobj_subscriptions__(subscriber) || __trace_gobj_subscriptions__(publisher) ||
-        __trace_gobj_subscriptions2__(subscriber) || __trace_gobj_subscriptions2__(publisher)
-    ) {
-        trace_machine("💜💜👍 %s subscribing event '%s' of %s",
-            gobj_full_name(subscriber),
-            event?event:"*",
-            gobj_full_name(publisher)
-        );
-        if(kw) {
-            if(1 || __trace_gobj_ev_kw__(subscriber) || __trace_gobj_ev_kw__(publisher)) {
-                log_debug_json(0, kw, "kw");
-            }
+    sub->bucket = bucket;
+    sub->pos = bucket->n;
+    bucket->entries[bucket->n] = sub;
+    bucket->n++;
+    sdata_set_user_data(subs, sub);
+    return sub;
+}
+
+/***************************************************************************
+ *  Remove the holes of subscriptions removed while publishing
+ ***************************************************************************/
+PRIVATE void subs_bucket_compact(subs_bucket_t *bucket)
+{
+    int j = 0;
+    for(int i=0; i<bucket->n; i++) {
+        if(bucket->entries[i]) {
+            bucket->entries[j] = bucket->entries[i];
+            bucket->entries[j]->pos = j;
+            j++;
         }
     }
-
-    /*--------------------------------*
-     *      Inform new subscription
-     *--------------------------------*/
-    if(publisher->gclass->gmt.mt_subscription_added) {
-        int result = publisher->gclass->gmt.mt_subscription_added(
-            publisher,
-            subs
-        );
-        if(result < 0) {
-            _delete_subscription(subs, TRUE, TRUE);
-            subs = 0;
+    bucket->n = j;
+    bucket->holes = 0;
+}
+PRIVATE void subs_index_compact(subs_index_t *subs_index)
+{
+    subs_bucket_compact(&subs_index->catch_all);
+    for(uint32_t i=0; subs_index->slots && i<=subs_index->mask; i++) {
+        if(subs_index->slots[i]) {
+            subs_bucket_compact(subs_index->slots[i]);
         }
     }
-
-    KW_DECREF(kw)
-    return subs;
+    subs_trie_compact(&subs_index->trie);
+    subs_index->tombstones = 0;
 }
 
 /***************************************************************************
- *
+ *  Remove the subscription from the publisher's index
  ***************************************************************************/
-PUBLIC int gobj_unsubscribe_event(
-    hgobj publisher_,
-    const char *event,
-    json_t *kw,
-    hgobj subscriber_)
+PRIVATE void subs_index_remove(GObj_t *publisher, hsdata subs)
 {
-    GObj_t * publisher = publisher_;
-    GObj_t * subscriber = subscriber_;
-
-    /*---------------------*
-     *  Check something
-     *---------------------*/
-    if(!publisher) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "publisher NULL",
-            "event",        "%s", event?event:"",
-            NULL
-        );
-        KW_DECREF(kw)
-        return -1;
-    }
-    if(!subscriber) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "subscriber NULL",
-            "event",        "%s", event?event:"",
-            NULL
-        );
-        KW_DECREF(kw)
-        return -1;
-    }
-
-    /*-------------------------------------------------*
-     *
-     *-------------------------------------------------*/
-    if(empty_string(event) || strchr(event, '*')) {
-        event = "";
+    if(!publisher || !publisher->subs_index) {
+        return;
     }
-
-    /*-----------------------------*
-     *      Find subscription
-     *-----------------------------*/
-    KW_INCREF(kw);
-    dl_list_t *dl_subs = _find_subscription(
-        &publisher->dl_subscriptions,
-        publisher,
-        event,
-        kw,
-        subscriber,
-        TRUE
-    );
-    int deleted = 0;
-    hsdata subs; rc_instance_t *i_subs;
-    i_subs = rc_first_instance(dl_subs, (rc_resource_t **)&subs);
-    while(i_subs) {
-        hsdata next_subs; rc_instance_t *next_i_subs;
-        next_i_subs = rc_next_instance(i_subs, (rc_resource_t **)&next_subs);
-
-        _delete_subscription(subs, 0, 0);
-        deleted++;
-
-        i_subs = next_i_subs;
-        subs = next_subs;
+    subs_index_t *subs_index = publisher->subs_index;
+    subscription_t *sub = sdata_user_data(subs); // back-pointer to the native record
+    if(!sub || sub->subs != subs) {
+        return;
     }
+    sdata_set_user_data(subs, 0);
+    subs_id_remove(subs_index, sub);
 
-    if(!deleted) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj_unsubscribe_event() NO SUBCRIPTION FOUND",
-            "event",        "%s", event,
-            "publisher",    "%s", gobj_full_name(publisher),
-            "subscriber",   "%s", gobj_full_name(subscriber),
-            NULL
-        );
-        log_debug_json(0, kw, "gobj_unsubscribe_event() NO SUBCRIPTION FOUND");
+    /*
+     *  Leave a hole, don't move the entries (maybe under the publishing loop)
+     */
+    subs_bucket_t *bucket = sub->bucket;
+    bucket->entries[sub->pos] = 0;
+    bucket->holes++;
+
+    if(subs_index->publishing) {
+        subs_index->tombstones++;
+    } else if(bucket->holes * 2 >= bucket->n) {
+        subs_bucket_compact(bucket);
+        if(sub->pattern && bucket->n == 0) {
+            subs_trie_prune_pattern(subs_index, sub->pattern);
+        }
     }
-    rc_free_iter(dl_subs, TRUE, sdata_destroy);
-
-    KW_DECREF(kw)
-    return 0;
+    subscription_free(sub);
 }
 
 /***************************************************************************
- *
+ *  Free the publisher's index
  ***************************************************************************/
-PUBLIC int gobj_unsubscribe_event2(
-    hsdata subs
-)
+PRIVATE void subs_bucket_free(subs_bucket_t *bucket)
 {
-    return _delete_subscription(subs, 0, 0);
+    for(int i=0; i<bucket->n; i++) {
+        subscription_free(bucket->entries[i]);
+        bucket->entries[i] = 0;
+    }
+    GBMEM_FREE(bucket->entries);
+    bucket->n = bucket->size = 0;
+}
+PRIVATE void subs_index_free(GObj_t *publisher)
+{
+    subs_index_t *subs_index = publisher->subs_index;
+    if(!subs_index) {
+        return;
+    }
+    subs_bucket_free(&subs_index->catch_all);
+    for(uint32_t i=0; subs_index->slots && i<=subs_index->mask; i++) {
+        subs_bucket_t *bucket = subs_index->slots[i];
+        if(bucket) {
+            subs_bucket_free(bucket);
+            GBMEM_FREE(bucket);
+        }
+    }
+    GBMEM_FREE(subs_index->slots);
+    GBMEM_FREE(subs_index->id_slots);
+    subs_trie_free(subs_index->trie);
+    GBMEM_FREE(publisher->subs_index);
 }
 
 /***************************************************************************
- *  Unsubscribe a list of subscription hsdata
+ *  Add a cursor of a bucket, counting if there is no room
  ***************************************************************************/
-PUBLIC int gobj_unsubscribe_list(
-    dl_list_t *dl_subs, // iter of subscription hsdata
-    BOOL free_iter,
-    BOOL force  // delete hard_subscription subs too
-)
+PRIVATE int cb_add_cursor(subs_bucket_t *bucket, void *user_data)
 {
-    hsdata subs; rc_instance_t *i_subs;
-    i_subs = rc_first_instance(dl_subs, (rc_resource_t **)&subs);
-    while(i_subs) {
-        hsdata next_subs; rc_instance_t *next_i_subs;
-        next_i_subs = rc_next_instance(i_subs, (rc_resource_t **)&next_subs);
-
-        _delete_subscription(subs, force, 0);
-
-        i_subs = next_i_subs;
-        subs = next_subs;
-    }
-    if(free_iter) {
-        rc_free_iter(dl_subs, TRUE, sdata_destroy);
+    subs_cursors_t *cursors = user_data;
+    if(cursors->n < cursors->size) {
+        subs_cursor_t *c = &cursors->cursors[cursors->n];
+        c->bucket = bucket;
+        c->n = bucket->n;
+        c->i = 0;
+        c->pattern = FALSE;
     }
+    cursors->n++;
     return 0;
 }
 
 /***************************************************************************
- *  Set funtion to be applied in Selection Filter __filter__
- *  Default is kw_match_simple()
- *  Return old function
+ *  Collect the cursors of a publication:
+ *  the event bucket, the catch-all bucket and the pattern buckets.
+ *  The cursors are allocated if they don't fit in the given ones.
  ***************************************************************************/
-PUBLIC kw_match_fn gobj_set_publication_selection_filter_fn(kw_match_fn kw_match)
+PRIVATE void subs_cursors_collect(
+    subs_index_t *subs_index,
+    const char *event,
+    event_id_t event_id,    // atom of event, 0 if it's not interned
+    subs_cursors_t *cursors)
 {
-    kw_match_fn old_fn = __publish_event_match__;
-    __publish_event_match__ = kw_match;
-    return old_fn;
+    subs_bucket_t *bucket = event_id? subs_index_bucket(subs_index, event_id, FALSE) : 0;
+
+    for(int pass=0; pass<2; pass++) {
+        cursors->n = 0;
+        if(bucket && bucket->n > 0) {
+            cb_add_cursor(bucket, cursors);
+        }
+        if(subs_index->catch_all.n > 0) {
+            cb_add_cursor(&subs_index->catch_all, cursors);
+        }
+        int n_fixed = cursors->n;
+        if(subs_index->trie) {
+            subs_trie_walk(subs_index, event, cb_add_cursor, cursors);
+        }
+        for(int k=n_fixed; k<cursors->n && k<cursors->size; k++) {
+            cursors->cursors[k].pattern = TRUE;
+        }
+        if(cursors->n <= cursors->size) {
+            return;
+        }
+        subs_cursor_t *new_cursors = gbmem_malloc(sizeof(subs_cursor_t) * cursors->n);
+        if(!new_cursors) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for publication cursors",
+                "event",        "%s", event,
+                NULL
+            );
+            cursors->n = cursors->size;
+            return;
+        }
+        cursors->cursors = new_cursors;
+        cursors->size = cursors->n;
+    }
 }
 
 /***************************************************************************
- *  Add transformation filter function,
- *  to be applied with __config__`__trans_filter__
+ *  Has the bucket a pattern matching the event?
  ***************************************************************************/
-PUBLIC int gobj_add_publication_transformation_filter_fn(
-    const char *name,
-    json_t * (*transformation_fn)(
-        json_t *kw // owned
-    )
-)
+PRIVATE int cb_pattern_matched(subs_bucket_t *bucket, void *user_data)
 {
-    return register_transformation_filter(name, transformation_fn);
+    const char *event = user_data;
+    for(int i=0; i<bucket->n; i++) {
+        subscription_t *sub = bucket->entries[i];
+        if(sub && event_glob_match(sub->pattern, event)) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
 /***************************************************************************
- *  Apply transformation filter functions
- *  from __config__`__trans_filter__
+ *  Has the publisher subscriptions that can receive the event?
  ***************************************************************************/
-PRIVATE json_t *apply_trans(json_t *kw, const char *name)
+PRIVATE BOOL subs_index_has_subscribers(GObj_t *publisher, const char *event)
 {
-    if(!name) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "name NULL",
-            NULL
-        );
-        return 0;
+    subs_index_t *subs_index = publisher->subs_index;
+    if(!subs_index) {
+        return FALSE;
+    }
+    if(subs_index->catch_all.n - subs_index->catch_all.holes > 0) {
+        return TRUE;
     }
+    event_id_t event_id = gobj_find_event_atom(event);
+    subs_bucket_t *bucket = event_id? subs_index_bucket(subs_index, event_id, FALSE) : 0;
+    if(bucket && bucket->n - bucket->holes > 0) {
+        return TRUE;
+    }
+    if(subs_index->trie && subs_trie_walk(subs_index, event, cb_pattern_matched, (void *)event)) {
+        return TRUE;
+    }
+    return FALSE;
+}
 
-    trans_filter_t *trans_reg = dl_first(&dl_trans_filter);
-    while(trans_reg) {
-        if(trans_reg->name) {
-            if(strcasecmp(trans_reg->name, name)==0) {
-                return trans_reg->transformation_fn(kw);
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE hsdata _create_subscription(
+    GObj_t * publisher,
+    const char *event,
+    json_t *kw, // not owned
+    GObj_t * subscriber)
+{
+    hsdata subs = sdata_create(subscription_desc, 0, on_subscription_view_write, 0, 0, 0);
+    sdata_write_str(subs, "event", event);
+    sdata_write_pointer(subs, "subscriber", subscriber);
+    sdata_write_pointer(subs, "publisher", publisher);
+    subs_flag_t subs_flag = 0;
+
+    if(kw) {
+        json_t *__config__ = kw_get_dict(kw, "__config__", 0, 0);
+        json_t *__global__ = kw_get_dict(kw, "__global__", 0, 0);
+        json_t *__local__ = kw_get_dict(kw, "__local__", 0, 0);
+        json_t *__filter__ = kw_get_dict_value(kw, "__filter__", 0, 0);
+        const char *__service__ = kw_get_str(kw, "__service__", 0, 0);
+
+        if(__global__) { // HACK __global__ the first. __config__ can write in this area.
+            json_t *kw_clone = kw_duplicate(__global__);
+            sdata_write_json(subs, "__global__", kw_clone); // Incref
+            kw_decref(kw_clone); // Incref above
+        }
+        if(__config__) {
+            json_t *kw_clone = kw_duplicate(__config__);
+            sdata_write_json(subs, "__config__", kw_clone); // Incref
+            kw_decref(kw_clone); // Incref above
+            if(kw_has_key(kw_clone, "__rename_event_name__")) {
+                const char *renamed_event = kw_get_str(kw_clone, "__rename_event_name__", 0, 0);
+                sdata_write_str(subs, "renamed_event", renamed_event);
+                json_object_del(kw_clone, "__rename_event_name__");
+                subs_flag |= __rename_event_name__;
+
+                // Get/Create __global__
+                json_t *kw_global = sdata_read_json(subs, "__global__");
+                if(!kw_global) {
+                    kw_global = json_object();
+                    sdata_write_json(subs, "__global__", kw_global);
+                    kw_decref(kw_global); // Incref above
+                }
+                kw_set_dict_value(
+                    kw_global,
+                    "__original_event_name__",
+                    json_string(event)
+                );
+            }
+            if(kw_has_key(kw_clone, "__hard_subscription__")) {
+                BOOL hard_subscription = kw_get_bool(kw_clone, "__hard_subscription__", 0, 0);
+                json_object_del(kw_clone, "__hard_subscription__");
+                if(hard_subscription) {
+                    subs_flag |= __hard_subscription__;
+                }
+            }
+            if(kw_has_key(kw_clone, "__first_shot__")) {
+                BOOL first_short = kw_get_bool(kw_clone, "__first_short__", 0, 0);
+                // don't delete, external use
+                if(first_short) {
+                    subs_flag |= __first_shot__;
+                }
+            }
+            if(kw_has_key(kw_clone, "__share_kw__")) {
+                BOOL share_kw = kw_get_bool(kw_clone, "__share_kw__", 0, 0);
+                json_object_del(kw_clone, "__share_kw__");
+                if(share_kw) {
+                    subs_flag |= __share_kw__;
+                }
+            }
+            if(kw_has_key(kw_clone, "__cow_kw__")) {
+                BOOL cow_kw = kw_get_bool(kw_clone, "__cow_kw__", 0, 0);
+                json_object_del(kw_clone, "__cow_kw__");
+                if(cow_kw) {
+                    subs_flag |= __cow_kw__;
+                }
+            }
+            if(kw_has_key(kw_clone, "__own_event__")) {
+                BOOL own_event= kw_get_bool(kw_clone, "__own_event__", 0, 0);
+                json_object_del(kw_clone, "__own_event__");
+                if(own_event) {
+                    subs_flag |= __own_event__;
+                }
             }
         }
-        trans_reg = dl_next(trans_reg);
+        if(__local__) {
+            json_t *kw_clone = kw_duplicate(__local__);
+            sdata_write_json(subs, "__local__", kw_clone); // Incref
+            kw_decref(kw_clone); // Incref above
+        }
+        if(__filter__) {
+            json_t *kw_clone = kw_duplicate(__filter__);
+            sdata_write_json(subs, "__filter__", kw_clone); // Incref
+            kw_decref(kw_clone); // Incref above
+        }
+        if(__service__) {
+            sdata_write_str(subs, "__service__", __service__);
+        }
     }
-    log_error(0,
-        "gobj",         "%s", "__yuno__",
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "trans filter NOT FOUND",
-        "name",         "%s", name?name:"",
-        NULL
-    );
 
-    return kw;
+    return subs;
 }
 
 /***************************************************************************
- *  Apply transformation filter functions
- *  from __config__`__trans_filter__
+ *  Match the kw dicts (__config__, __global__, __local__, __filter__)
+ *  of a subscription, strict (identical) or with kw_match_simple()
  ***************************************************************************/
-PRIVATE json_t *apply_trans_filters(json_t *kw, json_t *jn_trans_filters)
+PRIVATE BOOL subscription_match_kw(
+    hsdata subs,
+    json_t *__config__,
+    json_t *__global__,
+    json_t *__local__,
+    json_t *__filter__,
+    BOOL strict)
 {
-    if(!jn_trans_filters) {
-        return kw;
+    BOOL (*_match)(json_t *, json_t *) = 0;
+    if(strict) {
+        _match = kw_is_identical; // WARNING don't decref anything
+    } else {
+        _match = kw_match_simple; // WARNING decref second parameter
     }
 
-    if(json_is_object(jn_trans_filters)) {
-        const char *key;
-        json_t *jn_value;
-        json_object_foreach(jn_trans_filters, key, jn_value) {
-            kw = apply_trans(kw, key);
+    BOOL match = TRUE;
+    if(__config__) {
+        json_t *kw_config = sdata_read_json(subs, "__config__");
+        if(kw_config) {
+            if(!strict) { // HACK decref when calling _match (kw_match_simple)
+                KW_INCREF(__config__);
+            }
+            if(!_match(kw_config, __config__)) {
+                match = FALSE;
+            }
+        } else {
+            match = FALSE;
         }
-    } else if(json_is_array(jn_trans_filters)) {
-        size_t index;
-        json_t *jn_value;
-        json_array_foreach(jn_trans_filters, index, jn_value) {
-            kw = apply_trans_filters(kw, jn_value);
+    }
+    if(__global__) {
+        json_t *kw_global = sdata_read_json(subs, "__global__");
+        if(kw_global) {
+            if(!strict) { // HACK decref when calling _match (kw_match_simple)
+                KW_INCREF(__global__);
+            }
+            if(!_match(kw_global, __global__)) {
+                match = FALSE;
+            }
+        } else {
+            match = FALSE;
+        }
+    }
+    if(__local__) {
+        json_t *kw_local = sdata_read_json(subs, "__local__");
+        if(kw_local) {
+            if(!strict) { // HACK decref when calling _match (kw_match_simple)
+                KW_INCREF(__local__);
+            }
+            if(!_match(kw_local, __local__)) {
+                match = FALSE;
+            }
+        } else {
+            match = FALSE;
+        }
+    }
+    if(__filter__) {
+        json_t *jn_filter = sdata_read_json(subs, "__filter__");
+        if(jn_filter) {
+            if(!strict) { // HACK decref when calling _match (kw_match_simple)
+                KW_INCREF(__filter__);
+            }
+            if(!_match(jn_filter, __filter__)) {
+                match = FALSE;
+            }
+        } else {
+            match = FALSE;
         }
-    } else if(json_is_string(jn_trans_filters)) {
-        kw = apply_trans(kw, json_string_value(jn_trans_filters));
     }
 
-    return kw;
+    return match;
 }
 
 /***************************************************************************
- *  Return the number of sent events
+ *  Return a iter of subscriptions (sdata),
+ *  filtering by matching:
+ *      event,kw (__config__, __global__, __local__, __filter__),subscriber
+ *  Free return with rc_free_iter(iter, TRUE, FALSE);
  ***************************************************************************/
-PUBLIC int gobj_publish_event(
-    hgobj publisher_,
+PRIVATE dl_list_t * _find_subscription(
+    dl_list_t *dl_subs,
+    GObj_t * publisher,
     const char *event,
-    json_t *kw)
+    json_t *kw, // owned
+    GObj_t * subscriber,
+    BOOL strict)
 {
-    GObj_t * publisher = publisher_;
+    dl_list_t *iter = rc_init_iter(NULL);
+    json_t *__config__ = kw_get_dict(kw, "__config__", 0, 0);
+    json_t *__global__ = kw_get_dict(kw, "__global__", 0, 0);
+    json_t *__local__ = kw_get_dict(kw, "__local__", 0, 0);
+    json_t *__filter__ = kw_get_dict_value(kw, "__filter__", 0, 0);
 
-    if(!kw) {
-        kw = json_object();
-    }
+    hsdata subs;
+    rc_instance_t *i_subs = rc_first_instance(dl_subs, (rc_resource_t **)&subs);
+    while(i_subs) {
+        hsdata next_subs; rc_instance_t *next_i_subs;
+        next_i_subs = rc_next_instance(i_subs, (rc_resource_t **)&next_subs);
 
-    /*---------------------*
-     *  Check something
-     *---------------------*/
-    if(!publisher) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
-            NULL
-        );
-        KW_DECREF(kw)
-        return 0;
-    }
-    if(publisher->obflag & obflag_destroyed) {
-        log_error(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj DESTROYED",
-            NULL
-        );
-        KW_DECREF(kw)
-        return 0;
-    }
-    if(empty_string(event)) {
-        log_error(0,
-            "gobj",         "%p", gobj_full_name(publisher),
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "event EMPTY",
-            NULL
-        );
-        KW_DECREF(kw)
-        return 0;
-    }
+        BOOL match = TRUE;
 
-    /*--------------------------------------------------------------*
-     *  Event must be in output event list
-     *  You can avoid this with gcflag_no_check_output_events flag
-     *--------------------------------------------------------------*/
+        if(publisher) {
+            GObj_t *publisher_  = sdata_read_pointer(subs, "publisher");
+            if(publisher != publisher_) {
+                match = FALSE;
+            }
+        }
+
+        if(subscriber) {
+            GObj_t *subscriber_  = sdata_read_pointer(subs, "subscriber");
+            if(subscriber != subscriber_) {
+                match = FALSE;
+            }
+        }
+
+        if(event) {
+            const char *event_ = sdata_read_str(subs, "event");
+            if(!event_ || strcasecmp(event, event_)!=0) {
+                match = FALSE;
+            }
+        }
+
+        if(match) {
+            match = subscription_match_kw(subs, __config__, __global__, __local__, __filter__, strict);
+        }
+
+        if(match) {
+            rc_add_instance(iter, subs, 0);
+        }
+
+        i_subs = next_i_subs;
+        subs = next_subs;
+    }
+
+    KW_DECREF(kw)
+    return iter;
+}
+
+/***************************************************************************
+ *  Return a iter of the subscriptions of the publisher
+ *  with the same subscriber and event, and identical kw dicts.
+ *  Same result as _find_subscription() strict, with the identity hash.
+ *  Free return with rc_free_iter(iter, TRUE, FALSE);
+ ***************************************************************************/
+PRIVATE dl_list_t *_find_identical_subscription(
+    GObj_t * publisher,
+    const char *event,
+    json_t *kw, // owned
+    GObj_t * subscriber)
+{
+    subs_index_t *subs_index = publisher->subs_index;
+    if(!subs_index || !subs_index->id_slots) {
+        KW_DECREF(kw)
+        return rc_init_iter(NULL);
+    }
+
+    dl_list_t *iter = rc_init_iter(NULL);
+    json_t *__config__ = kw_get_dict(kw, "__config__", 0, 0);
+    json_t *__global__ = kw_get_dict(kw, "__global__", 0, 0);
+    json_t *__local__ = kw_get_dict(kw, "__local__", 0, 0);
+    json_t *__filter__ = kw_get_dict_value(kw, "__filter__", 0, 0);
+
+    uint32_t id_hash = subscription_id_hash(subscriber, event);
+    subscription_t *sub = subs_index->id_slots[id_hash & subs_index->id_mask];
+    while(sub) {
+        if(sub->id_hash == id_hash &&
+                sub->subscriber == subscriber &&
+                strcasecmp(sub->event, event)==0 &&
+                subscription_match_kw(sub->subs, __config__, __global__, __local__, __filter__, TRUE)) {
+            rc_add_instance(iter, sub->subs, 0);
+        }
+        sub = sub->id_next;
+    }
+
+    KW_DECREF(kw)
+    return iter;
+}
+
+/***************************************************************************
+ *  Return the schema of subcriptions hsdata
+ ***************************************************************************/
+PUBLIC const sdata_desc_t *gobj_subscription_schema(void)
+{
+    return subscription_desc;
+}
+
+/***************************************************************************
+ *  Return number of subcriptions
+ ***************************************************************************/
+PUBLIC size_t gobj_subscriptions_size(
+    hgobj publisher_
+)
+{
+    GObj_t * publisher = publisher_;
+    return dl_size(&publisher->dl_subscriptions);
+}
+
+/***************************************************************************
+ *  Return number of subcribings
+ ***************************************************************************/
+PUBLIC size_t gobj_subscribings_size(hgobj subscriber_)
+{
+    GObj_t * subscriber = subscriber_;
+    return dl_size(&subscriber->dl_subscribings);
+}
+
+/***************************************************************************
+ *  Return a iter of subscriptions (sdata) in the publisher gobj,
+ *  filtering by matching: event,kw (__config__, __global__, __local__, __filter__),subscriber
+ *  Free return with rc_free_iter(iter, TRUE, FALSE);
+ ***************************************************************************/
+PUBLIC dl_list_t * gobj_find_subscriptions(
+    hgobj publisher_,
+    const char *event,
+    json_t *kw,
+    hgobj subscriber)
+{
+    GObj_t * publisher = publisher_;
+    return _find_subscription(&publisher->dl_subscriptions, publisher_, event, kw, subscriber, FALSE);
+}
+
+/***************************************************************************
+ *  Return a iter of subscribings (sdata) of the subcriber gobj,
+ *  filtering by matching: event,kw (__config__, __global__, __local__, __filter__), publisher
+ *  Free return with rc_free_iter(iter, TRUE, FALSE);
+ ***************************************************************************/
+PUBLIC dl_list_t *gobj_find_subscribings(
+    hgobj subscriber_,
+    const char *event,
+    json_t *kw,             // kw (__config__, __global__, __local__, __filter__)
+    hgobj publisher
+)
+{
+    GObj_t * subscriber = subscriber_;
+    return _find_subscription(&subscriber->dl_subscribings, publisher, event, kw, subscriber, FALSE);
+}
+
+/***************************************************************************
+ *  Delete subscription
+ ***************************************************************************/
+PRIVATE int _delete_subscription(hsdata subs, BOOL force, BOOL not_inform)
+{
+    GObj_t * publisher = sdata_read_pointer(subs, "publisher");
+    subscription_t *sub = sdata_user_data(subs); // native record, 0 if not indexed
+    GObj_t * subscriber = sub? sub->subscriber : sdata_read_pointer(subs, "subscriber");
+    const char *event = sub? sub->event : sdata_read_str(subs, "event");
+    subs_flag_t subs_flag = sub? sub->subs_flag : sdata_read_uint64(subs, "subs_flag");
+    BOOL hard_subscription = (subs_flag & __hard_subscription__)?1:0;
+
+    /*-------------------------------*
+     *  Check if hard subscription
+     *-------------------------------*/
+    if(hard_subscription) {
+        if(!force) {
+            return -1;
+        }
+    }
+
+    /*-----------------------------*
+     *  Trace
+     *-----------------------------*/
+    if(__trace_gobj_subscriptions__(subscriber) || __trace_gobj_subscriptions__(publisher) ||
+        __trace_gobj_subscriptions2__(subscriber) || __trace_gobj_subscriptions2__(publisher)
+    ) {
+        trace_machine("💜💜👎 %s unsubscribing event '%s' of %s",
+            gobj_full_name(subscriber),
+            event,
+            gobj_full_name(publisher)
+        );
+
+        if(1 || __trace_gobj_ev_kw__(subscriber) || __trace_gobj_ev_kw__(publisher)) {
+            json_t *kw_config = sdata_read_json(subs, "__config__");
+            json_t *kw_global = sdata_read_json(subs, "__global__");
+            json_t *kw_local = sdata_read_json(subs, "__local__");
+            json_t *jn_filter = sdata_read_json(subs, "__filter__");
+            json_t *kww = json_object();
+            if(kw_config) {
+                json_object_set(kww, "__config__", kw_config);
+            }
+            if(kw_global) {
+                json_object_set(kww, "__global__", kw_global);
+            }
+            if(kw_local) {
+                json_object_set(kww, "__local__", kw_local);
+            }
+            if(jn_filter) {
+                json_object_set(kww, "__filter__", jn_filter);
+            }
+            log_debug_json(0, kww, "kww");
+            json_decref(kww);
+        }
+    }
+
+    /*------------------------------------------------*
+     *      Inform (BEFORE) of subscription removed
+     *------------------------------------------------*/
+    if(!(publisher->obflag & obflag_destroyed)) {
+        if(!not_inform) {
+            if(publisher->gclass->gmt.mt_subscription_deleted) {
+                publisher->gclass->gmt.mt_subscription_deleted(
+                    publisher,
+                    subs
+                );
+            }
+        }
+    }
+
+    /*--------------------------------*
+     *      Delete subscription
+     *--------------------------------*/
+    subs_index_remove(publisher, subs);
+    rc_delete_resource(subs, sdata_destroy);
+
+    return 0;
+}
+
+/***************************************************************************
+ *  Delete all subscriptions as subscriber
+ *  WARNING Use only in destroying gobj
+ ***************************************************************************/
+PRIVATE int _delete_subscribings(GObj_t * subscriber)
+{
+    hsdata subs; rc_instance_t *i_subs;
+
+    while((i_subs=rc_first_instance(&subscriber->dl_subscribings, (rc_resource_t **)&subs))) {
+        subs_index_remove(sdata_read_pointer(subs, "publisher"), subs);
+        rc_delete_resource(subs, sdata_destroy);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Delete all subscriptions as subscriber
+ *  WARNING Use only in destroying gobj
+ ***************************************************************************/
+PRIVATE int _delete_subscriptions(GObj_t * publisher)
+{
+    hsdata subs; rc_instance_t *i_subs;
+
+    while((i_subs=rc_first_instance(&publisher->dl_subscriptions, (rc_resource_t **)&subs))) {
+        rc_delete_resource(subs, sdata_destroy);
+    }
+    subs_index_free(publisher);
+    return 0;
+}
+
+/***************************************************************************
+ *  Subscribe to an event
+ *
+ *  event is only one event (not a string list like ginsfsm),
+ *  or a pattern (prefix or glob) indexed in the publisher's trie.
+ *
+ *  IDEMPOTENT function
+ *
+ *  See .h
+ ***************************************************************************/
+PUBLIC hsdata gobj_subscribe_event(
+    hgobj publisher_,
+    const char *event,
+    json_t *kw,
+    hgobj subscriber_)
+{
+    GObj_t * publisher = publisher_;
+    GObj_t * subscriber = subscriber_;
+
+    /*---------------------*
+     *  Check something
+     *---------------------*/
+    if(!publisher) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "publisher NULL",
+            "event",        "%s", event?event:"",
+            NULL
+        );
+        KW_DECREF(kw)
+        return 0;
+    }
+    if(!subscriber) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "subscriber NULL",
+            "event",        "%s", event?event:"",
+            NULL
+        );
+        KW_DECREF(kw)
+        return 0;
+    }
+
+    /*-------------------------------------------------*
+     *  Check AUTHZ
+     *-------------------------------------------------*/
+//     const EVENT *output_event = gobj_output_event(publisher, event);
+//         if(output_event->authz & EV_AUTHZ_SUBSCRIBE) {
+//             const char *event = output_event->event?output_event->event:"";
+//             /*
+//              *  AUTHZ Required
+//              */
+//             json_t *kw_authz = json_pack("{s:s}",
+//                 "event", event
+//             );
+//             if(kw) {
+//                 json_object_set(kw_authz, "kw", kw);
+//             } else {
+//                 json_object_set_new(kw_authz, "kw", json_object());
+//             }
+//             if(!gobj_user_has_authz(
+//                 publisher_,
+//                 "__subscribe_event__",
+//                 kw_authz,
+//                 subscriber_
+//             )) {
+//                 log_error(0,
+//                     "gobj",         "%s", gobj_full_name(publisher_),
+//                     "function",     "%s", __FUNCTION__,
+//                     "msgset",       "%s", MSGSET_OAUTH_ERROR,
+//                     "msg",          "%s", "No permission to subscribe event",
+//                     //"user",         "%s", gobj_get_user(subscriber_),
+//                     "gclass",       "%s", gobj_gclass_name(publisher_),
+//                     "event",        "%s", event?event:"",
+//                     NULL
+//                 );
+//                 KW_DECREF(kw)
+//                 return 0;
+//             }
+//         }
+//         output_event_list++;
+//     }
+
+    /*-------------------------------------------------*
+     *
+     *-------------------------------------------------*/
+    if(empty_string(event) || strcmp(event, "*")==0) {
+        event = "";
+    }
+
+    /*--------------------------------------------------------------*
+     *  Event must be in output event list
+     *  You can avoid this with gcflag_no_check_output_events flag
+     *--------------------------------------------------------------*/
+    if(!empty_string(event) && !is_event_pattern(event)) {
+        if(!(publisher->gclass->gcflag & gcflag_no_check_output_events)) {
+            const EVENT *output_event = gobj_output_event(publisher, event);
+            if(!output_event) {
+                log_error(0,
+                    "gobj",         "%s", __FILE__,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+                    "msg",          "%s", "event NOT in output event list",
+                    "event",        "%s", event,
+                    "publisher",    "%s", gobj_full_name(publisher),
+                    "subscriber",   "%s", gobj_full_name(subscriber),
+                    NULL
+                );
+            }
+        }
+    }
+
+    /*------------------------------*
+     *  Find repeated subscription
+     *------------------------------*/
+    KW_INCREF(kw);
+    dl_list_t *dl_subs = _find_identical_subscription(
+        publisher,
+        event,
+        kw,
+        subscriber
+    );
+    int size = rc_iter_size(dl_subs);
+    if(size > 0) {
+        log_warning(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "subscription(s) REPEATED, will be deleted and override",
+            "event",        "%s", event,
+            "publisher",    "%s", gobj_full_name(publisher),
+            "subscriber",   "%s", gobj_full_name(subscriber),
+            NULL
+        );
+        gobj_unsubscribe_list(dl_subs, FALSE, FALSE);
+    }
+    rc_free_iter(dl_subs, TRUE, 0);
+
+    /*-----------------------------*
+     *  Create subscription
+     *-----------------------------*/
+    hsdata subs = _create_subscription(
+        publisher,
+        event,
+        kw,  // not owned
+        subscriber
+    );
+    if(!subs) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "_create_subscription() FAILED",
+            "event",        "%s", event?event:"*",
+            "publisher",    "%s", gobj_full_name(publisher),
+            "subscriber",   "%s", gobj_full_name(subscriber),
+            NULL
+        );
+        KW_DECREF(kw)
+        return 0;
+    }
+    rc_add_instance(&publisher->dl_subscriptions, subs, 0);
+    rc_add_instance(&subscriber->dl_subscribings, subs, 0);
+    subscription_t *sub = subs_index_add(publisher, subs, event);
+    if(!sub) {
+        /*
+         *  Not indexed, it would not be published: fail
+         */
+        _delete_subscription(subs, TRUE, TRUE);
+        KW_DECREF(kw)
+        return 0;
+    }
+
+    /*-----------------------------*
+     *  Trace
+     *-----------------------------*/
+    if(__trace_gobj_subscriptions__(subscriber) || __trace_gobj_subscriptions__(publisher) ||
+        __trace_gobj_subscriptions2__(subscriber) || __trace_gobj_subscriptions2__(publisher)
+    ) {
+        trace_machine("💜💜👍 %s subscribing event '%s' of %s",
+            gobj_full_name(subscriber),
+            event?event:"*",
+            gobj_full_name(publisher)
+        );
+        if(kw) {
+            if(1 || __trace_gobj_ev_kw__(subscriber) || __trace_gobj_ev_kw__(publisher)) {
+                log_debug_json(0, kw, "kw");
+            }
+        }
+    }
+
+    /*--------------------------------*
+     *      Inform new subscription
+     *--------------------------------*/
+    if(publisher->gclass->gmt.mt_subscription_added) {
+        int result = publisher->gclass->gmt.mt_subscription_added(
+            publisher,
+            subs
+        );
+        if(result < 0) {
+            _delete_subscription(subs, TRUE, TRUE);
+            subs = 0;
+        } else {
+            if(subscription_load(sub) < 0) { // the view could be modified
+                _delete_subscription(subs, TRUE, TRUE);
+                subs = 0;
+            }
+        }
+    }
+    if(subs) {
+        sdata_set_read_only(subs, TRUE); // the record is not reloaded from now on
+    }
+
+    KW_DECREF(kw)
+    return subs;
+}
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC int gobj_unsubscribe_event(
+    hgobj publisher_,
+    const char *event,
+    json_t *kw,
+    hgobj subscriber_)
+{
+    GObj_t * publisher = publisher_;
+    GObj_t * subscriber = subscriber_;
+
+    /*---------------------*
+     *  Check something
+     *---------------------*/
+    if(!publisher) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "publisher NULL",
+            "event",        "%s", event?event:"",
+            NULL
+        );
+        KW_DECREF(kw)
+        return -1;
+    }
+    if(!subscriber) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "subscriber NULL",
+            "event",        "%s", event?event:"",
+            NULL
+        );
+        KW_DECREF(kw)
+        return -1;
+    }
+
+    /*-------------------------------------------------*
+     *
+     *-------------------------------------------------*/
+    if(empty_string(event) || strcmp(event, "*")==0) {
+        event = "";
+    }
+
+    /*-----------------------------*
+     *      Find subscription
+     *-----------------------------*/
+    KW_INCREF(kw);
+    dl_list_t *dl_subs = _find_identical_subscription(
+        publisher,
+        event,
+        kw,
+        subscriber
+    );
+    int deleted = 0;
+    hsdata subs; rc_instance_t *i_subs;
+    i_subs = rc_first_instance(dl_subs, (rc_resource_t **)&subs);
+    while(i_subs) {
+        hsdata next_subs; rc_instance_t *next_i_subs;
+        next_i_subs = rc_next_instance(i_subs, (rc_resource_t **)&next_subs);
+
+        _delete_subscription(subs, 0, 0);
+        deleted++;
+
+        i_subs = next_i_subs;
+        subs = next_subs;
+    }
+
+    if(!deleted) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj_unsubscribe_event() NO SUBCRIPTION FOUND",
+            "event",        "%s", event,
+            "publisher",    "%s", gobj_full_name(publisher),
+            "subscriber",   "%s", gobj_full_name(subscriber),
+            NULL
+        );
+        log_debug_json(0, kw, "gobj_unsubscribe_event() NO SUBCRIPTION FOUND");
+    }
+    rc_free_iter(dl_subs, TRUE, sdata_destroy);
+
+    KW_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Unsubscribe by handle, O(1)
+ ***************************************************************************/
+PUBLIC int gobj_unsubscribe_event2(
+    hsdata subs
+)
+{
+    return _delete_subscription(subs, 0, 0);
+}
+
+/***************************************************************************
+ *  Subscribe a list of events
+ ***************************************************************************/
+PUBLIC int gobj_subscribe_events(
+    hgobj publisher,
+    const char **events,
+    json_t *kw,
+    hgobj subscriber)
+{
+    int subscribed = 0;
+    for(int i=0; events && events[i]; i++) {
+        KW_INCREF(kw);
+        if(gobj_subscribe_event(publisher, events[i], kw, subscriber)) {
+            subscribed++;
+        }
+    }
+    KW_DECREF(kw)
+    return subscribed;
+}
+
+/***************************************************************************
+ *  Unsubscribe a list of events
+ ***************************************************************************/
+PUBLIC int gobj_unsubscribe_events(
+    hgobj publisher,
+    const char **events,
+    json_t *kw,
+    hgobj subscriber)
+{
+    int ret = 0;
+    for(int i=0; events && events[i]; i++) {
+        KW_INCREF(kw);
+        if(gobj_unsubscribe_event(publisher, events[i], kw, subscriber)<0) {
+            ret = -1;
+        }
+    }
+    KW_DECREF(kw)
+    return ret;
+}
+
+/***************************************************************************
+ *  Unsubscribe a list of subscription hsdata
+ ***************************************************************************/
+PUBLIC int gobj_unsubscribe_list(
+    dl_list_t *dl_subs, // iter of subscription hsdata
+    BOOL free_iter,
+    BOOL force  // delete hard_subscription subs too
+)
+{
+    hsdata subs; rc_instance_t *i_subs;
+    i_subs = rc_first_instance(dl_subs, (rc_resource_t **)&subs);
+    while(i_subs) {
+        hsdata next_subs; rc_instance_t *next_i_subs;
+        next_i_subs = rc_next_instance(i_subs, (rc_resource_t **)&next_subs);
+
+        _delete_subscription(subs, force, 0);
+
+        i_subs = next_i_subs;
+        subs = next_subs;
+    }
+    if(free_iter) {
+        rc_free_iter(dl_subs, TRUE, sdata_destroy);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Set funtion to be applied in Selection Filter __filter__
+ *  Default is kw_match_simple(), evaluated with the compiled __filter__
+ *  Return old function
+ ***************************************************************************/
+PUBLIC kw_match_fn gobj_set_publication_selection_filter_fn(kw_match_fn kw_match)
+{
+    kw_match_fn old_fn = __publish_event_match__;
+    __publish_event_match__ = kw_match;
+    return old_fn;
+}
+
+/***************************************************************************
+ *  Add transformation filter function,
+ *  to be applied with __config__`__trans_filter__
+ ***************************************************************************/
+PUBLIC int gobj_add_publication_transformation_filter_fn(
+    const char *name,
+    json_t * (*transformation_fn)(
+        json_t *kw // owned
+    )
+)
+{
+    return register_transformation_filter(name, transformation_fn);
+}
+
+/***************************************************************************
+ *  Find a transformation filter function
+ ***************************************************************************/
+PRIVATE trans_filter_fn find_trans_filter(const char *name)
+{
+    if(!name) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "name NULL",
+            NULL
+        );
+        return 0;
+    }
+
+    trans_filter_t *trans_reg = dl_first(&dl_trans_filter);
+    while(trans_reg) {
+        if(trans_reg->name) {
+            if(strcasecmp(trans_reg->name, name)==0) {
+                return trans_reg->transformation_fn;
+            }
+        }
+        trans_reg = dl_next(trans_reg);
+    }
+    log_error(0,
+        "gobj",         "%s", "__yuno__",
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "trans filter NOT FOUND",
+        "name",         "%s", name?name:"",
+        NULL
+    );
+
+    return 0;
+}
+
+/***************************************************************************
+ *  Walk the names of __config__`__trans_filter__ (dict keys, list or string)
+ *  Return the number of names, fill trans_fns if not null.
+ ***************************************************************************/
+PRIVATE int walk_trans_filters(json_t *jn_trans_filters, trans_filter_fn *trans_fns, int n)
+{
+    if(json_is_object(jn_trans_filters)) {
+        const char *key;
+        json_t *jn_value;
+        json_object_foreach(jn_trans_filters, key, jn_value) {
+            if(trans_fns) {
+                trans_fns[n] = find_trans_filter(key);
+            }
+            n++;
+        }
+    } else if(json_is_array(jn_trans_filters)) {
+        size_t index;
+        json_t *jn_value;
+        json_array_foreach(jn_trans_filters, index, jn_value) {
+            n = walk_trans_filters(jn_value, trans_fns, n);
+        }
+    } else if(json_is_string(jn_trans_filters)) {
+        if(trans_fns) {
+            trans_fns[n] = find_trans_filter(json_string_value(jn_trans_filters));
+        }
+        n++;
+    }
+    return n;
+}
+
+/***************************************************************************
+ *  Walk the keys of __local__ (dict keys, list or string), like kw_pop()
+ *  Return the number of keys, fill local_keys (duplicated) if not null.
+ ***************************************************************************/
+PRIVATE int walk_local_keys(json_t *__local__, char **local_keys, int n)
+{
+    if(json_is_object(__local__)) {
+        const char *key;
+        json_t *jn_value;
+        json_object_foreach(__local__, key, jn_value) {
+            if(local_keys) {
+                local_keys[n] = gbmem_strdup(key);
+            }
+            n++;
+        }
+    } else if(json_is_array(__local__)) {
+        size_t index;
+        json_t *jn_value;
+        json_array_foreach(__local__, index, jn_value) {
+            n = walk_local_keys(jn_value, local_keys, n);
+        }
+    } else if(json_is_string(__local__)) {
+        if(local_keys) {
+            local_keys[n] = gbmem_strdup(json_string_value(__local__));
+        }
+        n++;
+    }
+    return n;
+}
+
+/***************************************************************************
+ *  Resolve the transformation filter functions of the plan.
+ *  Resolved again when the registered trans filters change.
+ *  Not found filters are skipped (they don't change the kw).
+ ***************************************************************************/
+PRIVATE int publish_plan_resolve_trans(publish_plan_t *plan)
+{
+    GBMEM_FREE(plan->trans_fns);
+    plan->n_trans_fns = 0;
+    plan->trans_generation = __trans_filter_generation__;
+
+    int n = walk_trans_filters(plan->jn_trans_filters, 0, 0);
+    if(n == 0) {
+        return 0;
+    }
+    plan->trans_fns = gbmem_malloc(sizeof(trans_filter_fn) * n);
+    if(!plan->trans_fns) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for trans filters",
+            NULL
+        );
+        return -1;
+    }
+    walk_trans_filters(plan->jn_trans_filters, plan->trans_fns, 0);
+
+    int j = 0;
+    for(int i=0; i<n; i++) {
+        if(plan->trans_fns[i]) {
+            plan->trans_fns[j++] = plan->trans_fns[i];
+        }
+    }
+    plan->n_trans_fns = j;
+    return 0;
+}
+
+/***************************************************************************
+ *  Build the publish plan of a subscription:
+ *  local keys to remove, transformation filters and global overlay.
+ ***************************************************************************/
+PRIVATE int publish_plan_build(
+    publish_plan_t *plan,
+    json_t *__config__,
+    json_t *__global__,
+    json_t *__local__)
+{
+    publish_plan_free(plan);
+
+    int n = walk_local_keys(__local__, 0, 0);
+    if(n > 0) {
+        plan->local_keys = gbmem_malloc(sizeof(char *) * n);
+        if(!plan->local_keys) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for local keys",
+                NULL
+            );
+            return -1;
+        }
+        plan->n_local_keys = walk_local_keys(__local__, plan->local_keys, 0);
+        for(int i=0; i<plan->n_local_keys; i++) {
+            if(!plan->local_keys[i]) {
+                log_error(0,
+                    "gobj",         "%s", __FILE__,
+                    "function",     "%s", __FUNCTION__,
+                    "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                    "msg",          "%s", "no memory for local keys",
+                    NULL
+                );
+                publish_plan_free(plan);
+                return -1;
+            }
+        }
+    }
+
+    if(__config__) {
+        plan->jn_trans_filters = kw_get_dict_value(__config__, "__trans_filter__", 0, 0);
+        JSON_INCREF(plan->jn_trans_filters);
+    }
+    if(plan->jn_trans_filters) {
+        if(publish_plan_resolve_trans(plan) < 0) {
+            return -1;
+        }
+    }
+
+    if(json_is_object(__global__) && json_object_size(__global__) > 0) {
+        plan->global_overlay = json_incref(__global__);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Free the publish plan
+ ***************************************************************************/
+PRIVATE void publish_plan_free(publish_plan_t *plan)
+{
+    for(int i=0; i<plan->n_local_keys; i++) {
+        GBMEM_FREE(plan->local_keys[i]);
+    }
+    GBMEM_FREE(plan->local_keys);
+    GBMEM_FREE(plan->trans_fns);
+    JSON_DECREF(plan->global_overlay);
+    JSON_DECREF(plan->jn_trans_filters);
+    memset(plan, 0, sizeof(publish_plan_t));
+}
+
+/***************************************************************************
+ *  Return the number of sent (or posted if async) events
+ ***************************************************************************/
+PRIVATE int _gobj_publish_event(
+    GObj_t *publisher,
+    const char *event,
+    event_id_t event_id,    // atom of event, 0 to find it
+    json_t *kw,
+    BOOL async)
+{
+
+    if(!kw) {
+        kw = json_object();
+    }
+
+    /*---------------------*
+     *  Check something
+     *---------------------*/
+    if(!publisher) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        KW_DECREF(kw)
+        return 0;
+    }
+    if(publisher->obflag & obflag_destroyed) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj DESTROYED",
+            NULL
+        );
+        KW_DECREF(kw)
+        return 0;
+    }
+    if(empty_string(event)) {
+        log_error(0,
+            "gobj",         "%p", gobj_full_name(publisher),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "event EMPTY",
+            NULL
+        );
+        KW_DECREF(kw)
+        return 0;
+    }
+
+    /*--------------------------------------------------------------*
+     *  Event must be in output event list
+     *  You can avoid this with gcflag_no_check_output_events flag
+     *--------------------------------------------------------------*/
     const EVENT *ev = gobj_output_event(publisher, event);
     if(!ev) {
         if(!(publisher->gclass->gcflag & gcflag_no_check_output_events)) {
             log_error(0,
-                "gobj",         "%s", gobj_full_name(publisher),
+                "gobj",         "%s", gobj_full_name(publisher),
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+                "msg",          "%s", "event NOT in output event list",
+                "event",        "%s", event,
+                NULL
+            );
+            KW_DECREF(kw)
+            return 0;
+        }
+    }
+
+    BOOL tracea = is_machine_tracing(publisher) &&
+        !is_machine_not_tracing(publisher) &&
+        __trace_gobj_subscriptions__(publisher);
+    if(tracea) {
+        trace_machine("🔝🔝 mach(%s%s^%s), ev: %s, st: %s",
+            (!publisher->running)?"!!":"",
+            gobj_gclass_name(publisher), gobj_name(publisher),
+            event,
+            publisher->mach->fsm->state_names[publisher->mach->current_state]
+        );
+        if(__trace_gobj_ev_kw__(publisher)) {
+            log_debug_json(0, kw, "kw");
+        }
+    }
+    BOOL tracea2 = __trace_gobj_subscriptions2__(publisher);
+
+    /*----------------------------------------------------------*
+     *  Own publication method
+     *  Return:
+     *     -1  broke                        -> return
+     *      0  continue without publish     -> return
+     *      1  publish and continue         -> continue below
+     *----------------------------------------------------------*/
+    if(publisher->gclass->gmt.mt_publish_event) {
+        int topublish = publisher->gclass->gmt.mt_publish_event(
+            publisher,
+            event,
+            kw  // not owned
+        );
+        if(topublish<=0) {
+            if(__publish_stats_enabled__ && !(publisher->obflag & obflag_destroyed)) {
+                publish_stats_t *stats = publish_stats_get(
+                    publisher,
+                    event_id? event_id : gobj_event_atom(event)
+                );
+                if(stats) {
+                    stats->publications++;
+                    stats->skipped++;
+                }
+            }
+            KW_DECREF(kw)
+            return 0;
+        }
+    }
+
+    /*--------------------------------------------------------------*
+     *  Default publication method
+     *--------------------------------------------------------------*/
+    BOOL global_kw_shared = kw_get_bool(kw, "__share_kw__", FALSE, KW_WILD_NUMBER);
+    BOOL global_kw_cow = kw_get_bool(kw, "__cow_kw__", FALSE, KW_WILD_NUMBER);
+    int sent_count = 0;
+
+    /*
+     *  Publish stats, counted in locals (the publisher can be destroyed)
+     */
+    BOOL publish_stats = __publish_stats_enabled__;
+    uint64_t t0 = publish_stats? uv_hrtime() : 0;
+    uint64_t st_matched = 0, st_filtered = 0, st_copies = 0, st_deliveries = 0, st_queued = 0;
+    BOOL st_owned = FALSE;
+
+    /*
+     *  Only the subscriptions of this event, the catch-all ones
+     *  and the patterns of the trie along the event,
+     *  merged in subscription order.
+     *  Subscriptions removed while publishing are left as holes (subs 0),
+     *  new subscriptions are not visited.
+     */
+    subs_index_t *subs_index = publisher->subs_index;
+    subs_cursor_t cursors_[SUBS_CURSORS];
+    subs_cursors_t cursors = {cursors_, 0, SUBS_CURSORS};
+    if(subs_index) {
+        if(!event_id) {
+            event_id = gobj_find_event_atom(event);
+        }
+        subs_cursors_collect(subs_index, event, event_id, &cursors);
+        subs_index->publishing++;
+    }
+    while(1) {
+        /*
+         *  Next subs: the lowest seq of the cursors, holes are skipped
+         */
+        subscription_t *sub = 0;
+        subs_cursor_t *cursor = 0;
+        for(int k=0; k<cursors.n; k++) {
+            subs_cursor_t *c = &cursors.cursors[k];
+            while(c->i < c->n && !c->bucket->entries[c->i]) {
+                c->i++;
+            }
+            if(c->i < c->n) {
+                subscription_t *s = c->bucket->entries[c->i];
+                if(!sub || s->seq < sub->seq) {
+                    sub = s;
+                    cursor = c;
+                }
+            }
+        }
+        if(!sub) {
+            break;
+        }
+        cursor->i++;
+        if(cursor->pattern && !event_glob_match(sub->pattern, event)) {
+            continue;
+        }
+        st_matched++;
+        hsdata subs = sub->subs;
+        GObj_t *subscriber = sub->subscriber;
+        subs_flag_t subs_flag = sub->subs_flag;
+        json_t *__filter__ = sub->__filter__;
+        filter_prog_t *filter_prog = sub->filter_prog;
+        if(sub->plan.jn_trans_filters &&
+                sub->plan.trans_generation != __trans_filter_generation__) {
+            publish_plan_resolve_trans(&sub->plan);
+        }
+        publish_plan_t *plan = &sub->plan;
+        subs_throttle_t *throttle = sub->throttle;
+        const char *event_name = sub->renamed_event? sub->renamed_event : event;
+
+        /*-------------------------------------*
+         *  Pre-filter
+         *  kw NOT owned! you can modify the publishing kw
+         *  Return:
+         *     -1  broke
+         *      0  continue without publish
+         *      1  continue to publish
+         *-------------------------------------*/
+        if(publisher->gclass->gmt.mt_publication_pre_filter) {
+            int topublish = publisher->gclass->gmt.mt_publication_pre_filter(
+                publisher,
+                subs,
+                event,
+                kw  // not owned
+            );
+            if(topublish<0) {
+                break;
+            } else if(topublish==0) {
+                st_filtered++;
+                continue;
+            }
+        }
+        if(!(subscriber && !(subscriber->obflag & obflag_destroyed))) {
+            continue;
+        }
+
+        /*
+         *  Duplicate the kw to publish if not shared.
+         *  Copy-on-write: share the kw, it will be twined below
+         *  only if this publication has to change it.
+         *  Not with mt_publication_filter, it receives a kw that it can modify.
+         */
+        json_t *kw2publish = 0;
+        BOOL kw_cow = FALSE;
+        if(global_kw_shared || (subs_flag & __share_kw__)) {
+            KW_INCREF(kw);
+            kw2publish = kw;
+        } else if((global_kw_cow || (subs_flag & __cow_kw__)) &&
+                !publisher->gclass->gmt.mt_publication_filter) {
+            KW_INCREF(kw);
+            kw2publish = kw;
+            kw_cow = TRUE;
+        } else {
+            kw2publish = kw_duplicate(kw);
+            st_copies++;
+        }
+
+        /*-------------------------------------*
+         *  User filter method or filter parameter
+         *  Return:
+         *     -1  (broke),
+         *      0  continue without publish,
+         *      1  continue and publish
+         *-------------------------------------*/
+        int topublish = 1;
+        if(publisher->gclass->gmt.mt_publication_filter) {
+            topublish = publisher->gclass->gmt.mt_publication_filter(
+                publisher,
+                event,
+                kw2publish,  // not owned
+                subscriber
+            );
+        } else if(__filter__) {
+            if(filter_prog && __publish_event_match__ == kw_match_simple) {
+                /*
+                 *  Compiled __filter__, the custom matchers use the json filter
+                 */
+                topublish = filter_node_match(filter_prog->nodes, kw2publish);
+            } else if(__publish_event_match__) {
+                KW_INCREF(__filter__);
+                topublish = __publish_event_match__(kw2publish , __filter__);
+            }
+        }
+
+        if(topublish<0) {
+            break;
+        } else if(topublish==0) {
+            /*
+             *  Must not be published
+             *  Next subs
+             */
+            KW_DECREF(kw2publish);
+            st_filtered++;
+            continue;
+        }
+
+        /*
+         *  Check if System event: don't send if subscriber has not it
+         */
+        if(ev && ev->flag & EVF_SYSTEM_EVENT) {
+            if(!gobj_input_event(subscriber, event)) {
+                KW_DECREF(kw2publish);
+                continue;
+            }
+        }
+
+        /*
+         *  Copy-on-write: twin now if the kw will be changed,
+         *  by the subscription or by the subscriber (EVF_KW_WRITING event)
+         */
+        if(kw_cow) {
+            BOOL twin = sub->changes_kw;
+            if(!twin) {
+                const EVENT *ev_in = gobj_input_event(subscriber, event_name);
+                twin = (ev_in && (ev_in->flag & EVF_KW_WRITING))? TRUE : FALSE;
+            }
+            if(twin) {
+                json_t *kw_twin = kw_duplicate(kw);
+                KW_DECREF(kw2publish);
+                kw2publish = kw_twin;
+                st_copies++;
+            }
+        }
+
+        /*
+         *  Execute the publish plan:
+         *  remove local keys, apply transformation filters, add global keys
+         */
+        for(int i=0; i<plan->n_local_keys; i++) {
+            json_object_del(kw2publish, plan->local_keys[i]);
+        }
+        for(int i=0; i<plan->n_trans_fns; i++) {
+            kw2publish = plan->trans_fns[i](kw2publish);
+        }
+        if(plan->global_overlay) {
+            json_object_update(kw2publish, plan->global_overlay);
+        }
+
+        /*
+         *  Coalescing/rate limit: the kw is kept to be delivered by the throttle timer
+         */
+        if(throttle && !subs_throttle_publication(throttle, event_name, kw2publish)) {
+            st_queued++;
+            continue;   // not sent yet
+        }
+
+        /*
+         *  Send event
+         */
+        if(tracea2) {
+            trace_machine("🔝🔄 mach(%s%s), ev: %s, from(%s%s)",
+                (!subscriber->running)?"!!":"",
+                gobj_short_name(subscriber),
+                event,
+                (publisher && !publisher->running)?"!!":"",
+                gobj_short_name(publisher)
+            );
+            if(__trace_gobj_ev_kw__(publisher)) {
+                log_debug_json(0, kw2publish, "kw");
+            }
+        }
+
+        if(async) {
+            /*
+             *  Delivered by the event queue,
+             *  discarded if the subscriber is destroyed before the delivery.
+             */
+            if(gobj_post_event(subscriber, event_name, kw2publish, publisher)<0) {
+                continue;
+            }
+            st_queued++;
+            sent_count++;
+            continue;
+        }
+
+        int ret = gobj_send_event(
+            subscriber,
+            event_name,
+            kw2publish,
+            publisher
+        );
+        st_deliveries++;
+        if(ret < 0 && (subs_flag & __own_event__)) {
+            st_owned = TRUE;
+            sent_count = -1; // Return of -1 indicates that someone owned the event
+            break;
+        }
+        sent_count++;
+
+        if(publisher->obflag & obflag_destroyed) {
+            /*
+             *  break all, self publisher deleted
+             */
+            break;
+        }
+    }
+
+    if(cursors.cursors != cursors_) {
+        GBMEM_FREE(cursors.cursors);
+    }
+
+    if(publish_stats && !(publisher->obflag & obflag_destroyed)) {
+        publish_stats_t *stats = publish_stats_get(
+            publisher,
+            event_id? event_id : gobj_event_atom(event)
+        );
+        if(stats) {
+            stats->publications++;
+            stats->matched += st_matched;
+            stats->filtered += st_filtered;
+            stats->deliveries += st_deliveries;
+            stats->queued += st_queued;
+            stats->copies += st_copies;
+            stats->owned += st_owned? 1 : 0;
+            stats->time_ns += uv_hrtime() - t0;
+        }
+    }
+    if(subs_index && !(publisher->obflag & obflag_destroyed)) {
+        subs_index->publishing--;
+        if(!subs_index->publishing && subs_index->tombstones) {
+            subs_index_compact(subs_index);
+        }
+    }
+
+    if(!sent_count && !st_queued) { // held by a throttle, it has subscribers
+        if(!ev || !(ev->flag & EVF_NO_WARN_SUBS)) {
+            log_warning(0,
+                "publisher",         "%s", gobj_full_name(publisher),
+                "msgset",       "%s", MSGSET_MONITORING,
+                "msg",          "%s", "Publish event WITHOUT subscribers",
+                "event",        "%s", event,
+                NULL
+            );
+            if(__trace_gobj_ev_kw__(publisher)) {
+                log_debug_json(0, kw, "kw");
+            }
+        }
+    }
+
+    KW_DECREF(kw)
+    return sent_count;
+}
+
+/***************************************************************************
+ *  Return the number of sent events
+ ***************************************************************************/
+PUBLIC int gobj_publish_event(
+    hgobj publisher,
+    const char *event,
+    json_t *kw)
+{
+    return _gobj_publish_event(publisher, event, 0, kw, FALSE);
+}
+
+/***************************************************************************
+ *  Publish with asynchronous fan-out:
+ *  the subscriptions are matched now, the deliveries are posted
+ *  to the yuno's event queue and sent later in bounded batches.
+ *  Return the number of posted events
+ ***************************************************************************/
+PUBLIC int gobj_publish_event_async(
+    hgobj publisher,
+    const char *event,
+    json_t *kw)
+{
+    if(!__event_queue_loop__) {
+        /*
+         *  Nobody would drain the queue, publish synchronously
+         */
+        return _gobj_publish_event(publisher, event, 0, kw, FALSE);
+    }
+    return _gobj_publish_event(publisher, event, 0, kw, TRUE);
+}
+
+/***************************************************************************
+ *  Publish event by atom,
+ *  the subscriptions are found by the atom without hashing the name.
+ ***************************************************************************/
+PUBLIC int gobj_publish_event_id(
+    hgobj publisher,
+    event_id_t event_id,
+    json_t *kw)
+{
+    const char *event = gobj_event_atom_name(event_id);
+    if(!event) {
+        log_error(0,
+            "gobj",         "%s", gobj_full_name(publisher),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "event atom UNKNOWN",
+            "event_id",     "%d", (int)event_id,
+            NULL
+        );
+        KW_DECREF(kw)
+        return 0;
+    }
+    return _gobj_publish_event(publisher, event, event_id, kw, FALSE);
+}
+
+/***************************************************************************
+ *  Inject event
+ *
+ *  I only see event parameter,
+ *  the remains parameters are high level specifics
+ *  and transparents for me.
+ *
+ *  Return:
+ *      - no permission:.                       -403
+ *      - no destine or destine destroyed:      -1000
+ *      - event not accepted:                   -1001
+ *      - if event is accepted:
+ *          - no action:                        -1002
+ *          - input event not defined           -1003
+ *          - an action is defined:             the return of action.
+ ***************************************************************************/
+#define RETEVENT_NO_GOBJ                    -1000
+#define RETEVENT_NOT_ACCEPTED               -1001
+#define RETEVENT_NO_ACTION                  -1002
+#define RETEVENT_INPUT_EVENT_NOT_DEFINED    -1003
+
+/***************************************************************************
+ *  Send event
+ ***************************************************************************/
+PUBLIC int gobj_send_event(
+    hgobj dst_,
+    const char *event,
+    json_t *kw,
+    hgobj src_)
+{
+    GObj_t * dst = dst_;
+    GObj_t * src = src_;
+
+    if(!dst) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        KW_DECREF(kw)
+        return RETEVENT_NO_GOBJ;
+    }
+    if(dst->obflag & (obflag_destroyed|obflag_destroying)) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", (dst->obflag & obflag_destroyed)? "gobj DESTROYED":"gobj DESTROYING",
+            NULL
+        );
+        KW_DECREF(kw)
+        return RETEVENT_NO_GOBJ;
+    }
+
+    return _gobj_send_event(dst, event, gobj_input_event(dst, event), kw, src);
+}
+
+/***************************************************************************
+ *  Send event by atom
+ ***************************************************************************/
+PUBLIC int gobj_send_event_id(
+    hgobj dst_,
+    event_id_t event_id,
+    json_t *kw,
+    hgobj src_)
+{
+    GObj_t * dst = dst_;
+    GObj_t * src = src_;
+
+    if(!dst) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        KW_DECREF(kw)
+        return RETEVENT_NO_GOBJ;
+    }
+    if(dst->obflag & (obflag_destroyed|obflag_destroying)) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", (dst->obflag & obflag_destroyed)? "gobj DESTROYED":"gobj DESTROYING",
+            NULL
+        );
+        KW_DECREF(kw)
+        return RETEVENT_NO_GOBJ;
+    }
+
+    const EVENT *ev_desc = 0;
+    const char *event;
+    fsm_table_t *fsm_table = gobj_fsm_table(dst);
+    if(fsm_table) {
+        int ev = fsm_table_event_index_by_atom(fsm_table, event_id);
+        if(ev >= 0) {
+            ev_desc = dst->mach->fsm->input_events + ev;
+        }
+    }
+    if(ev_desc) {
+        event = ev_desc->event; // the name used by the gclass
+    } else {
+        event = gobj_event_atom_name(event_id);
+        if(!event) {
+            log_error(0,
+                "gobj",         "%s", gobj_short_name(dst),
                 "function",     "%s", __FUNCTION__,
                 "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-                "msg",          "%s", "event NOT in output event list",
+                "msg",          "%s", "event atom UNKNOWN",
+                "event_id",     "%d", (int)event_id,
+                "src",          "%s", gobj_short_name(src),
+                NULL
+            );
+            KW_DECREF(kw)
+            return RETEVENT_INPUT_EVENT_NOT_DEFINED;
+        }
+        if(!fsm_table) {
+            ev_desc = gobj_input_event(dst, event);
+        }
+    }
+
+    return _gobj_send_event(dst, event, ev_desc, kw, src);
+}
+
+/***************************************************************************
+ *  Send event, with the input event already located.
+ ***************************************************************************/
+PRIVATE int _gobj_send_event(
+    GObj_t * dst,
+    const char *event,
+    const EVENT *ev_desc,
+    json_t *kw,
+    GObj_t * src)
+{
+    SMachine_t * mach;
+    register EV_ACTION *actions;
+    int ret;
+    BOOL tracea;
+
+    __inside__ ++;
+
+    tracea = is_machine_tracing(dst) && !is_machine_not_tracing(src);
+    mach = dst->mach;
+    actions = mach->fsm->states[mach->current_state];
+
+    if(!ev_desc) {
+        if(dst->gclass->gmt.mt_inject_event) {
+            __inside__ --;
+            if(tracea) {
+                trace_machine("🔃 mach(%s%s^%s), ev: %s, st(%d:%s), from(%s%s^%s)",
+                    (!dst->running)?"!!":"",
+                    gobj_gclass_name(dst), gobj_name(dst),
+                    event,
+                    mach->current_state,
+                    mach->fsm->state_names[mach->current_state],
+                    (src && !src->running)?"!!":"",
+                    gobj_gclass_name(src), gobj_name(src)
+                );
+                if(kw) {
+                    if(__trace_gobj_ev_kw__(dst)) {
+                        log_debug_json(0, kw, "kw");
+                    }
+                }
+            }
+            return dst->gclass->gmt.mt_inject_event(dst, event, kw, src);
+        }
+        if(tracea) {
+            trace_machine("📛 mach(%s%s^%s), st: %s, ev: %s, 📛📛EVENT NOT DEFINED📛📛",
+                        (!dst->running)?"!!":"",
+                gobj_gclass_name(dst), gobj_name(dst),
+                mach->fsm->state_names[mach->current_state],
+                event
+            );
+        } else {
+            log_error(0,
+                "gobj",         "%s", gobj_short_name(dst),
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+                "msg",          "%s", "Event NOT DEFINED in input_events array",
+                "event",        "%s", event,
+                "src",          "%s", gobj_short_name(src),
+                "state",        "%s", gobj_current_state(dst),
+                "full_src",     "%s", gobj_full_name(src),
+                "full_dst",     "%s", gobj_full_name(dst),
+                NULL
+            );
+        }
+
+        __inside__ --;
+
+        KW_DECREF(kw)
+        return RETEVENT_INPUT_EVENT_NOT_DEFINED;
+    }
+
+    /*----------------------------------*
+     *  Check AUTHZ
+     *----------------------------------*/
+//     if(ev_desc->authz & EV_AUTHZ_INJECT) {
+//         /*
+//          *  AUTHZ Required
+//          */
+//         json_t *kw_authz = json_pack("{s:s}",
+//             "event", event
+//         );
+//         if(kw) {
+//             json_object_set(kw_authz, "kw", kw);
+//         } else {
+//             json_object_set_new(kw_authz, "kw", json_object());
+//         }
+//         if(!gobj_user_has_authz(
+//                 dst, "__inject_event__", kw_authz, src)
+//           ) {
+//             log_error(0,
+//                 "gobj",         "%s", gobj_full_name(dst),
+//                 "function",     "%s", __FUNCTION__,
+//                 "msgset",       "%s", MSGSET_OAUTH_ERROR,
+//                 "msg",          "%s", "No permission to inject event",
+//                 //"user",         "%s", gobj_get_user(src),
+//                 "gclass",       "%s", gobj_gclass_name(dst),
+//                 "event",        "%s", event?event:"",
+//                 NULL
+//             );
+//             __inside__ --;
+//             KW_DECREF(kw)
+//             return -403;
+//         }
+//     }
+
+    /*----------------------------------*
+     *  Search event in current state
+     *----------------------------------*/
+    BOOL tracea_states = __trace_gobj_states__(dst)?TRUE:FALSE;
+
+    int next_state = -1;
+    fsm_cell_t *cell = 0;
+    fsm_table_t *fsm_table = gobj_fsm_table(dst);
+    if(fsm_table) {
+        int ev = ev_desc - mach->fsm->input_events;
+        cell = fsm_table->cells + mach->current_state * fsm_table->n_events + ev;
+        if(fsm_table->dispatcher) {
+            actions = (EV_ACTION *)fsm_table->dispatcher(mach->current_state, ev, &next_state);
+        } else {
+            actions = (EV_ACTION *)cell->ev_action;
+            next_state = cell->next_state;
+        }
+    } else {
+        while(actions->event) {
+            if(strcasecmp(actions->event, event)==0) {
+                break;
+            }
+            actions++;
+        }
+        if(!actions->event) {
+            actions = 0;
+        }
+    }
+
+    if(actions) {
+        if(tracea) {
+            trace_machine("🔄 mach(%s%s^%s), ev: %s, st(%d:%s), from(%s%s^%s)",
+                (!dst->running)?"!!":"",
+                gobj_gclass_name(dst), gobj_name(dst),
+                event,
+                mach->current_state,
+                mach->fsm->state_names[mach->current_state],
+                (src && !src->running)?"!!":"",
+                gobj_gclass_name(src), gobj_name(src)
+            );
+            if(kw) {
+                if(__trace_gobj_ev_kw__(dst)) {
+                    log_debug_json(0, kw, "kw");
+                }
+            }
+        }
+
+        /*
+         *  IMPORTANT HACK
+         *  Set new state BEFORE run 'action'
+         *
+         *  The next state is changed before executing the action.
+         *  If you don’t like this behavior, set the next-state to NULL
+         *  and use change_state() to change the state inside the actions.
+         */
+        BOOL state_changed = FALSE;
+        if(next_state >= 0) {
+            state_changed = _change_state_index(dst, next_state);
+        } else if(actions->next_state) {
+            state_changed = _change_state(dst, actions->next_state);
+        }
+        if(ev_desc->flag & EVF_KW_WRITING) {
+            KW_INCREF(kw);
+        }
+        if(actions->action) {
+            // Execute the action
+            if(__action_latency_enabled__ && cell) {
+                uint64_t t0 = uv_hrtime();
+                ret = (*actions->action)(mach->self, event, kw, src);
+                record_action_latency(fsm_table, cell, uv_hrtime() - t0);
+            } else {
+                ret = (*actions->action)(mach->self, event, kw, src);
+            }
+        } else {
+            // No action, there is nothing amiss!.
+            ret = RETEVENT_NO_ACTION;
+            KW_DECREF(kw)
+        }
+
+        if((src && __trace_gobj_event_monitor__(src)) || (dst &&  __trace_gobj_event_monitor__(dst))) {
+            monitor_event(MTOR_EVENT_ACCEPTED, event, src, dst);
+        }
+
+        if(state_changed && gobj_is_running(dst)) {
+            if(tracea || tracea_states) {
+                trace_machine("🔀🔀 mach(%s%s^%s), st(%d:%s%s%s), ev: %s, from(%s%s^%s)",
+                    (!dst->running)?"!!":"",
+                    gobj_gclass_name(dst), gobj_name(dst),
+                    mach->current_state,
+                    On_Black RGreen,
+                    mach->fsm->state_names[mach->current_state],
+                    Color_Off,
+                    event,
+                    (src && !src->running)?"!!":"",
+                    gobj_gclass_name(src), gobj_name(src)
+                );
+            }
+
+            notify_state_changed(dst);
+        }
+
+        if(tracea && !(dst->obflag & obflag_destroyed)) {
+            trace_machine("<- mach(%s%s^%s), ev: %s, st(%d:%s), ret: %d",
+                (!dst->running)?"!!":"",
+                gobj_gclass_name(dst), gobj_name(dst),
+                event,
+                mach->current_state,
+                mach->fsm->state_names[mach->current_state],
+                ret
+            );
+        }
+
+        __inside__ --;
+
+        return ret;
+    }
+
+    if(!(dst->obflag & obflag_destroyed)) {
+        if(tracea) {
+            trace_machine("📛 mach(%s%s^%s), st: %s, ev: %s, 📛📛EVENT REFUSED📛📛 from %s",
+                        (!dst->running)?"!!":"",
+                gobj_gclass_name(dst), gobj_name(dst),
+                mach->fsm->state_names[mach->current_state],
+                event,
+                gobj_gclass_name(src)
+            );
+        } else {
+            log_warning(LOG_OPT_TRACE_STACK,
+                "gobj",         "%s", gobj_short_name(dst),
+                "msgset",       "%s", MSGSET_SMACHINE_ERROR,
+                "msg",          "%s", "Event REFUSED",
+                "orig-gclass",  "%s", gobj_full_name(src),
+                "dest-gclass",  "%s", gobj_full_name(dst),
+                "state",        "%s", mach->fsm->state_names[mach->current_state],
                 "event",        "%s", event,
                 NULL
             );
-            KW_DECREF(kw)
-            return 0;
         }
     }
+    if((src && __trace_gobj_event_monitor__(src)) || __trace_gobj_event_monitor__(dst)) {
+         monitor_event(MTOR_EVENT_REFUSED, event, src, dst);
+    }
+
+    KW_DECREF(kw)
+
+    __inside__ --;
+
+    return RETEVENT_NOT_ACCEPTED;
+}
+
+/***************************************************************************
+ *  Send the event to all gclass's instances in the gobj's tree.
+ ***************************************************************************/
+PRIVATE int cb_send_event(hgobj child_, void *user_data, void *user_data2, void *user_data3)
+{
+    GObj_t *child = child_;
+    const char *event = user_data;
+    json_t *kw = user_data2;
+    hgobj src = user_data3;
+
+    JSON_INCREF(kw);
+    gobj_send_event(child, event, kw, src);
+
+    return 0;
+}
+PUBLIC int gobj_send_event_to_gclass_instances(
+    hgobj gobj,
+    const char *gclass_name,
+    const char *event,
+    json_t *kw,
+    hgobj src)
+{
+    if(!gobj) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        return -1;
+    }
+    if(empty_string(gclass_name)) {
+        log_error(0,
+            "gobj",         "%s", gobj_full_name(gobj),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gclass_name NULL",
+            NULL
+        );
+        return -1;
+    }
+
+    if(gobj_typeof_gclass(gobj, gclass_name)) {
+        JSON_INCREF(kw);
+        gobj_send_event(gobj, event, kw, src);
+    }
+
+    dl_list_t dl_list;
+    json_t *jn_filter = json_pack("{s:s}",
+        "__gclass_name__", gclass_name
+    );
+    gobj_match_childs_tree(gobj, &dl_list, jn_filter);
+
+    rc_walk_by_list(
+        &dl_list,
+        WALK_LAST2FIRST,
+        (cb_walking_t)cb_send_event,
+        (void *)event,
+        kw,
+        src
+    );
+    rc_free_iter(&dl_list, 0, 0);
+
+    JSON_DECREF(kw);
+    return 0;
+}
+
+/***************************************************************************
+ *  Send the event to child with name ``name``
+ ***************************************************************************/
+PUBLIC int gobj_send_event_to_named_child(
+    hgobj gobj,
+    const char *name,
+    const char *event,
+    json_t *kw,
+    hgobj src)
+{
+    if(!gobj) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        return -1;
+    }
+    if(empty_string(name)) {
+        log_error(0,
+            "gobj",         "%s", gobj_full_name(gobj),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "name NULL",
+            NULL
+        );
+        return -1;
+    }
+
+    dl_list_t dl_list;
+    json_t *jn_filter = json_pack("{s:s}",
+        "__gobj_name__", name
+    );
+    gobj_match_childs(gobj, &dl_list, jn_filter);
+
+    rc_walk_by_list(
+        &dl_list,
+        WALK_LAST2FIRST,
+        (cb_walking_t)cb_send_event,
+        (void *)event,
+        kw,
+        src
+    );
+    rc_free_iter(&dl_list, 0, 0);
+
+    JSON_DECREF(kw);
+    return 0;
+}
+
+/***************************************************************************
+ *  Send the event to all childs
+ ***************************************************************************/
+PRIVATE int cb_send_event_if_in(rc_instance_t *i_child, hgobj child_, void *user_data, void *user_data2, void *user_data3)
+{
+    GObj_t *child = child_;
+    const char *event = user_data;
+    json_t *kw = user_data2;
+    hgobj src = user_data3;
+
+    if(gobj_event_in_input_event_list(child, event, 0)) {
+        JSON_INCREF(kw)
+        gobj_send_event(child, event, kw, src);
+    }
+
+    return 0;
+}
+PUBLIC int gobj_send_event_to_childs(
+    hgobj gobj,
+    const char *event,
+    json_t *kw,
+    hgobj src)
+{
+    if(!gobj) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        return -1;
+    }
+
+    gobj_walk_gobj_childs(gobj, WALK_FIRST2LAST, cb_send_event_if_in, (void *)event, kw, src);
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Send the event to all childs tree
+ *  same as gobj_send_event_to_childs but recursive
+ ***************************************************************************/
+PUBLIC int gobj_send_event_to_childs_tree(
+    hgobj gobj,
+    const char *event,
+    json_t *kw,
+    hgobj src)
+{
+    if(!gobj) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        return -1;
+    }
+
+    gobj_walk_gobj_childs_tree(gobj, WALK_FIRST2LAST, cb_send_event_if_in, (void *)event, kw, src);
+
+    JSON_DECREF(kw)
+    return 0;
+}
+
+/***************************************************************************
+ *  Same as gobj_send_event_to_childs
+ *  but recursive by levels instead of traverse the tree.
+ *  - by levels: first all childs, next all childs of the childs, etc
+ ***************************************************************************/
+PUBLIC int gobj_send_event_to_childs_tree_by_level(
+    hgobj gobj,
+    const char *event,
+    json_t *kw,
+    hgobj src)
+{
+    if(!gobj) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        return -1;
+    }
+
+    gobj_walk_gobj_childs_tree(
+        gobj,
+        WALK_BYLEVEL|WALK_FIRST2LAST,
+        cb_send_event_if_in,
+        (void *)event,
+        kw,
+        src
+    );
 
-    BOOL tracea = is_machine_tracing(publisher) &&
-        !is_machine_not_tracing(publisher) &&
-        __trace_gobj_subscriptions__(publisher);
-    if(tracea) {
-        trace_machine("🔝🔝 mach(%s%s^%s), ev: %s, st: %s",
-            (!publisher->running)?"!!":"",
-            gobj_gclass_name(publisher), gobj_name(publisher),
-            event,
-            publisher->mach->fsm->state_names[publisher->mach->current_state]
+    JSON_DECREF(kw)
+    return 0;
+}
+
+
+
+
+                    /*---------------------------------*
+                     *  SECTION: Event queue
+                     *---------------------------------*/
+
+
+
+
+/***************************************************************************
+ *  Grow the ring buffer of posted events
+ ***************************************************************************/
+PRIVATE int grow_event_queue(void)
+{
+    uint32_t new_size = __event_queue_size__? __event_queue_size__ * 2 : 256;
+    posted_event_t *new_queue = gbmem_malloc(sizeof(posted_event_t) * new_size);
+    if(!new_queue) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for event queue",
+            "size",         "%d", (int)new_size,
+            NULL
         );
-        if(__trace_gobj_ev_kw__(publisher)) {
-            log_debug_json(0, kw, "kw");
+        return -1;
+    }
+    for(uint32_t i=0; i<__event_queue_count__; i++) {
+        new_queue[i] = __event_queue__[(__event_queue_head__ + i) & (__event_queue_size__ - 1)];
+    }
+    GBMEM_FREE(__event_queue__);
+    __event_queue__ = new_queue;
+    __event_queue_size__ = new_size;
+    __event_queue_head__ = 0;
+    return 0;
+}
+
+/***************************************************************************
+ *  Events posted to a gobj being freed are discarded,
+ *  and the reference as src is cleared.
+ ***************************************************************************/
+PRIVATE void purge_posted_events(GObj_t *gobj)
+{
+    for(uint32_t i=0; i<__event_queue_count__ && gobj->__posted_events__; i++) {
+        posted_event_t *posted = &__event_queue__[(__event_queue_head__ + i) & (__event_queue_size__ - 1)];
+        if(posted->dst == gobj) {
+            posted->dst = 0;
+            KW_DECREF(posted->kw);
+            gobj->__posted_events__--;
+        }
+        if(posted->src == gobj) {
+            posted->src = 0;
+            gobj->__posted_events__--;
         }
     }
-    BOOL tracea2 = __trace_gobj_subscriptions2__(publisher);
+}
 
-    /*----------------------------------------------------------*
-     *  Own publication method
-     *  Return:
-     *     -1  broke                        -> return
-     *      0  continue without publish     -> return
-     *      1  publish and continue         -> continue below
-     *----------------------------------------------------------*/
-    if(publisher->gclass->gmt.mt_publish_event) {
-        int topublish = publisher->gclass->gmt.mt_publish_event(
-            publisher,
-            event,
-            kw  // not owned
-        );
-        if(topublish<=0) {
-            KW_DECREF(kw)
+/***************************************************************************
+ *  Mailbox: push, from any thread
+ ***************************************************************************/
+PRIVATE inline void mailbox_push(mailbox_node_t *node)
+{
+    __atomic_store_n(&node->next, 0, __ATOMIC_RELAXED);
+    mailbox_node_t *prev = __atomic_exchange_n(&__mailbox_head__, node, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+}
+
+/***************************************************************************
+ *  Mailbox: pop, only from the yuno's thread.
+ *  Return 0 if empty or if a producer is in the middle of a push
+ *  (that producer will wake up the loop again).
+ ***************************************************************************/
+PRIVATE mailbox_node_t *mailbox_pop(void)
+{
+    mailbox_node_t *tail = __mailbox_tail__;
+    mailbox_node_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    if(tail == &__mailbox_stub__) {
+        if(!next) {
             return 0;
         }
+        __mailbox_tail__ = next;
+        tail = next;
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
     }
+    if(next) {
+        __mailbox_tail__ = next;
+        return tail;
+    }
+    if(tail != __atomic_load_n(&__mailbox_head__, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    mailbox_push(&__mailbox_stub__);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if(next) {
+        __mailbox_tail__ = next;
+        return tail;
+    }
+    return 0;
+}
 
-    /*--------------------------------------------------------------*
-     *  Default publication method
-     *--------------------------------------------------------------*/
-    BOOL global_kw_shared = kw_get_bool(kw, "__share_kw__", FALSE, KW_WILD_NUMBER);
-    dl_list_t *dl_subs = &publisher->dl_subscriptions;
-    int sent_count = 0;
-    hsdata subs; rc_instance_t *i_subs; hsdata next_subs;
-    i_subs = rc_first_instance(dl_subs, (rc_resource_t **)&subs);
-    while(i_subs) {
-        // TODO no protegido contra borrados (protegido contra el borrado de un subs)
-        /*
-         *  Next subs
-         */
-        i_subs = rc_next_instance(i_subs, (rc_resource_t **)&next_subs);
+/***************************************************************************
+ *  Hash of a gobj pointer
+ ***************************************************************************/
+PRIVATE inline uint32_t live_gobj_hash(GObj_t *gobj)
+{
+    uint64_t p = (uint64_t)(uintptr_t)gobj;
+    p ^= p >> 33;
+    p *= 0xff51afd7ed558ccdULL;
+    p ^= p >> 33;
+    return (uint32_t)p;
+}
 
-        /*-------------------------------------*
-         *  Pre-filter
-         *  kw NOT owned! you can modify the publishing kw
-         *  Return:
-         *     -1  broke
-         *      0  continue without publish
-         *      1  continue to publish
-         *-------------------------------------*/
-        if(publisher->gclass->gmt.mt_publication_pre_filter) {
-            int topublish = publisher->gclass->gmt.mt_publication_pre_filter(
-                publisher,
-                subs,
-                event,
-                kw  // not owned
+/***************************************************************************
+ *  Live gobjs: add the new gobj
+ ***************************************************************************/
+PRIVATE int live_gobj_add(GObj_t *gobj)
+{
+    if(!__live_gobjs__ || (__live_gobjs_used__ + 1) * 2 > __live_gobjs_mask__ + 1) {
+        uint32_t new_size = __live_gobjs__? (__live_gobjs_mask__ + 1) * 2 : 256;
+        GObj_t **new_slots = gbmem_malloc(sizeof(GObj_t *) * new_size);
+        if(!new_slots) {
+            log_error(0,
+                "gobj",         "%s", __FILE__,
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_MEMORY_ERROR,
+                "msg",          "%s", "no memory for live gobjs, events from threads will be discarded",
+                "size",         "%d", (int)new_size,
+                NULL
             );
-            if(topublish<0) {
-                break;
-            } else if(topublish==0) {
-                /*
-                 *  Next subs
-                 */
-                //i_subs = rc_next_instance(i_subs, (rc_resource_t **)&subs);
-                subs = next_subs;
-                continue;
-            }
-        }
-        GObj_t *subscriber = sdata_read_pointer(subs, "subscriber");
-        if(!(subscriber && !(subscriber->obflag & obflag_destroyed))) {
-            /*
-             *  Next subs
-             */
-            //i_subs = rc_next_instance(i_subs, (rc_resource_t **)&subs);
-            subs = next_subs;
-            continue;
+            return -1;
         }
-
-        /*
-         *  Check if event null or event in event_list
-         */
-        subs_flag_t subs_flag = sdata_read_uint64(subs, "subs_flag");
-        const char *event_ = sdata_read_str(subs, "event");
-        if(empty_string(event_) || strcasecmp(event_, event)==0) {
-            json_t *__config__ = sdata_read_json(subs, "__config__");
-            json_t *__global__ = sdata_read_json(subs, "__global__");
-            json_t *__local__ = sdata_read_json(subs, "__local__");
-            json_t *__filter__ = sdata_read_json(subs, "__filter__");
-
-            /*
-             *  Check renamed_event
-             */
-            const char *event_name = sdata_read_str(subs, "renamed_event");
-            if(empty_string(event_name)) {
-                event_name = event;
+        for(uint32_t j=0; __live_gobjs__ && j<=__live_gobjs_mask__; j++) {
+            if(__live_gobjs__[j]) {
+                uint32_t i = live_gobj_hash(__live_gobjs__[j]) & (new_size - 1);
+                while(new_slots[i]) {
+                    i = (i + 1) & (new_size - 1);
+                }
+                new_slots[i] = __live_gobjs__[j];
             }
+        }
+        GBMEM_FREE(__live_gobjs__);
+        __live_gobjs__ = new_slots;
+        __live_gobjs_mask__ = new_size - 1;
+    }
+    uint32_t i = live_gobj_hash(gobj) & __live_gobjs_mask__;
+    while(__live_gobjs__[i]) {
+        i = (i + 1) & __live_gobjs_mask__;
+    }
+    __live_gobjs__[i] = gobj;
+    __live_gobjs_used__++;
+    return 0;
+}
 
-            /*
-             *  Duplicate the kw to publish if not shared
-             */
-            json_t *kw2publish = 0;
-            if(global_kw_shared || (subs_flag & __share_kw__)) {
-                KW_INCREF(kw);
-                kw2publish = kw;
-            } else {
-                kw2publish = kw_duplicate(kw);
-            }
+/***************************************************************************
+ *  Live gobjs: find the gobj, return the slot or -1
+ ***************************************************************************/
+PRIVATE int live_gobj_find(GObj_t *gobj)
+{
+    if(!__live_gobjs__) {
+        return -1;
+    }
+    uint32_t i = live_gobj_hash(gobj) & __live_gobjs_mask__;
+    while(__live_gobjs__[i]) {
+        if(__live_gobjs__[i] == gobj) {
+            return (int)i;
+        }
+        i = (i + 1) & __live_gobjs_mask__;
+    }
+    return -1;
+}
 
-            /*-------------------------------------*
-             *  User filter method or filter parameter
-             *  Return:
-             *     -1  (broke),
-             *      0  continue without publish,
-             *      1  continue and publish
-             *-------------------------------------*/
-            int topublish = 1;
-            if(publisher->gclass->gmt.mt_publication_filter) {
-                topublish = publisher->gclass->gmt.mt_publication_filter(
-                    publisher,
-                    event,
-                    kw2publish,  // not owned
-                    subscriber
-                );
-            } else if(__filter__) {
-                if(__publish_event_match__) {
-                    KW_INCREF(__filter__);
-                    topublish = __publish_event_match__(kw2publish , __filter__);
-                }
-            }
+/***************************************************************************
+ *  Live gobjs: remove the gobj being freed
+ ***************************************************************************/
+PRIVATE void live_gobj_remove(GObj_t *gobj)
+{
+    int slot = live_gobj_find(gobj);
+    if(slot < 0) {
+        return;
+    }
+    uint32_t mask = __live_gobjs_mask__;
+    uint32_t i = (uint32_t)slot;
+    __live_gobjs__[i] = 0;
+    __live_gobjs_used__--;
 
-            if(topublish<0) {
-                break;
-            } else if(topublish==0) {
-                /*
-                 *  Must not be published
-                 *  Next subs
-                 */
-                KW_DECREF(kw2publish);
-                //i_subs = rc_next_instance(i_subs, (rc_resource_t **)&subs);
-                subs = next_subs;
-                continue;
-            }
+    /*
+     *  Backward shift of the next slots of the cluster
+     */
+    uint32_t j = (i + 1) & mask;
+    while(__live_gobjs__[j]) {
+        uint32_t home = live_gobj_hash(__live_gobjs__[j]) & mask;
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            __live_gobjs__[i] = __live_gobjs__[j];
+            __live_gobjs__[j] = 0;
+            i = j;
+        }
+        j = (j + 1) & mask;
+    }
+}
 
-            /*
-             *  Check if System event: don't send if subscriber has not it
-             */
-            if(ev && ev->flag & EVF_SYSTEM_EVENT) {
-                if(!gobj_input_event(subscriber, event)) {
-                    KW_DECREF(kw2publish);
-                    i_subs = rc_next_instance(i_subs, (rc_resource_t **)&subs);
-                    continue;
-                }
-            }
+/***************************************************************************
+ *  Async handle: send the events of mailbox
+ ***************************************************************************/
+PRIVATE void on_mailbox_async(uv_async_t *handle)
+{
+    uint64_t t0 = uv_hrtime();
+    uint32_t sent = 0;
+    mailbox_node_t *node;
 
-            /*
-             *  Remove local keys
-             */
-            if(__local__) {
-                kw_pop(
-                    kw2publish,
-                    __local__ // not owned
-                );
-            }
+    /*
+     *  Clear before draining: pushes from now on will wake up again.
+     */
+    __atomic_store_n(&__mailbox_wakeup_pending__, 0, __ATOMIC_SEQ_CST);
 
-            /*
-             *  Apply transformation filters
-             */
-            if(__config__) {
-                json_t *jn_trans_filters = kw_get_dict_value(__config__, "__trans_filter__", 0, 0);
-                if(jn_trans_filters) {
-                    kw2publish = apply_trans_filters(kw2publish, jn_trans_filters);
-                }
+    while((node=mailbox_pop())) {
+        /*
+         *  The dst is validated here, in the yuno's thread:
+         *  events to gobjs already freed or being destroyed are discarded.
+         */
+        GObj_t *dst = node->dst;
+        if(live_gobj_find(dst) >= 0 &&
+                dst->__instance_id__ == node->dst_instance_id &&
+                !(dst->obflag & (obflag_destroyed|obflag_destroying))) {
+            json_t *kw = 0;
+            if(node->kw) {
+                kw = legalstring2json(node->kw, TRUE);
             }
-
-            /*
-             *  Add global keys
-             */
-            if(__global__) {
-                json_object_update(kw2publish, __global__);
+            if(!node->kw || kw) {
+                gobj_send_event(dst, node->event, kw, 0);
+                sent++;
             }
+        }
+        free(node);
 
+        if(sent >= __event_queue_batch_size__ ||
+                uv_hrtime() - t0 >= __event_queue_max_drain_ns__) {
             /*
-             *  Send event
+             *  Continue in the next loop iteration
              */
-            if(tracea2) {
-                trace_machine("🔝🔄 mach(%s%s), ev: %s, from(%s%s)",
-                    (!subscriber->running)?"!!":"",
-                    gobj_short_name(subscriber),
-                    event,
-                    (publisher && !publisher->running)?"!!":"",
-                    gobj_short_name(publisher)
-                );
-                if(__trace_gobj_ev_kw__(publisher)) {
-                    log_debug_json(0, kw2publish, "kw");
-                }
+            if(__atomic_exchange_n(&__mailbox_wakeup_pending__, 1, __ATOMIC_SEQ_CST)==0) {
+                uv_async_send(&__mailbox_async__);
             }
+            break;
+        }
+    }
+}
 
-            int ret = gobj_send_event(
-                subscriber,
-                event_name,
-                kw2publish,
-                publisher
-            );
-            if(ret < 0 && (subs_flag & __own_event__)) {
-                sent_count = -1; // Return of -1 indicates that someone owned the event
-                break;
-            }
-            sent_count++;
+/***************************************************************************
+ *  Free the queue, pending events are discarded
+ ***************************************************************************/
+PRIVATE void free_event_queue(void)
+{
+    gobj_stop_event_queue();
 
-            if(publisher->obflag & obflag_destroyed) {
-                /*
-                 *  break all, self publisher deleted
-                 */
-                break;
-            }
+    while(__event_queue_count__) {
+        posted_event_t *posted = &__event_queue__[__event_queue_head__];
+        __event_queue_head__ = (__event_queue_head__ + 1) & (__event_queue_size__ - 1);
+        __event_queue_count__--;
+        if(posted->dst) {
+            posted->dst->__posted_events__--;
+            KW_DECREF(posted->kw);
+        }
+        if(posted->src) {
+            posted->src->__posted_events__--;
         }
-
-        /*
-         *  Next subs
-         */
-        //i_subs = rc_next_instance(i_subs, (rc_resource_t **)&subs);
-        subs = next_subs;
     }
+    GBMEM_FREE(__event_queue__);
+    __event_queue_size__ = 0;
+    __event_queue_head__ = 0;
 
-    if(!sent_count) {
-        if(!ev || !(ev->flag & EVF_NO_WARN_SUBS)) {
-            log_warning(0,
-                "publisher",         "%s", gobj_full_name(publisher),
-                "msgset",       "%s", MSGSET_MONITORING,
-                "msg",          "%s", "Publish event WITHOUT subscribers",
-                "event",        "%s", event,
-                NULL
-            );
-            if(__trace_gobj_ev_kw__(publisher)) {
-                log_debug_json(0, kw, "kw");
-            }
-        }
+    mailbox_node_t *node;
+    while((node=mailbox_pop())) {
+        free(node);
     }
 
-    KW_DECREF(kw)
-    return sent_count;
+    GBMEM_FREE(__live_gobjs__);
+    __live_gobjs_mask__ = 0;
+    __live_gobjs_used__ = 0;
 }
 
 /***************************************************************************
- *  Inject event
- *
- *  I only see event parameter,
- *  the remains parameters are high level specifics
- *  and transparents for me.
- *
- *  Return:
- *      - no permission:.                       -403
- *      - no destine or destine destroyed:      -1000
- *      - event not accepted:                   -1001
- *      - if event is accepted:
- *          - no action:                        -1002
- *          - input event not defined           -1003
- *          - an action is defined:             the return of action.
+ *  Idle handle: while there are pending events the loop must not block in poll
  ***************************************************************************/
-#define RETEVENT_NO_GOBJ                    -1000
-#define RETEVENT_NOT_ACCEPTED               -1001
-#define RETEVENT_NO_ACTION                  -1002
-#define RETEVENT_INPUT_EVENT_NOT_DEFINED    -1003
+PRIVATE void on_event_queue_idle(uv_idle_t *handle)
+{
+}
+
+/***************************************************************************
+ *  Check handle: drain the queue, once by loop iteration
+ ***************************************************************************/
+PRIVATE void on_event_queue_check(uv_check_t *handle)
+{
+    gobj_drain_event_queue();
+}
 
 /***************************************************************************
- *  Send event
+ *  Post event: enqueue the event to be sent later by the yuno's loop.
  ***************************************************************************/
-PUBLIC int gobj_send_event(
+PUBLIC int gobj_post_event(
     hgobj dst_,
     const char *event,
     json_t *kw,
@@ -6949,11 +10245,6 @@ PUBLIC int gobj_send_event(
     GObj_t * dst = dst_;
     GObj_t * src = src_;
 
-    SMachine_t * mach;
-    register EV_ACTION *actions;
-    int ret;
-    BOOL tracea;
-
     if(!dst) {
         log_error(0,
             "gobj",         "%s", __FILE__,
@@ -6976,1061 +10267,1311 @@ PUBLIC int gobj_send_event(
         KW_DECREF(kw)
         return RETEVENT_NO_GOBJ;
     }
+    if(src && (src->obflag & obflag_destroyed)) {
+        src = 0;
+    }
+    event_id_t event_id = gobj_event_atom(event);
+    if(!event_id) {
+        log_error(0,
+            "gobj",         "%s", gobj_short_name(dst),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "event EMPTY",
+            NULL
+        );
+        KW_DECREF(kw)
+        return RETEVENT_INPUT_EVENT_NOT_DEFINED;
+    }
 
-    __inside__ ++;
+    if(__event_queue_count__ >= __event_queue_size__) {
+        if(grow_event_queue()<0) {
+            KW_DECREF(kw)
+            return -1;
+        }
+    }
+    posted_event_t *posted = &__event_queue__[
+        (__event_queue_head__ + __event_queue_count__) & (__event_queue_size__ - 1)
+    ];
+    posted->dst = dst;
+    posted->src = src;
+    posted->event_id = event_id;
+    posted->kw = kw;
+    __event_queue_count__++;
 
-    tracea = is_machine_tracing(dst) && !is_machine_not_tracing(src);
-    mach = dst->mach;
-    actions = mach->fsm->states[mach->current_state];
+    dst->__posted_events__++;
+    if(src) {
+        src->__posted_events__++;
+    }
 
-    const EVENT *ev_desc = gobj_input_event(dst, event);
-    if(!ev_desc) {
-        if(dst->gclass->gmt.mt_inject_event) {
-            __inside__ --;
-            if(tracea) {
-                trace_machine("🔃 mach(%s%s^%s), ev: %s, st(%d:%s), from(%s%s^%s)",
-                    (!dst->running)?"!!":"",
-                    gobj_gclass_name(dst), gobj_name(dst),
-                    event,
-                    mach->current_state,
-                    mach->fsm->state_names[mach->current_state],
-                    (src && !src->running)?"!!":"",
-                    gobj_gclass_name(src), gobj_name(src)
-                );
-                if(kw) {
-                    if(__trace_gobj_ev_kw__(dst)) {
-                        log_debug_json(0, kw, "kw");
-                    }
-                }
-            }
-            return dst->gclass->gmt.mt_inject_event(dst, event, kw, src);
+    if(__event_queue_loop__ && __event_queue_count__ == 1) {
+        uv_idle_start(&__event_queue_idle__, on_event_queue_idle);
+    }
+    return 0;
+}
+
+/***************************************************************************
+ *  Send the posted events, in order,
+ *  until the queue is empty or a limit (batch size or time) is reached.
+ *  Return the number of events sent.
+ ***************************************************************************/
+PUBLIC int gobj_drain_event_queue(void)
+{
+    uint64_t t0 = uv_hrtime();
+    uint32_t sent = 0;
+
+    while(__event_queue_count__ && sent < __event_queue_batch_size__) {
+        posted_event_t posted = __event_queue__[__event_queue_head__];
+        __event_queue_head__ = (__event_queue_head__ + 1) & (__event_queue_size__ - 1);
+        __event_queue_count__--;
+
+        if(posted.src) {
+            posted.src->__posted_events__--;
         }
-        if(tracea) {
-            trace_machine("📛 mach(%s%s^%s), st: %s, ev: %s, 📛📛EVENT NOT DEFINED📛📛",
-                        (!dst->running)?"!!":"",
-                gobj_gclass_name(dst), gobj_name(dst),
-                mach->fsm->state_names[mach->current_state],
-                event
-            );
-        } else {
-            log_error(0,
-                "gobj",         "%s", gobj_short_name(dst),
-                "function",     "%s", __FUNCTION__,
-                "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-                "msg",          "%s", "Event NOT DEFINED in input_events array",
-                "event",        "%s", event,
-                "src",          "%s", gobj_short_name(src),
-                "state",        "%s", gobj_current_state(dst),
-                "full_src",     "%s", gobj_full_name(src),
-                "full_dst",     "%s", gobj_full_name(dst),
-                NULL
-            );
+        if(!posted.dst) {
+            continue; // dst freed, kw already decref
+        }
+        posted.dst->__posted_events__--;
+        if(posted.dst->obflag & (obflag_destroyed|obflag_destroying)) {
+            KW_DECREF(posted.kw);
+            continue;
         }
 
-        __inside__ --;
+        gobj_send_event_id(posted.dst, posted.event_id, posted.kw, posted.src);
+        sent++;
 
-        KW_DECREF(kw)
-        return RETEVENT_INPUT_EVENT_NOT_DEFINED;
+        if(uv_hrtime() - t0 >= __event_queue_max_drain_ns__) {
+            break;
+        }
     }
 
-    /*----------------------------------*
-     *  Check AUTHZ
-     *----------------------------------*/
-//     if(ev_desc->authz & EV_AUTHZ_INJECT) {
-//         /*
-//          *  AUTHZ Required
-//          */
-//         json_t *kw_authz = json_pack("{s:s}",
-//             "event", event
-//         );
-//         if(kw) {
-//             json_object_set(kw_authz, "kw", kw);
-//         } else {
-//             json_object_set_new(kw_authz, "kw", json_object());
-//         }
-//         if(!gobj_user_has_authz(
-//                 dst, "__inject_event__", kw_authz, src)
-//           ) {
-//             log_error(0,
-//                 "gobj",         "%s", gobj_full_name(dst),
-//                 "function",     "%s", __FUNCTION__,
-//                 "msgset",       "%s", MSGSET_OAUTH_ERROR,
-//                 "msg",          "%s", "No permission to inject event",
-//                 //"user",         "%s", gobj_get_user(src),
-//                 "gclass",       "%s", gobj_gclass_name(dst),
-//                 "event",        "%s", event?event:"",
-//                 NULL
-//             );
-//             __inside__ --;
-//             KW_DECREF(kw)
-//             return -403;
-//         }
-//     }
+    if(__event_queue_loop__ && !__event_queue_count__) {
+        uv_idle_stop(&__event_queue_idle__);
+    }
+    return sent;
+}
 
-    /*----------------------------------*
-     *  Search event in current state
-     *----------------------------------*/
-    BOOL tracea_states = __trace_gobj_states__(dst)?TRUE:FALSE;
+/***************************************************************************
+ *  Limits of draining by loop iteration, 0 to keep the current value.
+ ***************************************************************************/
+PUBLIC void gobj_set_event_queue_limits(uint32_t batch_size, uint32_t max_drain_us)
+{
+    if(batch_size) {
+        __event_queue_batch_size__ = batch_size;
+    }
+    if(max_drain_us) {
+        __event_queue_max_drain_ns__ = (uint64_t)max_drain_us * 1000;
+    }
+}
 
-    while(actions->event) {
-        if(strcasecmp(actions->event, event)==0) {
-            if(tracea) {
-                trace_machine("🔄 mach(%s%s^%s), ev: %s, st(%d:%s), from(%s%s^%s)",
-                    (!dst->running)?"!!":"",
-                    gobj_gclass_name(dst), gobj_name(dst),
-                    event,
-                    mach->current_state,
-                    mach->fsm->state_names[mach->current_state],
-                    (src && !src->running)?"!!":"",
-                    gobj_gclass_name(src), gobj_name(src)
-                );
-                if(kw) {
-                    if(__trace_gobj_ev_kw__(dst)) {
-                        log_debug_json(0, kw, "kw");
-                    }
-                }
-            }
+/***************************************************************************
+ *  Drain the queue from the yuno's loop
+ ***************************************************************************/
+PUBLIC int gobj_start_event_queue(uv_loop_t *loop)
+{
+    if(__event_queue_loop__) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_OPERATIONAL_ERROR,
+            "msg",          "%s", "event queue ALREADY started",
+            NULL
+        );
+        return -1;
+    }
+    if(__event_queue_closing__) {
+        /*
+         *  The handles can't be initialized again until libuv has closed them.
+         */
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_OPERATIONAL_ERROR,
+            "msg",          "%s", "event queue handles still closing, run the loop before restarting",
+            "closing",      "%d", __event_queue_closing__,
+            NULL
+        );
+        return -1;
+    }
+    if(!loop) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "loop NULL",
+            NULL
+        );
+        return -1;
+    }
+    /*
+     *  The check and async handles don't keep the loop alive,
+     *  uv_run() returns when the yuno has nothing else to do.
+     *  The idle handle is ref'd: while there are posted events the loop doesn't end.
+     */
+    uv_check_init(loop, &__event_queue_check__);
+    uv_check_start(&__event_queue_check__, on_event_queue_check);
+    uv_unref((uv_handle_t *)&__event_queue_check__);
+    uv_idle_init(loop, &__event_queue_idle__);
+    if(__event_queue_count__) {
+        uv_idle_start(&__event_queue_idle__, on_event_queue_idle);
+    }
+    uv_async_init(loop, &__mailbox_async__, on_mailbox_async);
+    uv_unref((uv_handle_t *)&__mailbox_async__);
 
-            /*
-             *  IMPORTANT HACK
-             *  Set new state BEFORE run 'action'
-             *
-             *  The next state is changed before executing the action.
-             *  If you don’t like this behavior, set the next-state to NULL
-             *  and use change_state() to change the state inside the actions.
-             */
-            BOOL state_changed = FALSE;
-            if(actions->next_state) {
-                state_changed = _change_state(dst, actions->next_state);
-            }
-            if(ev_desc->flag & EVF_KW_WRITING) {
-                KW_INCREF(kw);
-            }
-            if(actions->action) {
-                // Execute the action
-                ret = (*actions->action)(mach->self, event, kw, src);
-            } else {
-                // No action, there is nothing amiss!.
-                ret = RETEVENT_NO_ACTION;
-                KW_DECREF(kw)
-            }
+    __atomic_store_n(&__event_queue_loop__, loop, __ATOMIC_SEQ_CST);
 
-            if((src && __trace_gobj_event_monitor__(src)) || (dst &&  __trace_gobj_event_monitor__(dst))) {
-                monitor_event(MTOR_EVENT_ACCEPTED, event, src, dst);
-            }
+    /*
+     *  Events pushed before a previous stop
+     */
+    if(__atomic_load_n(&__mailbox_tail__->next, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&__mailbox_wakeup_pending__, 1, __ATOMIC_SEQ_CST);
+        uv_async_send(&__mailbox_async__);
+    }
+    return 0;
+}
 
-            if(state_changed && gobj_is_running(dst)) {
-                if(tracea || tracea_states) {
-                    trace_machine("🔀🔀 mach(%s%s^%s), st(%d:%s%s%s), ev: %s, from(%s%s^%s)",
-                        (!dst->running)?"!!":"",
-                        gobj_gclass_name(dst), gobj_name(dst),
-                        mach->current_state,
-                        On_Black RGreen,
-                        mach->fsm->state_names[mach->current_state],
-                        Color_Off,
-                        event,
-                        (src && !src->running)?"!!":"",
-                        gobj_gclass_name(src), gobj_name(src)
-                    );
-                }
+/***************************************************************************
+ *  Close callback of the event queue handles
+ ***************************************************************************/
+PRIVATE void on_event_queue_close(uv_handle_t *handle)
+{
+    __event_queue_closing__--;
+}
 
-                json_t *kw_st = json_object();
-                json_object_set_new(
-                    kw_st,
-                    "previous_state",
-                    json_string(mach->fsm->state_names[mach->last_state])
-                );
-                json_object_set_new(
-                    kw_st,
-                    "current_state",
-                    json_string(mach->fsm->state_names[mach->current_state])
-                );
+/***************************************************************************
+ *  Stop draining from loop. Pending events remain in queue.
+ *  New events from threads are rejected, and it waits for the producers
+ *  that are inside gobj_send_event_from_thread() before closing the async handle.
+ ***************************************************************************/
+PUBLIC void gobj_stop_event_queue(void)
+{
+    if(!__event_queue_loop__) {
+        return;
+    }
+    uv_check_stop(&__event_queue_check__);
+    uv_idle_stop(&__event_queue_idle__);
+    __event_queue_closing__ += 3;
+    uv_close((uv_handle_t *)&__event_queue_check__, on_event_queue_close);
+    uv_close((uv_handle_t *)&__event_queue_idle__, on_event_queue_close);
+    __atomic_store_n(&__event_queue_loop__, 0, __ATOMIC_SEQ_CST);
+    while(__atomic_load_n(&__mailbox_producers__, __ATOMIC_SEQ_CST)) {
+        sched_yield(); // a producer is between the check of loop and uv_async_send()
+    }
+    uv_close((uv_handle_t *)&__mailbox_async__, on_event_queue_close);
+}
 
-                if(dst->gclass->gmt.mt_state_changed) {
-                    dst->gclass->gmt.mt_state_changed(dst, __EV_STATE_CHANGED__, kw_st);
-                } else {
-                    gobj_publish_event(dst, __EV_STATE_CHANGED__, kw_st);
-                }
-            }
+/***************************************************************************
+ *  Return the instance id of the gobj, unique in the yuno and never reused.
+ *  Get it in the yuno's thread, to send events from foreign threads.
+ ***************************************************************************/
+PUBLIC uint64_t gobj_instance_id(hgobj gobj_)
+{
+    GObj_t *gobj = gobj_;
+    if(!gobj) {
+        return 0;
+    }
+    return gobj->__instance_id__;
+}
+
+/***************************************************************************
+ *  Send event from a foreign thread.
+ *  The event is pushed in the yuno's mailbox, the loop is woken up
+ *  only once by batch, and the yuno's thread sends it with gobj_send_event().
+ *  The src of the event is NULL.
+ *  Neither dst nor any json are touched here: gbmem and jansson are not thread-safe,
+ *  and the dst can be freed by the yuno's thread at any moment.
+ *  The kw travels serialized, only libc malloc is used.
+ ***************************************************************************/
+PUBLIC int gobj_send_event_from_thread(
+    hgobj dst,
+    uint64_t dst_instance_id,
+    const char *event,
+    const char *kw)
+{
+    /*
+     *  Not log here, we are not in the yuno's thread.
+     */
+    if(!dst || !dst_instance_id || !event) {
+        return -1;
+    }
+
+    /*
+     *  Register as producer before checking the loop,
+     *  gobj_stop_event_queue() waits for us.
+     */
+    __atomic_add_fetch(&__mailbox_producers__, 1, __ATOMIC_SEQ_CST);
+    if(!__atomic_load_n(&__event_queue_loop__, __ATOMIC_SEQ_CST)) {
+        __atomic_sub_fetch(&__mailbox_producers__, 1, __ATOMIC_SEQ_CST);
+        return -1;
+    }
+
+    size_t len = strlen(event);
+    size_t kw_len = kw? strlen(kw) : 0;
+    mailbox_node_t *node = malloc( // gbmem is not thread-safe
+        sizeof(mailbox_node_t) + len + 1 + (kw? kw_len + 1 : 0)
+    );
+    if(!node) {
+        __atomic_sub_fetch(&__mailbox_producers__, 1, __ATOMIC_SEQ_CST);
+        return -1;
+    }
+    node->dst = dst;
+    node->dst_instance_id = dst_instance_id;
+    memcpy(node->event, event, len + 1);
+    if(kw) {
+        node->kw = node->event + len + 1;
+        memcpy(node->kw, kw, kw_len + 1);
+    } else {
+        node->kw = 0;
+    }
+
+    mailbox_push(node);
+
+    if(__atomic_exchange_n(&__mailbox_wakeup_pending__, 1, __ATOMIC_SEQ_CST)==0) {
+        uv_async_send(&__mailbox_async__);
+    }
+    __atomic_sub_fetch(&__mailbox_producers__, 1, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+/***************************************************************************
+ *  Return the number of pending posted events
+ ***************************************************************************/
+PUBLIC uint32_t gobj_event_queue_size(void)
+{
+    return __event_queue_count__;
+}
+
+
+
+
+                    /*------------------------------------*
+                     *  SECTION: Organization functions
+                     *-----------------------------------*/
 
-            if(tracea && !(dst->obflag & obflag_destroyed)) {
-                trace_machine("<- mach(%s%s^%s), ev: %s, st(%d:%s), ret: %d",
-                    (!dst->running)?"!!":"",
-                    gobj_gclass_name(dst), gobj_name(dst),
-                    event,
-                    mach->current_state,
-                    mach->fsm->state_names[mach->current_state],
-                    ret
-                );
-            }
 
-            __inside__ --;
 
-            return ret;
-        }
-        actions++;
+
+/***************************************************************************
+ *
+ ***************************************************************************/
+PRIVATE GObj_t * _deep_bottom_gobj(GObj_t *gobj)
+{
+    if(gobj->bottom_gobj) {
+        return _deep_bottom_gobj(gobj->bottom_gobj);
+    } else {
+        return gobj;
     }
+}
 
-    if(!(dst->obflag & obflag_destroyed)) {
-        if(tracea) {
-            trace_machine("📛 mach(%s%s^%s), st: %s, ev: %s, 📛📛EVENT REFUSED📛📛 from %s",
-                        (!dst->running)?"!!":"",
-                gobj_gclass_name(dst), gobj_name(dst),
-                mach->fsm->state_names[mach->current_state],
-                event,
-                gobj_gclass_name(src)
-            );
-        } else {
+/***************************************************************************
+ *  Set manually the bottom gobj
+ ***************************************************************************/
+PUBLIC hgobj gobj_set_bottom_gobj(hgobj gobj_, hgobj bottom_gobj)
+{
+    GObj_t * gobj = gobj_;
+
+    if(is_machine_tracing(gobj)) {
+        trace_machine("🔽 set_bottom_gobj('%s') = '%s'",
+            gobj_short_name(gobj),
+            bottom_gobj?gobj_short_name(bottom_gobj):""
+        );
+    }
+    if(gobj->bottom_gobj) {
+        /*
+         *  En los gobj con manual start ellos suelen poner su bottom gobj.
+         *  No lo consideramos un error.
+         *  Ej: emailsender -> curl
+         *      y luego va e intenta poner emailsender -> IOGate
+         *      porque está definido con tree, y no tiene en cuenta la creación de un bottom interno.
+         *
+         */
+        if(bottom_gobj) {
             log_warning(LOG_OPT_TRACE_STACK,
-                "gobj",         "%s", gobj_short_name(dst),
-                "msgset",       "%s", MSGSET_SMACHINE_ERROR,
-                "msg",          "%s", "Event REFUSED",
-                "orig-gclass",  "%s", gobj_full_name(src),
-                "dest-gclass",  "%s", gobj_full_name(dst),
-                "state",        "%s", mach->fsm->state_names[mach->current_state],
-                "event",        "%s", event,
+                "gobj",         "%s", gobj_full_name(gobj),
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+                "msg",          "%s", "bottom_gobj already set",
+                "prev_gobj",    "%s", gobj_full_name(gobj->bottom_gobj),
+                "new_gobj",     "%s", gobj_full_name(bottom_gobj),
                 NULL
             );
         }
+        // anyway set -> NO! -> the already set has preference. New 8-10-2016
+        // anyway set -> YES! -> the new set has preference. New 27-Jan-2017
+        //return 0;
     }
-    if((src && __trace_gobj_event_monitor__(src)) || __trace_gobj_event_monitor__(dst)) {
-         monitor_event(MTOR_EVENT_REFUSED, event, src, dst);
-    }
-
-    KW_DECREF(kw)
-
-    __inside__ --;
-
-    return RETEVENT_NOT_ACCEPTED;
+    gobj->bottom_gobj = bottom_gobj;
+    return 0;
 }
 
 /***************************************************************************
- *  Send the event to all gclass's instances in the gobj's tree.
+ *  Return the last bottom gobj of gobj tree.
+ *  Useful when there is a stack of gobjs acting as a unit.
+ *  Filled by gobj_create_tree0() function.
  ***************************************************************************/
-PRIVATE int cb_send_event(hgobj child_, void *user_data, void *user_data2, void *user_data3)
+PUBLIC hgobj gobj_last_bottom_gobj(hgobj gobj_)
 {
-    GObj_t *child = child_;
-    const char *event = user_data;
-    json_t *kw = user_data2;
-    hgobj src = user_data3;
-
-    JSON_INCREF(kw);
-    gobj_send_event(child, event, kw, src);
+    GObj_t * gobj = gobj_;
 
-    return 0;
+    if(gobj->bottom_gobj) {
+        return _deep_bottom_gobj(gobj->bottom_gobj);
+    } else {
+        return 0;
+    }
 }
-PUBLIC int gobj_send_event_to_gclass_instances(
-    hgobj gobj,
-    const char *gclass_name,
-    const char *event,
-    json_t *kw,
-    hgobj src)
+
+/***************************************************************************
+ *  Return the next bottom gobj of the gobj.
+ *  See gobj_last_bottom_gobj()
+ ***************************************************************************/
+PUBLIC hgobj gobj_bottom_gobj(hgobj gobj_)
 {
+    GObj_t * gobj = gobj_;
     if(!gobj) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
-            NULL
-        );
-        return -1;
-    }
-    if(empty_string(gclass_name)) {
-        log_error(0,
-            "gobj",         "%s", gobj_full_name(gobj),
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gclass_name NULL",
-            NULL
-        );
-        return -1;
+        return 0;
     }
+    return gobj->bottom_gobj;
+}
 
-    if(gobj_typeof_gclass(gobj, gclass_name)) {
-        JSON_INCREF(kw);
-        gobj_send_event(gobj, event, kw, src);
-    }
 
-    dl_list_t dl_list;
-    json_t *jn_filter = json_pack("{s:s}",
-        "__gclass_name__", gclass_name
-    );
-    gobj_match_childs_tree(gobj, &dl_list, jn_filter);
 
-    rc_walk_by_list(
-        &dl_list,
-        WALK_LAST2FIRST,
-        (cb_walking_t)cb_send_event,
-        (void *)event,
-        kw,
-        src
-    );
-    rc_free_iter(&dl_list, 0, 0);
 
-    JSON_DECREF(kw);
+                    /*---------------------------------*
+                     *  SECTION: Attribute functions
+                     *---------------------------------*/
+
+
+
+
+/***************************************************************************
+ *  ATTR:
+ *  Contain the key my gobj-name or my gclass-name?
+ *  Return NULL if not, or the key cleaned of prefix.
+ ***************************************************************************/
+PRIVATE const char * is_for_me(
+    const char *gclass_name,
+    const char *gobj_name,
+    const char *key)
+{
+    char *p = strchr(key, '.');
+    if(p) {
+        char temp[256]; // if your names are longer than 256 bytes, you are ...
+        int ln = p - key;
+        if (ln >= sizeof(temp))
+            return 0; // ... very inteligent!
+        strncpy(temp, key, ln);
+        temp[ln]=0;
+
+        if(gobj_name && strcmp(gobj_name, temp)==0) {
+            // match the name
+            return p+1;
+        }
+        if(gclass_name && strcasecmp(gclass_name, temp)==0) {
+            // match the gclass name
+            return p+1;
+        }
+    }
     return 0;
 }
 
 /***************************************************************************
- *  Send the event to child with name ``name``
+ *  ATTR:
  ***************************************************************************/
-PUBLIC int gobj_send_event_to_named_child(
-    hgobj gobj,
-    const char *name,
-    const char *event,
-    json_t *kw,
-    hgobj src)
+PRIVATE json_t *extract_all_mine(
+    const char *gclass_name,
+    const char *gobj_name,
+    json_t *kw)     // not own
 {
-    if(!gobj) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
-            NULL
-        );
-        return -1;
-    }
-    if(empty_string(name)) {
-        log_error(0,
-            "gobj",         "%s", gobj_full_name(gobj),
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "name NULL",
-            NULL
+    json_t *kw_mine = json_object();
+    const char *key;
+    json_t *jn_value;
+
+    json_object_foreach(kw, key, jn_value) {
+        const char *pk = is_for_me(
+            gclass_name,
+            gobj_name,
+            key
         );
-        return -1;
+        if(!pk)
+            continue;
+        if(strcasecmp(pk, "kw")==0) {
+            json_object_update(kw_mine, jn_value);
+        } else {
+            json_object_set(kw_mine, pk, jn_value);
+        }
     }
 
-    dl_list_t dl_list;
-    json_t *jn_filter = json_pack("{s:s}",
-        "__gobj_name__", name
-    );
-    gobj_match_childs(gobj, &dl_list, jn_filter);
+    return kw_mine;
+}
+
+/***************************************************************************
+ *  ATTR:
+ ***************************************************************************/
+PRIVATE json_t *extract_json_config_variables_mine(
+    const char *gclass_name,
+    const char *gobj_name,
+    json_t *kw     // not own
+)
+{
+    json_t *kw_mine = json_object();
+    const char *key;
+    json_t *jn_value;
 
-    rc_walk_by_list(
-        &dl_list,
-        WALK_LAST2FIRST,
-        (cb_walking_t)cb_send_event,
-        (void *)event,
-        kw,
-        src
-    );
-    rc_free_iter(&dl_list, 0, 0);
+    json_object_foreach(kw, key, jn_value) {
+        const char *pk = is_for_me(
+            gclass_name,
+            gobj_name,
+            key
+        );
+        if(!pk)
+            continue;
+        if(strcasecmp(pk, "__json_config_variables__")==0) {
+            json_object_set(kw_mine, pk, jn_value);
+        }
+    }
 
-    JSON_DECREF(kw);
-    return 0;
+    return kw_mine;
 }
 
 /***************************************************************************
- *  Send the event to all childs
+ *  ATTR:
+ *  Get data from json kw parameter, and put the data in config sdata.
+
+    With filter_own:
+    Filter only the parameters in settings belongs to gobj.
+    The gobj is searched by his named-gobj or his gclass name.
+    The parameter name in settings, must be a dot-named,
+    with the first item being the named-gobj o gclass name.
+ *
  ***************************************************************************/
-PRIVATE int cb_send_event_if_in(rc_instance_t *i_child, hgobj child_, void *user_data, void *user_data2, void *user_data3)
+PRIVATE int gobj_write_json_parameters(
+    GObj_t * gobj,
+    json_t *kw,     // not own
+    json_t *jn_global) // not own
 {
-    GObj_t *child = child_;
-    const char *event = user_data;
-    json_t *kw = user_data2;
-    hgobj src = user_data3;
+    hsdata hs = gobj_hsdata(gobj);
+    json_t *jn_global_mine = extract_all_mine(
+        gobj->gclass->gclass_name,
+        gobj->name,
+        jn_global
+    );
 
-    if(gobj_event_in_input_event_list(child, event, 0)) {
-        JSON_INCREF(kw)
-        gobj_send_event(child, event, kw, src);
+    if(__trace_gobj_create_delete2__(gobj)) {
+        trace_machine("🔰 %s^%s => global_mine",
+            gobj->gclass->gclass_name,
+            gobj->name
+        );
+        log_debug_json(0, jn_global, "global all");
+        log_debug_json(0, jn_global_mine, "global_mine");
     }
 
-    return 0;
-}
-PUBLIC int gobj_send_event_to_childs(
-    hgobj gobj,
-    const char *event,
-    json_t *kw,
-    hgobj src)
-{
-    if(!gobj) {
-        log_error(0,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
-            NULL
+    json_t *__json_config_variables__ = kw_get_dict(
+        jn_global_mine,
+        "__json_config_variables__",
+        json_object(),
+        KW_CREATE
+    );
+
+    json_object_update_new(
+        __json_config_variables__,
+        gobj_global_variables()
+    );
+    if(gobj_yuno()) {
+        json_object_update_new(
+            __json_config_variables__,
+            json_pack("{s:s, s:b}",
+                "__bind_ip__", gobj_read_str_attr(gobj_yuno(), "bind_ip"),
+                "__multiple__", gobj_read_bool_attr(gobj_yuno(), "yuno_multiple")
+            )
+        );
+    }
+
+    if(__trace_gobj_create_delete2__(gobj)) {
+        trace_machine("🔰🔰 %s^%s => __json_config_variables__",
+            gobj->gclass->gclass_name,
+            gobj->name
         );
+        log_debug_json(0, __json_config_variables__, "__json_config_variables__");
+    }
+
+    json_t * new_kw = kw_apply_json_config_variables(kw, jn_global_mine);
+    json_decref(jn_global_mine);
+    if(!new_kw) {
         return -1;
     }
 
-    gobj_walk_gobj_childs(gobj, WALK_FIRST2LAST, cb_send_event_if_in, (void *)event, kw, src);
+    if(__trace_gobj_create_delete2__(gobj)) {
+        trace_machine("🔰🔰🔰 %s^%s => final kw",
+            gobj->gclass->gclass_name,
+            gobj->name
+        );
+        log_debug_json(0, new_kw, "final kw");
+    }
 
-    JSON_DECREF(kw)
-    return 0;
+    json_t *__user_data__ = kw_get_dict(new_kw, "__user_data__", 0, KW_EXTRACT);
+
+    int ret = json2sdata(
+        hs,
+        new_kw,
+        -1,
+        (gobj->gclass->gcflag & gcflag_ignore_unknown_attrs)?0:print_attr_not_found,
+        gobj
+    );
+
+    if(__user_data__) {
+        json_object_update(((GObj_t *)gobj)->jn_user_data, __user_data__);
+        json_decref(__user_data__);
+    }
+    json_decref(new_kw);
+    return ret;
 }
 
 /***************************************************************************
- *  Send the event to all childs tree
- *  same as gobj_send_event_to_childs but recursive
+ *  load or re-load persistent and writable attrs
  ***************************************************************************/
-PUBLIC int gobj_send_event_to_childs_tree(
-    hgobj gobj,
-    const char *event,
-    json_t *kw,
-    hgobj src)
+PUBLIC int gobj_load_persistent_attrs(hgobj gobj_, json_t *jn_attrs) // str, list or dict
 {
-    if(!gobj) {
+    GObj_t *gobj = gobj_;
+
+    if(!(gobj->obflag & (obflag_unique_name))) {
         log_error(0,
-            "gobj",         "%s", __FILE__,
+            "gobj",         "%s", gobj_full_name(gobj),
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
+            "msg",          "%s", "Cannot load writable-persistent attrs in no named-gobjs",
             NULL
         );
+        JSON_DECREF(jn_attrs);
         return -1;
     }
-
-    gobj_walk_gobj_childs_tree(gobj, WALK_FIRST2LAST, cb_send_event_if_in, (void *)event, kw, src);
-
-    JSON_DECREF(kw)
-    return 0;
+    if(__global_load_persistent_attrs_fn__) {
+        return __global_load_persistent_attrs_fn__(gobj, jn_attrs);
+    }
+    JSON_DECREF(jn_attrs);
+    return -1;
 }
 
 /***************************************************************************
- *  Same as gobj_send_event_to_childs
- *  but recursive by levels instead of traverse the tree.
- *  - by levels: first all childs, next all childs of the childs, etc
+ *  save now persistent and writable attrs
+    attrs can be a string, a list of keys, or a dict with the keys to save/delete
  ***************************************************************************/
-PUBLIC int gobj_send_event_to_childs_tree_by_level(
-    hgobj gobj,
-    const char *event,
-    json_t *kw,
-    hgobj src)
+PUBLIC int gobj_save_persistent_attrs(hgobj gobj_, json_t *jn_attrs)
 {
-    if(!gobj) {
+    GObj_t *gobj = gobj_;
+
+    if(!(gobj->obflag & (obflag_unique_name))) {
         log_error(0,
-            "gobj",         "%s", __FILE__,
+            "gobj",         "%s", gobj_full_name(gobj),
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
+            "msg",          "%s", "Cannot save writable-persistent attrs in no named-gobjs",
             NULL
         );
+        JSON_DECREF(jn_attrs);
         return -1;
     }
-
-    gobj_walk_gobj_childs_tree(
-        gobj,
-        WALK_BYLEVEL|WALK_FIRST2LAST,
-        cb_send_event_if_in,
-        (void *)event,
-        kw,
-        src
-    );
-
-    JSON_DECREF(kw)
-    return 0;
-}
-
-
-
-
-                    /*------------------------------------*
-                     *  SECTION: Organization functions
-                     *-----------------------------------*/
-
-
-
-
-/***************************************************************************
- *
- ***************************************************************************/
-PRIVATE GObj_t * _deep_bottom_gobj(GObj_t *gobj)
-{
-    if(gobj->bottom_gobj) {
-        return _deep_bottom_gobj(gobj->bottom_gobj);
-    } else {
-        return gobj;
+    if(__global_save_persistent_attrs_fn__) {
+        return __global_save_persistent_attrs_fn__(gobj, jn_attrs);
     }
+    JSON_DECREF(jn_attrs);
+    return -1;
 }
 
 /***************************************************************************
- *  Set manually the bottom gobj
+ *  remove file of persistent and writable attrs
+ *  attrs can be a string, a list of keys, or a dict with the keys to save/delete
+ *  if attrs is empty save/remove all attrs
  ***************************************************************************/
-PUBLIC hgobj gobj_set_bottom_gobj(hgobj gobj_, hgobj bottom_gobj)
+PUBLIC int gobj_remove_persistent_attrs(hgobj gobj_, json_t *jn_attrs)
 {
-    GObj_t * gobj = gobj_;
+    GObj_t *gobj = gobj_;
 
-    if(is_machine_tracing(gobj)) {
-        trace_machine("🔽 set_bottom_gobj('%s') = '%s'",
-            gobj_short_name(gobj),
-            bottom_gobj?gobj_short_name(bottom_gobj):""
-        );
-    }
-    if(gobj->bottom_gobj) {
-        /*
-         *  En los gobj con manual start ellos suelen poner su bottom gobj.
-         *  No lo consideramos un error.
-         *  Ej: emailsender -> curl
-         *      y luego va e intenta poner emailsender -> IOGate
-         *      porque está definido con tree, y no tiene en cuenta la creación de un bottom interno.
-         *
-         */
-        if(bottom_gobj) {
-            log_warning(LOG_OPT_TRACE_STACK,
-                "gobj",         "%s", gobj_full_name(gobj),
-                "function",     "%s", __FUNCTION__,
-                "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-                "msg",          "%s", "bottom_gobj already set",
-                "prev_gobj",    "%s", gobj_full_name(gobj->bottom_gobj),
-                "new_gobj",     "%s", gobj_full_name(bottom_gobj),
-                NULL
-            );
-        }
-        // anyway set -> NO! -> the already set has preference. New 8-10-2016
-        // anyway set -> YES! -> the new set has preference. New 27-Jan-2017
-        //return 0;
+    if(!__global_remove_persistent_attrs_fn__) {
+        JSON_DECREF(jn_attrs);
+        return -1;
     }
-    gobj->bottom_gobj = bottom_gobj;
-    return 0;
+    return __global_remove_persistent_attrs_fn__(gobj, jn_attrs);
 }
 
 /***************************************************************************
- *  Return the last bottom gobj of gobj tree.
- *  Useful when there is a stack of gobjs acting as a unit.
- *  Filled by gobj_create_tree0() function.
+ *  List persistent attributes
  ***************************************************************************/
-PUBLIC hgobj gobj_last_bottom_gobj(hgobj gobj_)
+PUBLIC json_t * gobj_list_persistent_attrs(hgobj gobj, json_t *jn_attrs)
 {
-    GObj_t * gobj = gobj_;
-
-    if(gobj->bottom_gobj) {
-        return _deep_bottom_gobj(gobj->bottom_gobj);
-    } else {
+    if(!__global_list_persistent_attrs_fn__) {
+        JSON_DECREF(jn_attrs);
         return 0;
     }
+    return __global_list_persistent_attrs_fn__(gobj, jn_attrs);
 }
 
 /***************************************************************************
- *  Return the next bottom gobj of the gobj.
- *  See gobj_last_bottom_gobj()
+ *
  ***************************************************************************/
-PUBLIC hgobj gobj_bottom_gobj(hgobj gobj_)
+PUBLIC hsdata gobj_hsdata(hgobj gobj_)
 {
-    GObj_t * gobj = gobj_;
+    GObj_t *gobj = gobj_;
     if(!gobj) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
         return 0;
     }
-    return gobj->bottom_gobj;
+    return ((GObj_t *)gobj)->hsdata_attr;
 }
 
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC const sdata_desc_t * gobj_tattr_desc(hgobj gobj_)
+{
+    GObj_t *gobj = gobj_;
 
+    if(!gobj) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        return 0;
+    }
 
+    return gobj->gclass->tattr_desc;
+}
 
-                    /*---------------------------------*
-                     *  SECTION: Attribute functions
-                     *---------------------------------*/
-
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC const sdata_desc_t * gobj_attr_desc(hgobj gobj_, const char *name)
+{
+    GObj_t *gobj = gobj_;
 
+    if(!gobj) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            NULL
+        );
+        return 0;
+    }
 
+    return sdata_it_desc(gobj->gclass->tattr_desc, name);
+}
 
 /***************************************************************************
- *  ATTR:
- *  Contain the key my gobj-name or my gclass-name?
- *  Return NULL if not, or the key cleaned of prefix.
+ *
  ***************************************************************************/
-PRIVATE const char * is_for_me(
-    const char *gclass_name,
-    const char *gobj_name,
-    const char *key)
+PUBLIC const sdata_desc_t * gobj_bottom_attr_desc(hgobj gobj_, const char *name)
 {
-    char *p = strchr(key, '.');
-    if(p) {
-        char temp[256]; // if your names are longer than 256 bytes, you are ...
-        int ln = p - key;
-        if (ln >= sizeof(temp))
-            return 0; // ... very inteligent!
-        strncpy(temp, key, ln);
-        temp[ln]=0;
+    GObj_t *gobj = gobj_;
 
-        if(gobj_name && strcmp(gobj_name, temp)==0) {
-            // match the name
-            return p+1;
-        }
-        if(gclass_name && strcasecmp(gclass_name, temp)==0) {
-            // match the gclass name
-            return p+1;
-        }
+    if(gobj_has_attr(gobj, name)) {
+        return sdata_it_desc(gobj->gclass->tattr_desc, name);
+    } else if(gobj && gobj->bottom_gobj) {
+        return gobj_bottom_attr_desc(gobj->bottom_gobj, name);
     }
     return 0;
 }
 
 /***************************************************************************
- *  ATTR:
+ *
  ***************************************************************************/
-PRIVATE json_t *extract_all_mine(
-    const char *gclass_name,
-    const char *gobj_name,
-    json_t *kw)     // not own
+BOOL gclass_has_attr(GCLASS *gclass, const char* name)
 {
-    json_t *kw_mine = json_object();
-    const char *key;
-    json_t *jn_value;
+    const sdata_desc_t *it = sdata_it_desc(gclass->tattr_desc, name);
+    if(!it) {
+        return FALSE;
+    } else {
+        return TRUE;
+    }
+}
 
-    json_object_foreach(kw, key, jn_value) {
-        const char *pk = is_for_me(
-            gclass_name,
-            gobj_name,
-            key
+/***************************************************************************
+ *
+ ***************************************************************************/
+PUBLIC BOOL gobj_has_attr(hgobj gobj, const char *name)
+{
+    if(!gobj) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            "attr",         "%s", name?name:"",
+            NULL
         );
-        if(!pk)
-            continue;
-        if(strcasecmp(pk, "kw")==0) {
-            json_object_update(kw_mine, jn_value);
-        } else {
-            json_object_set(kw_mine, pk, jn_value);
-        }
+        return FALSE;
     }
-
-    return kw_mine;
+    return gclass_has_attr(((GObj_t *)gobj)->gclass, name);
 }
 
 /***************************************************************************
- *  ATTR:
+ *
  ***************************************************************************/
-PRIVATE json_t *extract_json_config_variables_mine(
-    const char *gclass_name,
-    const char *gobj_name,
-    json_t *kw     // not own
-)
+PUBLIC BOOL gobj_has_bottom_attr(hgobj gobj_, const char *name)
 {
-    json_t *kw_mine = json_object();
-    const char *key;
-    json_t *jn_value;
+    GObj_t *gobj = gobj_;
 
-    json_object_foreach(kw, key, jn_value) {
-        const char *pk = is_for_me(
-            gclass_name,
-            gobj_name,
-            key
-        );
-        if(!pk)
-            continue;
-        if(strcasecmp(pk, "__json_config_variables__")==0) {
-            json_object_set(kw_mine, pk, jn_value);
-        }
+    if(gobj_has_attr(gobj, name)) {
+        return TRUE;
+    } else if(gobj && gobj->bottom_gobj) {
+        return gobj_has_bottom_attr(gobj->bottom_gobj, name);
     }
 
-    return kw_mine;
+    return FALSE;
 }
 
 /***************************************************************************
- *  ATTR:
- *  Get data from json kw parameter, and put the data in config sdata.
-
-    With filter_own:
-    Filter only the parameters in settings belongs to gobj.
-    The gobj is searched by his named-gobj or his gclass name.
-    The parameter name in settings, must be a dot-named,
-    with the first item being the named-gobj o gclass name.
  *
  ***************************************************************************/
-PRIVATE int gobj_write_json_parameters(
-    GObj_t * gobj,
-    json_t *kw,     // not own
-    json_t *jn_global) // not own
+PUBLIC int gobj_attr_type(hgobj gobj, const char *name)
 {
-    hsdata hs = gobj_hsdata(gobj);
-    json_t *jn_global_mine = extract_all_mine(
-        gobj->gclass->gclass_name,
-        gobj->name,
-        jn_global
-    );
-
-    if(__trace_gobj_create_delete2__(gobj)) {
-        trace_machine("🔰 %s^%s => global_mine",
-            gobj->gclass->gclass_name,
-            gobj->name
-        );
-        log_debug_json(0, jn_global, "global all");
-        log_debug_json(0, jn_global_mine, "global_mine");
+    const sdata_desc_t *it = gobj_attr_desc(gobj, name);
+    if(it) {
+        return it->type;
+    } else {
+        return 0;
     }
+}
 
-    json_t *__json_config_variables__ = kw_get_dict(
-        jn_global_mine,
-        "__json_config_variables__",
-        json_object(),
-        KW_CREATE
-    );
+/***************************************************************************
+ *  ATTR: callback for sdata
+ ***************************************************************************/
+PRIVATE int on_post_write_it_cb(void *user_data, const char *name)
+{
+    GObj_t *gobj = user_data;
 
-    json_object_update_new(
-        __json_config_variables__,
-        gobj_global_variables()
-    );
-    if(gobj_yuno()) {
-        json_object_update_new(
-            __json_config_variables__,
-            json_pack("{s:s, s:b}",
-                "__bind_ip__", gobj_read_str_attr(gobj_yuno(), "bind_ip"),
-                "__multiple__", gobj_read_bool_attr(gobj_yuno(), "yuno_multiple")
-            )
-        );
+    json_t *jn_filtering = __jn_trace_filtered_attrs__?
+        json_object_get(__jn_trace_filtered_attrs__, name) : 0;
+    if(jn_filtering) {
+        /*
+         *  Filtered attr changed, recompute the trace masks.
+         *  The filter of other gclasses can read it through their bottom gobjs
+         *  (gobj_read_str_attr()), then all the masks are invalidated.
+         */
+        json_int_t filtering = json_integer_value(jn_filtering);
+        if(gobj->gclass->__jn_trace_filter__ &&
+                json_object_get(gobj->gclass->__jn_trace_filter__, name)) {
+            gobj->__trace_generation__ = 0;
+            filtering--;
+        }
+        if(filtering > 0) {
+            INVALIDATE_TRACE_MASKS()
+        }
     }
 
-    if(__trace_gobj_create_delete2__(gobj)) {
-        trace_machine("🔰🔰 %s^%s => __json_config_variables__",
-            gobj->gclass->gclass_name,
-            gobj->name
-        );
-        log_debug_json(0, __json_config_variables__, "__json_config_variables__");
+    if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
+        // Avoid call to mt_writing before mt_create!
+        if(gobj->gclass->gmt.mt_writing) {
+            gobj->gclass->gmt.mt_writing(gobj, name);
+        }
     }
+    return 0;
+}
+
+/***************************************************************************
+ *  ATTR: callback for sdata
+ ***************************************************************************/
+PRIVATE int on_post_write_stats_it_cb(
+    void* user_data,
+    const char* name,
+    int type,
+    SData_Value_t old_v,
+    SData_Value_t new_v)
+{
+    GObj_t *obj_stats = user_data;
 
-    json_t * new_kw = kw_apply_json_config_variables(kw, jn_global_mine);
-    json_decref(jn_global_mine);
-    if(!new_kw) {
-        return -1;
+    if(!(obj_stats->obflag & obflag_created) || (obj_stats->obflag & (obflag_destroyed|obflag_destroying))) {
+        return 0;
     }
-
-    if(__trace_gobj_create_delete2__(gobj)) {
-        trace_machine("🔰🔰🔰 %s^%s => final kw",
-            gobj->gclass->gclass_name,
-            gobj->name
-        );
-        log_debug_json(0, new_kw, "final kw");
+    // al servicio mas cernano o al yuno
+    GObj_t *gobj_s = gobj_nearest_top_service(obj_stats);
+    while(gobj_s) {
+        if(gobj_s && gobj_s->gclass->gmt.mt_stats_updated) {
+            if(gobj_s->gclass->gmt.mt_stats_updated(gobj_s, obj_stats, name, type, old_v, new_v)==0) {
+                break;
+            }
+        }
+        gobj_s = gobj_nearest_top_service(gobj_s);
     }
+    return 0;
+}
 
-    json_t *__user_data__ = kw_get_dict(new_kw, "__user_data__", 0, KW_EXTRACT);
-
-    int ret = json2sdata(
-        hs,
-        new_kw,
-        -1,
-        (gobj->gclass->gcflag & gcflag_ignore_unknown_attrs)?0:print_attr_not_found,
-        gobj
-    );
+/***************************************************************************
+ *  ATTR: callback for sdata
+ ***************************************************************************/
+PRIVATE SData_Value_t on_post_read_it_cb(void *user_data, const char *name, int type, SData_Value_t data)
+{
+    GObj_t *gobj = user_data;
 
-    if(__user_data__) {
-        json_object_update(((GObj_t *)gobj)->jn_user_data, __user_data__);
-        json_decref(__user_data__);
+    if(!(gobj->obflag & obflag_destroyed)) {
+        if(gobj->gclass->gmt.mt_reading) {
+            return gobj->gclass->gmt.mt_reading(gobj, name, type, data);
+        }
     }
-    json_decref(new_kw);
-    return ret;
+    return data;
 }
 
 /***************************************************************************
- *  load or re-load persistent and writable attrs
+ *  ATTR: Get hsdata of inherited attribute.
  ***************************************************************************/
-PUBLIC int gobj_load_persistent_attrs(hgobj gobj_, json_t *jn_attrs) // str, list or dict
+PUBLIC hsdata gobj_hsdata2(hgobj gobj_, const char *name, BOOL verbose)
 {
     GObj_t *gobj = gobj_;
 
-    if(!(gobj->obflag & (obflag_unique_name))) {
-        log_error(0,
-            "gobj",         "%s", gobj_full_name(gobj),
+    if(!gobj) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "Cannot load writable-persistent attrs in no named-gobjs",
+            "msg",          "%s", "gobj NULL",
             NULL
         );
-        JSON_DECREF(jn_attrs);
-        return -1;
-    }
-    if(__global_load_persistent_attrs_fn__) {
-        return __global_load_persistent_attrs_fn__(gobj, jn_attrs);
+        return 0;
     }
-    JSON_DECREF(jn_attrs);
-    return -1;
-}
-
-/***************************************************************************
- *  save now persistent and writable attrs
-    attrs can be a string, a list of keys, or a dict with the keys to save/delete
- ***************************************************************************/
-PUBLIC int gobj_save_persistent_attrs(hgobj gobj_, json_t *jn_attrs)
-{
-    GObj_t *gobj = gobj_;
 
-    if(!(gobj->obflag & (obflag_unique_name))) {
-        log_error(0,
+    if(gobj_has_attr(gobj, name)) {
+        return gobj_hsdata(gobj);
+    } else if(gobj && gobj->bottom_gobj) {
+        return gobj_hsdata2(gobj->bottom_gobj, name, verbose);
+    }
+    if(verbose) {
+        log_warning(LOG_OPT_TRACE_STACK,
             "gobj",         "%s", gobj_full_name(gobj),
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "Cannot save writable-persistent attrs in no named-gobjs",
+            "msg",          "%s", "GClass Attribute NOT FOUND",
+            "gclass",       "%s", gobj_gclass_name(gobj),
+            "attr",         "%s", name?name:"",
             NULL
         );
-        JSON_DECREF(jn_attrs);
-        return -1;
-    }
-    if(__global_save_persistent_attrs_fn__) {
-        return __global_save_persistent_attrs_fn__(gobj, jn_attrs);
     }
-    JSON_DECREF(jn_attrs);
-    return -1;
+    return 0;
 }
 
 /***************************************************************************
- *  remove file of persistent and writable attrs
- *  attrs can be a string, a list of keys, or a dict with the keys to save/delete
- *  if attrs is empty save/remove all attrs
+ *  ATTR: read the attr pointer, traversing inherited gobjs if need it.
+ *  DANGER if you don't cast well: OVERFLOW variables!
  ***************************************************************************/
-PUBLIC int gobj_remove_persistent_attrs(hgobj gobj_, json_t *jn_attrs)
+PUBLIC void *gobj_danger_attr_ptr(hgobj gobj, const char *name)
 {
-    GObj_t *gobj = gobj_;
-
-    if(!__global_remove_persistent_attrs_fn__) {
-        JSON_DECREF(jn_attrs);
-        return -1;
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_it_pointer(hs, name, 0);
     }
-    return __global_remove_persistent_attrs_fn__(gobj, jn_attrs);
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
 }
 
 /***************************************************************************
- *  List persistent attributes
+ *  ATTR: read the attr pointer, traversing inherited gobjs if need it.
+ *  DANGER if you don't cast well: OVERFLOW variables!
  ***************************************************************************/
-PUBLIC json_t * gobj_list_persistent_attrs(hgobj gobj, json_t *jn_attrs)
+PUBLIC void *gobj_danger_attr_ptr2(hgobj gobj, const char *name, const sdata_desc_t **pit)
 {
-    if(!__global_list_persistent_attrs_fn__) {
-        JSON_DECREF(jn_attrs);
-        return 0;
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_it_pointer(hs, name, pit);
     }
-    return __global_list_persistent_attrs_fn__(gobj, jn_attrs);
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
 }
 
 /***************************************************************************
  *
  ***************************************************************************/
-PUBLIC hsdata gobj_hsdata(hgobj gobj_)
+PRIVATE json_t *_gobj_read_attr(
+    hgobj gobj,
+    const char *name,
+    hgobj src
+)
 {
-    GObj_t *gobj = gobj_;
-    if(!gobj) {
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(!hs) {
+        log_warning(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", gobj_full_name(gobj),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "GClass Attribute NOT FOUND",
+            "gclass",       "%s", gobj_gclass_name(gobj),
+            "attr",         "%s", name?name:"",
+            NULL
+        );
+        return 0;
+    }
+
+    const sdata_desc_t *it = sdata_it_desc(sdata_schema(hs), name);
+
+//     if(it->flag & SDF_AUTHZ_R) {
+//         /*
+//          *  AUTHZ Required
+//          */
+//         if(!gobj_user_has_authz(
+//                 gobj, "__read_attribute__", json_pack("{s:s}", "path", name), src)
+//           ) {
+//             log_error(0,
+//                 "gobj",         "%s", gobj_full_name(gobj),
+//                 "function",     "%s", __FUNCTION__,
+//                 "msgset",       "%s", MSGSET_OAUTH_ERROR,
+//                 "msg",          "%s", "No permission to read attribute",
+//                 //"user",         "%s", gobj_get_user(src),
+//                 "gclass",       "%s", gobj_gclass_name(gobj),
+//                 "attr",         "%s", name?name:"",
+//                 NULL
+//             );
+//             return 0;
+//         }
+//     }
+
+    json_t *jn_value = 0;
+
+    if(ASN_IS_STRING(it->type)) {
+        jn_value = json_string(sdata_read_str(hs, name));
+    } else if(ASN_IS_BOOLEAN(it->type)) {
+        jn_value = sdata_read_bool(hs, name)?json_true():json_false();
+    } else if(ASN_IS_UNSIGNED32(it->type)) {
+        jn_value = json_integer(sdata_read_uint32(hs, name));
+    } else if(ASN_IS_SIGNED32(it->type)) {
+        jn_value = json_integer(sdata_read_int32(hs, name));
+    } else if(ASN_IS_UNSIGNED64(it->type)) {
+        jn_value = json_integer(sdata_read_uint64(hs, name));
+    } else if(ASN_IS_SIGNED64(it->type)) {
+        jn_value = json_integer(sdata_read_int64(hs, name));
+    } else if(ASN_IS_DOUBLE(it->type)) {
+        jn_value = json_real(sdata_read_real(hs, name));
+    } else if(ASN_IS_JSON(it->type)) {
+        jn_value = sdata_read_json(hs, name);
+        JSON_INCREF(jn_value);
+    } else if(ASN_IS_POINTER(it->type)) {
+        jn_value = json_integer((json_int_t)(size_t)sdata_read_pointer(hs, name));
+    } else {
         log_error(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", __FILE__,
+            "gobj",         "%s", gobj_full_name(gobj),
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
+            "msg",          "%s", "GClass Attribute Type NOT VALID",
+            "gclass",       "%s", gobj_gclass_name(gobj),
+            "attr",         "%s", name?name:"",
             NULL
         );
+    }
+
+    return jn_value;
+}
+
+/***************************************************************************
+ *  ATTR: read str
+ *  Return is yours! Must be decref. New api (May/2019), js style
+ *  With AUTHZ
+ *  Inherit from js-core
+ ***************************************************************************/
+PUBLIC json_t *gobj_read_attr(
+    hgobj gobj,
+    const char *path, // If it has ` then segments are gobj and leaf is the attribute (+bottom)
+    hgobj src
+)
+{
+    // TODO use segments of ` to search in childs
+
+    json_t *jn_attr = _gobj_read_attr(gobj, path, src);
+
+    return jn_attr;
+}
+
+/***************************************************************************
+ *  ATTR: read
+ ***************************************************************************/
+PUBLIC json_t *gobj_read_user_data(
+    hgobj gobj,
+    const char *name
+)
+{
+    if(gobj) {
+        if(empty_string(name)) {
+            return ((GObj_t *)gobj)->jn_user_data;
+        } else {
+            return json_object_get(((GObj_t *)gobj)->jn_user_data, name);
+        }
+    } else {
         return 0;
     }
-    return ((GObj_t *)gobj)->hsdata_attr;
 }
 
 /***************************************************************************
- *
+ *  ATTR: read
  ***************************************************************************/
-PUBLIC const sdata_desc_t * gobj_tattr_desc(hgobj gobj_)
+PUBLIC json_t *gobj_kw_get_user_data(
+    hgobj gobj,
+    const char *path,
+    json_t *default_value,
+    kw_flag_t flag
+)
 {
-    GObj_t *gobj = gobj_;
-
-    if(!gobj) {
-        log_error(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
-            NULL
-        );
+    if(gobj) {
+        return kw_get_dict_value(((GObj_t *)gobj)->jn_user_data, path, default_value, flag);
+    } else {
         return 0;
     }
-
-    return gobj->gclass->tattr_desc;
 }
 
 /***************************************************************************
- *
+ *  ATTR: read str
  ***************************************************************************/
-PUBLIC const sdata_desc_t * gobj_attr_desc(hgobj gobj_, const char *name)
+PUBLIC const char *gobj_read_str_attr(hgobj gobj, const char *name)
 {
-    GObj_t *gobj = gobj_;
-
-    if(!gobj) {
-        log_error(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
-            NULL
-        );
-        return 0;
+    if(name && strcasecmp(name, "__state__")==0) {
+        return gobj_current_state(gobj);
     }
-
-    return sdata_it_desc(gobj->gclass->tattr_desc, name);
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_str(hs, name);
+    }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "short_name",   "%s", gobj_short_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
 }
 
 /***************************************************************************
- *
+ *  ATTR: read bool
  ***************************************************************************/
-PUBLIC const sdata_desc_t * gobj_bottom_attr_desc(hgobj gobj_, const char *name)
+PUBLIC BOOL gobj_read_bool_attr(hgobj gobj, const char *name)
 {
-    GObj_t *gobj = gobj_;
-
-    if(gobj_has_attr(gobj, name)) {
-        return sdata_it_desc(gobj->gclass->tattr_desc, name);
-    } else if(gobj && gobj->bottom_gobj) {
-        return gobj_bottom_attr_desc(gobj->bottom_gobj, name);
+    if(name) {
+        if(strcasecmp(name, "__disabled__")==0) {
+            return gobj_is_disabled(gobj);
+        } else if(strcasecmp(name, "__running__")==0) {
+            return gobj_is_running(gobj);
+        } else if(strcasecmp(name, "__playing__")==0) {
+            return gobj_is_playing(gobj);
+        } else if(strcasecmp(name, "__service__")==0) {
+            return gobj_is_service(gobj);
+        }
+    }
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_bool(hs, name);
     }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
     return 0;
 }
 
 /***************************************************************************
- *
+ *  ATTR: read
  ***************************************************************************/
-BOOL gclass_has_attr(GCLASS *gclass, const char* name)
+PUBLIC int32_t gobj_read_int32_attr(hgobj gobj, const char *name)
 {
-    const sdata_desc_t *it = sdata_it_desc(gclass->tattr_desc, name);
-    if(!it) {
-        return FALSE;
-    } else {
-        return TRUE;
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_int32(hs, name);
     }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
 }
 
 /***************************************************************************
- *
+ *  ATTR: read
  ***************************************************************************/
-PUBLIC BOOL gobj_has_attr(hgobj gobj, const char *name)
+PUBLIC uint32_t gobj_read_uint32_attr(hgobj gobj, const char *name)
 {
-    if(!gobj) {
-        log_error(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
-            "attr",         "%s", name?name:"",
-            NULL
-        );
-        return FALSE;
+    if(name && strcasecmp(name, "__trace_level__")==0) {
+        return gobj_trace_level(gobj);
     }
-    return gclass_has_attr(((GObj_t *)gobj)->gclass, name);
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_uint32(hs, name);
+    }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
 }
 
 /***************************************************************************
- *
+ *  ATTR: read
  ***************************************************************************/
-PUBLIC BOOL gobj_has_bottom_attr(hgobj gobj_, const char *name)
+PUBLIC int64_t gobj_read_int64_attr(hgobj gobj, const char *name)
 {
-    GObj_t *gobj = gobj_;
-
-    if(gobj_has_attr(gobj, name)) {
-        return TRUE;
-    } else if(gobj && gobj->bottom_gobj) {
-        return gobj_has_bottom_attr(gobj->bottom_gobj, name);
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_int64(hs, name);
     }
-
-    return FALSE;
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
 }
 
 /***************************************************************************
- *
+ *  ATTR: read
  ***************************************************************************/
-PUBLIC int gobj_attr_type(hgobj gobj, const char *name)
+PUBLIC uint64_t gobj_read_uint64_attr(hgobj gobj, const char *name)
 {
-    const sdata_desc_t *it = gobj_attr_desc(gobj, name);
-    if(it) {
-        return it->type;
-    } else {
-        return 0;
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_uint64(hs, name);
     }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
 }
 
 /***************************************************************************
- *  ATTR: callback for sdata
+ *  ATTR: read
  ***************************************************************************/
-PRIVATE int on_post_write_it_cb(void *user_data, const char *name)
+PUBLIC uint64_t gobj_read_integer_attr(hgobj gobj, const char *name)
 {
-    GObj_t *gobj = user_data;
-
-    if((gobj->obflag & obflag_created) && !(gobj->obflag & obflag_destroyed)) {
-        // Avoid call to mt_writing before mt_create!
-        if(gobj->gclass->gmt.mt_writing) {
-            gobj->gclass->gmt.mt_writing(gobj, name);
-        }
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_integer(hs, name);
     }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
     return 0;
 }
 
 /***************************************************************************
- *  ATTR: callback for sdata
+ *  ATTR: read
  ***************************************************************************/
-PRIVATE int on_post_write_stats_it_cb(
-    void* user_data,
-    const char* name,
-    int type,
-    SData_Value_t old_v,
-    SData_Value_t new_v)
+PUBLIC double gobj_read_real_attr(hgobj gobj, const char *name)
 {
-    GObj_t *obj_stats = user_data;
-
-    if(!(obj_stats->obflag & obflag_created) || (obj_stats->obflag & (obflag_destroyed|obflag_destroying))) {
-        return 0;
-    }
-    // al servicio mas cernano o al yuno
-    GObj_t *gobj_s = gobj_nearest_top_service(obj_stats);
-    while(gobj_s) {
-        if(gobj_s && gobj_s->gclass->gmt.mt_stats_updated) {
-            if(gobj_s->gclass->gmt.mt_stats_updated(gobj_s, obj_stats, name, type, old_v, new_v)==0) {
-                break;
-            }
-        }
-        gobj_s = gobj_nearest_top_service(gobj_s);
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_real(hs, name);
     }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
     return 0;
 }
 
 /***************************************************************************
- *  ATTR: callback for sdata
+ *  ATTR: read
  ***************************************************************************/
-PRIVATE SData_Value_t on_post_read_it_cb(void *user_data, const char *name, int type, SData_Value_t data)
+PUBLIC json_t *gobj_read_json_attr(hgobj gobj, const char *name)
 {
-    GObj_t *gobj = user_data;
-
-    if(!(gobj->obflag & obflag_destroyed)) {
-        if(gobj->gclass->gmt.mt_reading) {
-            return gobj->gclass->gmt.mt_reading(gobj, name, type, data);
-        }
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_json(hs, name);
     }
-    return data;
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
 }
 
 /***************************************************************************
- *  ATTR: Get hsdata of inherited attribute.
+ *  ATTR: read
  ***************************************************************************/
-PUBLIC hsdata gobj_hsdata2(hgobj gobj_, const char *name, BOOL verbose)
+PUBLIC void *gobj_read_pointer_attr(hgobj gobj, const char *name)
 {
-    GObj_t *gobj = gobj_;
-
-    if(!gobj) {
-        log_error(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", __FILE__,
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "gobj NULL",
-            NULL
-        );
-        return 0;
-    }
-
-    if(gobj_has_attr(gobj, name)) {
-        return gobj_hsdata(gobj);
-    } else if(gobj && gobj->bottom_gobj) {
-        return gobj_hsdata2(gobj->bottom_gobj, name, verbose);
-    }
-    if(verbose) {
-        log_warning(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", gobj_full_name(gobj),
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "GClass Attribute NOT FOUND",
-            "gclass",       "%s", gobj_gclass_name(gobj),
-            "attr",         "%s", name?name:"",
-            NULL
-        );
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_read_pointer(hs, name);
     }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
     return 0;
 }
 
 /***************************************************************************
- *  ATTR: read the attr pointer, traversing inherited gobjs if need it.
- *  DANGER if you don't cast well: OVERFLOW variables!
+ *  ATTR: read
  ***************************************************************************/
-PUBLIC void *gobj_danger_attr_ptr(hgobj gobj, const char *name)
+PUBLIC dl_list_t *gobj_read_dl_list_attr(hgobj gobj, const char *name)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_it_pointer(hs, name, 0);
+        return sdata_read_dl_list(hs, name);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8045,14 +11586,38 @@ PUBLIC void *gobj_danger_attr_ptr(hgobj gobj, const char *name)
 }
 
 /***************************************************************************
- *  ATTR: read the attr pointer, traversing inherited gobjs if need it.
- *  DANGER if you don't cast well: OVERFLOW variables!
+ *  ATTR: read
  ***************************************************************************/
-PUBLIC void *gobj_danger_attr_ptr2(hgobj gobj, const char *name, const sdata_desc_t **pit)
+PUBLIC dl_list_t *gobj_read_iter_attr(hgobj gobj, const char *name)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_it_pointer(hs, name, pit);
+        return sdata_read_iter(hs, name);
+    }
+    log_warning(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(gobj),
+        "function",     "%s", __FUNCTION__,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", "GClass Attribute NOT FOUND",
+        "gclass",       "%s", gobj_gclass_name(gobj),
+        "attr",         "%s", name?name:"",
+        NULL
+    );
+    return 0;
+}
+
+/***************************************************************************
+ *  ATTR: read
+ ***************************************************************************/
+PUBLIC const sdata_desc_t * gobj_read_iter_schema(hgobj gobj_, const char *name)
+{
+    GObj_t *gobj = gobj_;
+
+    if(gobj_has_attr(gobj, name)) {
+        const sdata_desc_t * desc = gobj_attr_desc(gobj, name);
+        return desc->schema;
+    } else if(gobj && gobj->bottom_gobj) {
+        return gobj_read_iter_schema(gobj->bottom_gobj, name);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8066,16 +11631,37 @@ PUBLIC void *gobj_danger_attr_ptr2(hgobj gobj, const char *name, const sdata_des
     return 0;
 }
 
+/***************************************************************************
+ *  ATTR: read
+ ***************************************************************************/
+PUBLIC BOOL gobj_is_readable_attr(hgobj gobj, const char *name)
+{
+    const sdata_desc_t *it = gobj_attr_desc(gobj, name);
+    if(it && it->flag & (ATTR_READABLE)) {
+        return TRUE;
+    } else {
+        return FALSE;
+    }
+}
+/***************************************************************************
+ *  ATTR: read
+ ***************************************************************************/
+PUBLIC SData_Value_t gobj_read_default_attr_value(hgobj gobj, const char* name)  // Only for basic types
+{
+    return sdata_get_default_value(gobj_hsdata(gobj), name);
+}
+
 /***************************************************************************
  *
  ***************************************************************************/
-PRIVATE json_t *_gobj_read_attr(
+PRIVATE int _gobj_write_attr(
     hgobj gobj,
     const char *name,
+    json_t *value,  // owned
     hgobj src
 )
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE); // This search in bottom's
     if(!hs) {
         log_warning(LOG_OPT_TRACE_STACK,
             "gobj",         "%s", gobj_full_name(gobj),
@@ -8086,53 +11672,55 @@ PRIVATE json_t *_gobj_read_attr(
             "attr",         "%s", name?name:"",
             NULL
         );
-        return 0;
+        JSON_DECREF(value);
+        return -1;
     }
 
     const sdata_desc_t *it = sdata_it_desc(sdata_schema(hs), name);
 
-//     if(it->flag & SDF_AUTHZ_R) {
+//     if(it->flag & SDF_AUTHZ_W) {
 //         /*
 //          *  AUTHZ Required
 //          */
 //         if(!gobj_user_has_authz(
-//                 gobj, "__read_attribute__", json_pack("{s:s}", "path", name), src)
+//                 gobj, "__write_attribute__", json_pack("{s:s}", "path", path), src)
 //           ) {
 //             log_error(0,
 //                 "gobj",         "%s", gobj_full_name(gobj),
 //                 "function",     "%s", __FUNCTION__,
 //                 "msgset",       "%s", MSGSET_OAUTH_ERROR,
-//                 "msg",          "%s", "No permission to read attribute",
+//                 "msg",          "%s", "No permission to write attribute",
 //                 //"user",         "%s", gobj_get_user(src),
 //                 "gclass",       "%s", gobj_gclass_name(gobj),
-//                 "attr",         "%s", name?name:"",
+//                 "attr",         "%s", path?path:"",
 //                 NULL
 //             );
-//             return 0;
+//             JSON_DECREF(value);
+//             return -403;
 //         }
 //     }
 
-    json_t *jn_value = 0;
+    int ret;
 
     if(ASN_IS_STRING(it->type)) {
-        jn_value = json_string(sdata_read_str(hs, name));
+        ret = sdata_write_str(hs, name, json_string_value(value));
     } else if(ASN_IS_BOOLEAN(it->type)) {
-        jn_value = sdata_read_bool(hs, name)?json_true():json_false();
+        ret = sdata_write_bool(hs, name, json_boolean_value(value));
     } else if(ASN_IS_UNSIGNED32(it->type)) {
-        jn_value = json_integer(sdata_read_uint32(hs, name));
+        ret = sdata_write_uint32(hs, name, json_integer_value(value));
     } else if(ASN_IS_SIGNED32(it->type)) {
-        jn_value = json_integer(sdata_read_int32(hs, name));
+        ret = sdata_write_int32(hs, name, json_integer_value(value));
     } else if(ASN_IS_UNSIGNED64(it->type)) {
-        jn_value = json_integer(sdata_read_uint64(hs, name));
+        ret = sdata_write_uint64(hs, name, json_integer_value(value));
     } else if(ASN_IS_SIGNED64(it->type)) {
-        jn_value = json_integer(sdata_read_int64(hs, name));
+        ret = sdata_write_int64(hs, name, json_integer_value(value));
     } else if(ASN_IS_DOUBLE(it->type)) {
-        jn_value = json_real(sdata_read_real(hs, name));
+        ret = sdata_write_real(hs, name, json_real_value(value));
     } else if(ASN_IS_JSON(it->type)) {
-        jn_value = sdata_read_json(hs, name);
-        JSON_INCREF(jn_value);
+        ret = sdata_write_json(hs, name, value); // WARNING json is incref
+        JSON_DECREF(value);
     } else if(ASN_IS_POINTER(it->type)) {
-        jn_value = json_integer((json_int_t)(size_t)sdata_read_pointer(hs, name));
+        ret = sdata_write_pointer(hs, name, (void *)(size_t)json_integer_value(value));
     } else {
         log_error(LOG_OPT_TRACE_STACK,
             "gobj",         "%s", gobj_full_name(gobj),
@@ -8143,109 +11731,71 @@ PRIVATE json_t *_gobj_read_attr(
             "attr",         "%s", name?name:"",
             NULL
         );
+        ret = -1;
     }
 
-    return jn_value;
+    JSON_DECREF(value);
+    return ret;
 }
 
 /***************************************************************************
- *  ATTR: read str
- *  Return is yours! Must be decref. New api (May/2019), js style
+ *  ATTR: write
+ *  New api (May/2019), js style
  *  With AUTHZ
  *  Inherit from js-core
  ***************************************************************************/
-PUBLIC json_t *gobj_read_attr(
+PUBLIC int gobj_write_attr(
     hgobj gobj,
     const char *path, // If it has ` then segments are gobj and leaf is the attribute (+bottom)
+    json_t *value,  // owned
     hgobj src
 )
 {
     // TODO use segments of ` to search in childs
 
-    json_t *jn_attr = _gobj_read_attr(gobj, path, src);
-
-    return jn_attr;
+    return _gobj_write_attr(gobj, path, value, src);
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC json_t *gobj_read_user_data(
+PUBLIC int gobj_write_user_data(
     hgobj gobj,
-    const char *name
+    const char *name,
+    json_t *value // owned
 )
 {
     if(gobj) {
-        if(empty_string(name)) {
-            return ((GObj_t *)gobj)->jn_user_data;
-        } else {
-            return json_object_get(((GObj_t *)gobj)->jn_user_data, name);
-        }
+        return json_object_set_new(((GObj_t *)gobj)->jn_user_data, name, value);
     } else {
-        return 0;
+        return -1;
     }
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC json_t *gobj_kw_get_user_data(
+PUBLIC int gobj_kw_set_user_data(
     hgobj gobj,
-    const char *path,
-    json_t *default_value,
-    kw_flag_t flag
+    const char *path,   // The last word after ` is the key
+    json_t *value // owned
 )
 {
     if(gobj) {
-        return kw_get_dict_value(((GObj_t *)gobj)->jn_user_data, path, default_value, flag);
-    } else {
-        return 0;
-    }
-}
-
-/***************************************************************************
- *  ATTR: read str
- ***************************************************************************/
-PUBLIC const char *gobj_read_str_attr(hgobj gobj, const char *name)
-{
-    if(name && strcasecmp(name, "__state__")==0) {
-        return gobj_current_state(gobj);
-    }
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_read_str(hs, name);
-    }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "short_name",   "%s", gobj_short_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return 0;
-}
-
-/***************************************************************************
- *  ATTR: read bool
- ***************************************************************************/
-PUBLIC BOOL gobj_read_bool_attr(hgobj gobj, const char *name)
-{
-    if(name) {
-        if(strcasecmp(name, "__disabled__")==0) {
-            return gobj_is_disabled(gobj);
-        } else if(strcasecmp(name, "__running__")==0) {
-            return gobj_is_running(gobj);
-        } else if(strcasecmp(name, "__playing__")==0) {
-            return gobj_is_playing(gobj);
-        } else if(strcasecmp(name, "__service__")==0) {
-            return gobj_is_service(gobj);
-        }
+        return kw_set_dict_value(((GObj_t *)gobj)->jn_user_data, path, value);
+    } else {
+        return -1;
     }
+}
+
+/***************************************************************************
+ *  ATTR: write
+ ***************************************************************************/
+PUBLIC int gobj_write_str_attr(hgobj gobj, const char *name, const char *value)
+{
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_bool(hs, name);
+        return sdata_write_str(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8256,17 +11806,34 @@ PUBLIC BOOL gobj_read_bool_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC int32_t gobj_read_int32_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_strn_attr(hgobj gobj, const char *name, const char *value, int string_length)
 {
+    // HACK TODO sdata_write_str() está mal diseñado, no permite pasar un string con longitud
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_int32(hs, name);
+        char *value_ = gbmem_strndup(value, string_length);
+        if(!value_) {
+            log_warning(LOG_OPT_TRACE_STACK,
+                "gobj",         "%s", gobj_full_name(gobj),
+                "function",     "%s", __FUNCTION__,
+                "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+                "msg",          "%s", "gbmem_strndup() FAILED",
+                "gclass",       "%s", gobj_gclass_name(gobj),
+                "attr",         "%s", name?name:"",
+                "string_length","%d", string_length,
+                NULL
+            );
+            return -1;
+        }
+        int ret = sdata_write_str(hs, name, value_);
+        GBMEM_FREE(value_);
+        return ret;
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8277,20 +11844,17 @@ PUBLIC int32_t gobj_read_int32_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC uint32_t gobj_read_uint32_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_bool_attr(hgobj gobj, const char *name, BOOL value)
 {
-    if(name && strcasecmp(name, "__trace_level__")==0) {
-        return gobj_trace_level(gobj);
-    }
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_uint32(hs, name);
+        return sdata_write_bool(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8301,17 +11865,17 @@ PUBLIC uint32_t gobj_read_uint32_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC int64_t gobj_read_int64_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_int32_attr(hgobj gobj, const char *name, int32_t value)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_int64(hs, name);
+        return sdata_write_int32(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8322,17 +11886,17 @@ PUBLIC int64_t gobj_read_int64_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC uint64_t gobj_read_uint64_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_uint32_attr(hgobj gobj, const char *name, uint32_t value)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_uint64(hs, name);
+        return sdata_write_uint32(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8343,17 +11907,17 @@ PUBLIC uint64_t gobj_read_uint64_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC uint64_t gobj_read_integer_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_int64_attr(hgobj gobj, const char *name, int64_t value)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_integer(hs, name);
+        return sdata_write_int64(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8364,17 +11928,17 @@ PUBLIC uint64_t gobj_read_integer_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC double gobj_read_real_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_uint64_attr(hgobj gobj, const char *name, uint64_t value)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_real(hs, name);
+        return sdata_write_uint64(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8385,17 +11949,17 @@ PUBLIC double gobj_read_real_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC json_t *gobj_read_json_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_integer_attr(hgobj gobj, const char *name, uint64_t value)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_json(hs, name);
+        return sdata_write_integer(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8406,17 +11970,17 @@ PUBLIC json_t *gobj_read_json_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC void *gobj_read_pointer_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_real_attr(hgobj gobj, const char *name, double value)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_pointer(hs, name);
+        return sdata_write_real(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8427,17 +11991,17 @@ PUBLIC void *gobj_read_pointer_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write.  WARNING json is incref! (new V2)
  ***************************************************************************/
-PUBLIC dl_list_t *gobj_read_dl_list_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_json_attr(hgobj gobj, const char *name, json_t *value)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_dl_list(hs, name);
+        return sdata_write_json(hs, name, value); // value is incref!
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8448,17 +12012,20 @@ PUBLIC dl_list_t *gobj_read_dl_list_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    KW_INCREF(value); // although error the json is incref
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write.  WARNING json is NOT incref
  ***************************************************************************/
-PUBLIC dl_list_t *gobj_read_iter_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_new_json_attr(hgobj gobj, const char *name, json_t *value)
 {
     hsdata hs = gobj_hsdata2(gobj, name, FALSE);
     if(hs) {
-        return sdata_read_iter(hs, name);
+        int ret = sdata_write_json(hs, name, value); // value is incref!
+        KW_DECREF(value);
+        return ret;
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8469,21 +12036,18 @@ PUBLIC dl_list_t *gobj_read_iter_attr(hgobj gobj, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    KW_DECREF(value);
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC const sdata_desc_t * gobj_read_iter_schema(hgobj gobj_, const char *name)
+PUBLIC int gobj_write_pointer_attr(hgobj gobj, const char *name, void *value)
 {
-    GObj_t *gobj = gobj_;
-
-    if(gobj_has_attr(gobj, name)) {
-        const sdata_desc_t * desc = gobj_attr_desc(gobj, name);
-        return desc->schema;
-    } else if(gobj && gobj->bottom_gobj) {
-        return gobj_read_iter_schema(gobj->bottom_gobj, name);
+    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
+    if(hs) {
+        return sdata_write_pointer(hs, name, value);
     }
     log_warning(LOG_OPT_TRACE_STACK,
         "gobj",         "%s", gobj_full_name(gobj),
@@ -8494,507 +12058,548 @@ PUBLIC const sdata_desc_t * gobj_read_iter_schema(hgobj gobj_, const char *name)
         "attr",         "%s", name?name:"",
         NULL
     );
-    return 0;
+    return -1;
 }
 
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
  ***************************************************************************/
-PUBLIC BOOL gobj_is_readable_attr(hgobj gobj, const char *name)
+PUBLIC BOOL gobj_is_writable_attr(hgobj gobj, const char *name)
 {
     const sdata_desc_t *it = gobj_attr_desc(gobj, name);
-    if(it && it->flag & (ATTR_READABLE)) {
+    if(it && it->flag & (ATTR_WRITABLE)) {
         return TRUE;
     } else {
         return FALSE;
     }
 }
+
 /***************************************************************************
- *  ATTR: read
+ *  ATTR: write
+ *  Return a json list of writable attribute names
+ *  Inherit from js-core
  ***************************************************************************/
-PUBLIC SData_Value_t gobj_read_default_attr_value(hgobj gobj, const char* name)  // Only for basic types
+PUBLIC json_t *gobj_get_writable_attrs(hgobj gobj) // Return is yours, decref!
 {
-    return sdata_get_default_value(gobj_hsdata(gobj), name);
+    json_t *jn_list = json_array();
+
+    const sdata_desc_t *it = gobj_tattr_desc(gobj);
+
+    while(it && it->name) {
+        if(it->flag & (SDF_PERSIST|SDF_WR)) {
+            json_array_append_new(jn_list, json_string(it->name));
+        }
+        it++;
+    }
+    return jn_list;
 }
 
 /***************************************************************************
- *
+ *  ATTR: write
+ *  Update writable attrs
+ *  Inherit from js-core
  ***************************************************************************/
-PRIVATE int _gobj_write_attr(
+PUBLIC int gobj_update_writable_attrs(
     hgobj gobj,
-    const char *name,
-    json_t *value,  // owned
+    json_t *jn_attrs, // owned
     hgobj src
 )
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE); // This search in bottom's
-    if(!hs) {
-        log_warning(LOG_OPT_TRACE_STACK,
-            "gobj",         "%s", gobj_full_name(gobj),
-            "function",     "%s", __FUNCTION__,
-            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "GClass Attribute NOT FOUND",
-            "gclass",       "%s", gobj_gclass_name(gobj),
-            "attr",         "%s", name?name:"",
-            NULL
-        );
-        JSON_DECREF(value);
-        return -1;
+    int ret = 0;
+    const char *key; json_t *jn_attr;
+    json_object_foreach(jn_attrs, key, jn_attr) {
+        if(gobj_is_writable_attr(gobj, key)) {
+            JSON_INCREF(jn_attr);
+            ret += gobj_write_attr(gobj, key, jn_attr, src);
+        }
     }
 
-    const sdata_desc_t *it = sdata_it_desc(sdata_schema(hs), name);
+    JSON_DECREF(jn_attrs);
+    return ret;
+}
 
-//     if(it->flag & SDF_AUTHZ_W) {
-//         /*
-//          *  AUTHZ Required
-//          */
-//         if(!gobj_user_has_authz(
-//                 gobj, "__write_attribute__", json_pack("{s:s}", "path", path), src)
-//           ) {
-//             log_error(0,
-//                 "gobj",         "%s", gobj_full_name(gobj),
-//                 "function",     "%s", __FUNCTION__,
-//                 "msgset",       "%s", MSGSET_OAUTH_ERROR,
-//                 "msg",          "%s", "No permission to write attribute",
-//                 //"user",         "%s", gobj_get_user(src),
-//                 "gclass",       "%s", gobj_gclass_name(gobj),
-//                 "attr",         "%s", path?path:"",
-//                 NULL
-//             );
-//             JSON_DECREF(value);
-//             return -403;
-//         }
-//     }
+/***************************************************************************
+ *  ATTR: write
+ *  Reset volatile attributes
+ ***************************************************************************/
+PUBLIC int gobj_reset_volatil_attrs(hgobj gobj)
+{
+    return sdata_write_default_values(
+        gobj_hsdata(gobj),
+        SDF_VOLATIL,    // include_flag
+        0               // exclude_flag
+    );
+}
 
-    int ret;
+/***************************************************************************
+ *  ATTR: resolve the attribute `name` into a handle,
+ *  searching in the bottom chain like gobj_hsdata2().
+ ***************************************************************************/
+PUBLIC int gobj_attr_handle(hgobj gobj_, const char *name, gobj_attr_handle_t *handle)
+{
+    GObj_t *gobj = gobj_;
 
-    if(ASN_IS_STRING(it->type)) {
-        ret = sdata_write_str(hs, name, json_string_value(value));
-    } else if(ASN_IS_BOOLEAN(it->type)) {
-        ret = sdata_write_bool(hs, name, json_boolean_value(value));
-    } else if(ASN_IS_UNSIGNED32(it->type)) {
-        ret = sdata_write_uint32(hs, name, json_integer_value(value));
-    } else if(ASN_IS_SIGNED32(it->type)) {
-        ret = sdata_write_int32(hs, name, json_integer_value(value));
-    } else if(ASN_IS_UNSIGNED64(it->type)) {
-        ret = sdata_write_uint64(hs, name, json_integer_value(value));
-    } else if(ASN_IS_SIGNED64(it->type)) {
-        ret = sdata_write_int64(hs, name, json_integer_value(value));
-    } else if(ASN_IS_DOUBLE(it->type)) {
-        ret = sdata_write_real(hs, name, json_real_value(value));
-    } else if(ASN_IS_JSON(it->type)) {
-        ret = sdata_write_json(hs, name, value); // WARNING json is incref
-        JSON_DECREF(value);
-    } else if(ASN_IS_POINTER(it->type)) {
-        ret = sdata_write_pointer(hs, name, (void *)(size_t)json_integer_value(value));
-    } else {
+    if(!handle) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "handle NULL",
+            "attr",         "%s", name?name:"",
+            NULL
+        );
+        return -1;
+    }
+    memset(handle, 0, sizeof(gobj_attr_handle_t));
+
+    if(!gobj) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL",
+            "attr",         "%s", name?name:"",
+            NULL
+        );
+        return -1;
+    }
+
+    /*
+     *  The pseudo-attributes are not in the sdata, see gobj_read_bool_attr()
+     */
+    if(name && (strcasecmp(name, "__state__")==0 ||
+            strcasecmp(name, "__disabled__")==0 ||
+            strcasecmp(name, "__running__")==0 ||
+            strcasecmp(name, "__playing__")==0 ||
+            strcasecmp(name, "__service__")==0)) {
         log_error(LOG_OPT_TRACE_STACK,
             "gobj",         "%s", gobj_full_name(gobj),
             "function",     "%s", __FUNCTION__,
             "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-            "msg",          "%s", "GClass Attribute Type NOT VALID",
+            "msg",          "%s", "pseudo-attribute without handle, use gobj_read_*_attr()",
+            "attr",         "%s", name,
+            NULL
+        );
+        return -1;
+    }
+
+    GObj_t *owner = gobj;
+    while(owner && !gobj_has_attr(owner, name)) {
+        owner = owner->bottom_gobj;
+    }
+    if(!owner) {
+        log_warning(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", gobj_full_name(gobj),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "GClass Attribute NOT FOUND",
             "gclass",       "%s", gobj_gclass_name(gobj),
             "attr",         "%s", name?name:"",
             NULL
         );
-        ret = -1;
+        return -1;
     }
 
-    JSON_DECREF(value);
-    return ret;
+    const sdata_desc_t *it = 0;
+    void *ptr = sdata_it_pointer(gobj_hsdata(owner), name, &it);
+    if(!ptr || !it) {
+        // error already logged.
+        return -1;
+    }
+
+    handle->gobj = owner;
+    handle->hs = gobj_hsdata(owner);
+    handle->it = it;
+    handle->ptr = ptr;
+    return 0;
 }
 
 /***************************************************************************
- *  ATTR: write
- *  New api (May/2019), js style
- *  With AUTHZ
- *  Inherit from js-core
+ *  ATTR: check the handle is resolved
  ***************************************************************************/
-PUBLIC int gobj_write_attr(
-    hgobj gobj,
-    const char *path, // If it has ` then segments are gobj and leaf is the attribute (+bottom)
-    json_t *value,  // owned
-    hgobj src
-)
+PRIVATE BOOL attr_handle_resolved(const gobj_attr_handle_t *handle, const char *fn)
 {
-    // TODO use segments of ` to search in childs
+    if(!handle || !handle->it || !handle->ptr) {
+        log_error(LOG_OPT_TRACE_STACK,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", fn,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "attr handle NOT RESOLVED",
+            NULL
+        );
+        return FALSE;
+    }
+    return TRUE;
+}
 
-    return _gobj_write_attr(gobj, path, value, src);
+/***************************************************************************
+ *  ATTR: log the type mismatch, like sdata_read_*() and sdata_write_*()
+ ***************************************************************************/
+PRIVATE void attr_handle_type_error(const gobj_attr_handle_t *handle, const char *msg, const char *fn)
+{
+    log_error(LOG_OPT_TRACE_STACK,
+        "gobj",         "%s", gobj_full_name(handle->gobj),
+        "function",     "%s", fn,
+        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+        "msg",          "%s", msg,
+        "name",         "%s", handle->it->name,
+        "type",         "%s", sdata_type_name(handle->it->type),
+        NULL
+    );
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: write the value, logging if it fails
  ***************************************************************************/
-PUBLIC int gobj_write_user_data(
-    hgobj gobj,
-    const char *name,
-    json_t *value // owned
-)
+PRIVATE int attr_handle_write(const gobj_attr_handle_t *handle, SData_Value_t v, const char *fn)
 {
-    if(gobj) {
-        return json_object_set_new(((GObj_t *)gobj)->jn_user_data, name, value);
-    } else {
-        return -1;
+    int ret = sdata_write_by_type(handle->hs, handle->it, handle->ptr, v);
+    if(ret<0) {
+        log_error(0,
+            "gobj",         "%s", gobj_full_name(handle->gobj),
+            "function",     "%s", fn,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "sdata_write_by_types() FAILED",
+            "name",         "%s", handle->it->name,
+            "type",         "%s", sdata_type_name(handle->it->type),
+            NULL
+        );
     }
+    return ret;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: read by handle
  ***************************************************************************/
-PUBLIC int gobj_kw_set_user_data(
-    hgobj gobj,
-    const char *path,   // The last word after ` is the key
-    json_t *value // owned
-)
+PUBLIC const char *gobj_read_str_by_handle(const gobj_attr_handle_t *handle)
 {
-    if(gobj) {
-        return kw_set_dict_value(((GObj_t *)gobj)->jn_user_data, path, value);
-    } else {
-        return -1;
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
     }
+    if(!ASN_IS_STRING(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT STRING", __FUNCTION__);
+        return 0;
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).s;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: read by handle
  ***************************************************************************/
-PUBLIC int gobj_write_str_attr(hgobj gobj, const char *name, const char *value)
+PUBLIC BOOL gobj_read_bool_by_handle(const gobj_attr_handle_t *handle)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_str(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_BOOLEAN(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT BOOLEAN", __FUNCTION__);
+        // If error is by the sign then continue
+        if(!ASN_IS_NATURAL_NUMBER(handle->it->type)) {
+            return 0;
+        }
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).b;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: read by handle
  ***************************************************************************/
-PUBLIC int gobj_write_strn_attr(hgobj gobj, const char *name, const char *value, int string_length)
+PUBLIC int32_t gobj_read_int32_by_handle(const gobj_attr_handle_t *handle)
 {
-    // HACK TODO sdata_write_str() está mal diseñado, no permite pasar un string con longitud
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        char *value_ = gbmem_strndup(value, string_length);
-        if(!value_) {
-            log_warning(LOG_OPT_TRACE_STACK,
-                "gobj",         "%s", gobj_full_name(gobj),
-                "function",     "%s", __FUNCTION__,
-                "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-                "msg",          "%s", "gbmem_strndup() FAILED",
-                "gclass",       "%s", gobj_gclass_name(gobj),
-                "attr",         "%s", name?name:"",
-                "string_length","%d", string_length,
-                NULL
-            );
-            return -1;
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
+    }
+    if(!ASN_IS_SIGNED32(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT SIGNED32", __FUNCTION__);
+        // If error is by the sign then continue
+        if(!ASN_IS_NATURAL_NUMBER(handle->it->type)) {
+            return 0;
         }
-        int ret = sdata_write_str(hs, name, value_);
-        GBMEM_FREE(value_);
-        return ret;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).i32;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: read by handle
  ***************************************************************************/
-PUBLIC int gobj_write_bool_attr(hgobj gobj, const char *name, BOOL value)
+PUBLIC uint32_t gobj_read_uint32_by_handle(const gobj_attr_handle_t *handle)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_bool(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_UNSIGNED32(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT UNSIGNED32", __FUNCTION__);
+        // If error is by the sign then continue
+        if(!ASN_IS_NATURAL_NUMBER(handle->it->type)) {
+            return 0;
+        }
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).u32;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: read by handle
  ***************************************************************************/
-PUBLIC int gobj_write_int32_attr(hgobj gobj, const char *name, int32_t value)
+PUBLIC int64_t gobj_read_int64_by_handle(const gobj_attr_handle_t *handle)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_int32(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_SIGNED64(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT SIGNED64", __FUNCTION__);
+        // If error is by the sign then continue
+        if(!ASN_IS_NATURAL_NUMBER(handle->it->type)) {
+            return 0;
+        }
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).i64;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: read by handle
  ***************************************************************************/
-PUBLIC int gobj_write_uint32_attr(hgobj gobj, const char *name, uint32_t value)
+PUBLIC uint64_t gobj_read_uint64_by_handle(const gobj_attr_handle_t *handle)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_uint32(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_UNSIGNED64(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT UNSIGNED64", __FUNCTION__);
+        // If error is by the sign then continue
+        if(!ASN_IS_NATURAL_NUMBER(handle->it->type)) {
+            return 0;
+        }
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).u64;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: read by handle
  ***************************************************************************/
-PUBLIC int gobj_write_int64_attr(hgobj gobj, const char *name, int64_t value)
+PUBLIC uint64_t gobj_read_integer_by_handle(const gobj_attr_handle_t *handle)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_int64(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_NATURAL_NUMBER(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT NATURAL NUMBER", __FUNCTION__);
+        return 0;
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).u64;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: read by handle
  ***************************************************************************/
-PUBLIC int gobj_write_uint64_attr(hgobj gobj, const char *name, uint64_t value)
+PUBLIC double gobj_read_real_by_handle(const gobj_attr_handle_t *handle)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_uint64(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_REAL_NUMBER(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT DOUBLE", __FUNCTION__);
+        return 0;
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).f;
+}
+
+/***************************************************************************
+ *  ATTR: read by handle
+ ***************************************************************************/
+PUBLIC json_t *gobj_read_json_by_handle(const gobj_attr_handle_t *handle)
+{
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
+    }
+    if(!ASN_IS_JSON(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT JSON", __FUNCTION__);
+        return 0;
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).j;
+}
+
+/***************************************************************************
+ *  ATTR: read by handle
+ ***************************************************************************/
+PUBLIC void *gobj_read_pointer_by_handle(const gobj_attr_handle_t *handle)
+{
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return 0;
+    }
+    if(!ASN_IS_POINTER(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT POINTER", __FUNCTION__);
+        // If error is by the sign then continue
+        if(!ASN_IS_NUMBER64(handle->it->type)) {
+            return 0;
+        }
+    }
+    return sdata_read_by_type(handle->hs, handle->it, handle->ptr).p;
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC int gobj_write_integer_attr(hgobj gobj, const char *name, uint64_t value)
+PUBLIC int gobj_write_str_by_handle(const gobj_attr_handle_t *handle, const char *value)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_integer(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_STRING(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT STRING", __FUNCTION__);
+        return -1;
+    }
+    SData_Value_t v;
+    v.s = (char *)value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC int gobj_write_real_attr(hgobj gobj, const char *name, double value)
+PUBLIC int gobj_write_bool_by_handle(const gobj_attr_handle_t *handle, BOOL value)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_real(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_BOOLEAN(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT BOOLEAN", __FUNCTION__);
+        return -1;
+    }
+    SData_Value_t v;
+    v.b = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
- *  ATTR: write.  WARNING json is incref! (new V2)
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC int gobj_write_json_attr(hgobj gobj, const char *name, json_t *value)
+PUBLIC int gobj_write_int32_by_handle(const gobj_attr_handle_t *handle, int32_t value)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_json(hs, name, value); // value is incref!
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    KW_INCREF(value); // although error the json is incref
-    return -1;
+    if(!ASN_IS_SIGNED32(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT SIGNED32", __FUNCTION__);
+        return -1;
+    }
+    SData_Value_t v;
+    v.i32 = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
- *  ATTR: write.  WARNING json is NOT incref
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC int gobj_write_new_json_attr(hgobj gobj, const char *name, json_t *value)
+PUBLIC int gobj_write_uint32_by_handle(const gobj_attr_handle_t *handle, uint32_t value)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        int ret = sdata_write_json(hs, name, value); // value is incref!
-        KW_DECREF(value);
-        return ret;
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    KW_DECREF(value);
-    return -1;
+    if(!ASN_IS_UNSIGNED32(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT UNSIGNED32", __FUNCTION__);
+        return -1;
+    }
+    SData_Value_t v;
+    v.u32 = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC int gobj_write_pointer_attr(hgobj gobj, const char *name, void *value)
+PUBLIC int gobj_write_int64_by_handle(const gobj_attr_handle_t *handle, int64_t value)
 {
-    hsdata hs = gobj_hsdata2(gobj, name, FALSE);
-    if(hs) {
-        return sdata_write_pointer(hs, name, value);
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
     }
-    log_warning(LOG_OPT_TRACE_STACK,
-        "gobj",         "%s", gobj_full_name(gobj),
-        "function",     "%s", __FUNCTION__,
-        "msgset",       "%s", MSGSET_PARAMETER_ERROR,
-        "msg",          "%s", "GClass Attribute NOT FOUND",
-        "gclass",       "%s", gobj_gclass_name(gobj),
-        "attr",         "%s", name?name:"",
-        NULL
-    );
-    return -1;
+    if(!ASN_IS_SIGNED64(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT SIGNED64", __FUNCTION__);
+        return -1;
+    }
+    SData_Value_t v;
+    v.i64 = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
- *  ATTR: write
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC BOOL gobj_is_writable_attr(hgobj gobj, const char *name)
+PUBLIC int gobj_write_uint64_by_handle(const gobj_attr_handle_t *handle, uint64_t value)
 {
-    const sdata_desc_t *it = gobj_attr_desc(gobj, name);
-    if(it && it->flag & (ATTR_WRITABLE)) {
-        return TRUE;
-    } else {
-        return FALSE;
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
+    }
+    if(!ASN_IS_UNSIGNED64(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT UNSIGNED64", __FUNCTION__);
+        return -1;
     }
+    SData_Value_t v;
+    v.u64 = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
- *  ATTR: write
- *  Return a json list of writable attribute names
- *  Inherit from js-core
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC json_t *gobj_get_writable_attrs(hgobj gobj) // Return is yours, decref!
+PUBLIC int gobj_write_integer_by_handle(const gobj_attr_handle_t *handle, uint64_t value)
 {
-    json_t *jn_list = json_array();
-
-    const sdata_desc_t *it = gobj_tattr_desc(gobj);
-
-    while(it && it->name) {
-        if(it->flag & (SDF_PERSIST|SDF_WR)) {
-            json_array_append_new(jn_list, json_string(it->name));
-        }
-        it++;
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
     }
-    return jn_list;
+    SData_Value_t v;
+    v.u64 = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
- *  ATTR: write
- *  Update writable attrs
- *  Inherit from js-core
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC int gobj_update_writable_attrs(
-    hgobj gobj,
-    json_t *jn_attrs, // owned
-    hgobj src
-)
+PUBLIC int gobj_write_real_by_handle(const gobj_attr_handle_t *handle, double value)
 {
-    int ret = 0;
-    const char *key; json_t *jn_attr;
-    json_object_foreach(jn_attrs, key, jn_attr) {
-        if(gobj_is_writable_attr(gobj, key)) {
-            JSON_INCREF(jn_attr);
-            ret += gobj_write_attr(gobj, key, jn_attr, src);
-        }
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
+    }
+    if(!ASN_IS_DOUBLE(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT DOUBLE", __FUNCTION__);
+        return -1;
     }
+    SData_Value_t v;
+    v.f = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
+}
 
-    JSON_DECREF(jn_attrs);
-    return ret;
+/***************************************************************************
+ *  ATTR: write by handle
+ ***************************************************************************/
+PUBLIC int gobj_write_json_by_handle(const gobj_attr_handle_t *handle, json_t *value)
+{
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
+    }
+    if(!ASN_IS_JSON(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT JSON", __FUNCTION__);
+        return -1;
+    }
+    SData_Value_t v;
+    v.j = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
- *  ATTR: write
- *  Reset volatile attributes
+ *  ATTR: write by handle
  ***************************************************************************/
-PUBLIC int gobj_reset_volatil_attrs(hgobj gobj)
+PUBLIC int gobj_write_pointer_by_handle(const gobj_attr_handle_t *handle, void *value)
 {
-    return sdata_write_default_values(
-        gobj_hsdata(gobj),
-        SDF_VOLATIL,    // include_flag
-        0               // exclude_flag
-    );
+    if(!attr_handle_resolved(handle, __FUNCTION__)) {
+        return -1;
+    }
+    if(!ASN_IS_POINTER(handle->it->type)) {
+        attr_handle_type_error(handle, "sdata type IS NOT POINTER", __FUNCTION__);
+        return -1;
+    }
+    SData_Value_t v;
+    v.p = value;
+    return attr_handle_write(handle, v, __FUNCTION__);
 }
 
 /***************************************************************************
@@ -9837,6 +13442,32 @@ PUBLIC BOOL gobj_typeof_inherited_gclass(hgobj gobj_, const char *gclass_name)
     return FALSE;
 }
 
+/***************************************************************************
+ *  Change state by index (internal use)
+ ***************************************************************************/
+PRIVATE BOOL _change_state_index(GObj_t * gobj, int new_state)
+{
+    SMachine_t * mach = gobj->mach;
+
+    if(mach->current_state != new_state) {
+        mach->last_state = mach->current_state;
+        mach->current_state = new_state;
+        if(__trace_gobj_event_monitor__(gobj)) {
+            monitor_state(gobj);
+        }
+        BOOL tracea = is_machine_tracing(gobj) && !is_machine_not_tracing(gobj);
+        if(tracea) {
+            trace_machine(" 🔷 mach(%s%s^%s), new_st: %s",
+                (!gobj->running)?"!!":"",
+                gobj_gclass_name(gobj), gobj_name(gobj),
+                mach->fsm->state_names[new_state]
+            );
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
 /***************************************************************************
  *  Change state (internal use)
  ***************************************************************************/
@@ -9851,23 +13482,7 @@ PRIVATE BOOL _change_state(GObj_t * gobj, const char *new_state)
 
     for(i=0; *state_names!=0; i++, state_names++) {
         if(strcasecmp(*state_names, new_state)==0) {
-            if(mach->current_state != i) {
-                mach->last_state = mach->current_state;
-                mach->current_state = i;
-                if(__trace_gobj_event_monitor__(gobj)) {
-                    monitor_state(gobj);
-                }
-                BOOL tracea = is_machine_tracing(gobj) && !is_machine_not_tracing(gobj);
-                if(tracea) {
-                    trace_machine(" 🔷 mach(%s%s^%s), new_st: %s",
-                        (!gobj->running)?"!!":"",
-                        gobj_gclass_name(gobj), gobj_name(gobj),
-                        new_state
-                    );
-                }
-                return TRUE;
-            }
-            return FALSE;
+            return _change_state_index(gobj, i);
         }
     }
     log_error(LOG_OPT_TRACE_STACK,
@@ -9910,44 +13525,156 @@ PUBLIC BOOL gobj_change_state(hgobj gobj_, const char *new_state)
         return FALSE;
     }
 
-    BOOL state_changed = _change_state(gobj, new_state);
+    BOOL state_changed = _change_state(gobj, new_state);
+
+    if(state_changed && gobj_is_running(gobj)) {
+        BOOL tracea_states = __trace_gobj_states__(gobj)?TRUE:FALSE;
+        BOOL tracea = is_machine_tracing(gobj) && !is_machine_not_tracing(gobj);
+        SMachine_t * mach = gobj->mach;
+
+        if(tracea && tracea_states) {
+            trace_machine("🔀🔀 mach(%s%s^%s), st(%d:%s%s%s)",
+                (!gobj->running)?"!!":"",
+                gobj_gclass_name(gobj), gobj_name(gobj),
+                mach->current_state,
+                On_Black RGreen,
+                mach->fsm->state_names[mach->current_state],
+                Color_Off
+            );
+        }
+
+        notify_state_changed(gobj);
+    }
+
+    return state_changed;
+}
+
+/***************************************************************************
+ *  Inform of a state change:
+ *  first to the state listeners (state indexes, no json),
+ *  then to mt_state_changed or to the subscribers of __EV_STATE_CHANGED__.
+ *  The kw is only built if someone is going to receive it.
+ ***************************************************************************/
+PRIVATE void notify_state_changed(GObj_t * gobj)
+{
+    SMachine_t * mach = gobj->mach;
+
+    for(int i=0; i<gobj->n_state_listeners; i++) {
+        state_listener_t *listener = gobj->state_listeners + i;
+        listener->cb(gobj, mach->last_state, mach->current_state, listener->user_data);
+        if(gobj->obflag & obflag_destroyed) {
+            return;
+        }
+    }
+
+    if(!gobj->gclass->gmt.mt_state_changed &&
+            !gobj->gclass->gmt.mt_publish_event &&
+            !subs_index_has_subscribers(gobj, __EV_STATE_CHANGED__)) {
+        return;
+    }
+
+    json_t *kw_st = json_object();
+    json_object_set_new(
+        kw_st,
+        "previous_state",
+        json_string(mach->fsm->state_names[mach->last_state])
+    );
+    json_object_set_new(
+        kw_st,
+        "current_state",
+        json_string(mach->fsm->state_names[mach->current_state])
+    );
+
+    if(gobj->gclass->gmt.mt_state_changed) {
+        gobj->gclass->gmt.mt_state_changed(gobj, __EV_STATE_CHANGED__, kw_st);
+    } else {
+        gobj_publish_event(gobj, __EV_STATE_CHANGED__, kw_st);
+    }
+}
+
+/***************************************************************************
+ *  Add a lightweight state listener.
+ *  `cb` is called in every state change of gobj, with the indexes
+ *  of previous and current states (index in the fsm's state_names).
+ *  Don't add or remove listeners of the gobj inside the callback.
+ ***************************************************************************/
+PUBLIC int gobj_add_state_listener(
+    hgobj gobj_,
+    gobj_state_listener_fn cb,
+    void *user_data)
+{
+    GObj_t * gobj = gobj_;
+
+    if(!gobj || (gobj->obflag & obflag_destroyed) || !cb) {
+        log_error(0,
+            "gobj",         "%s", __FILE__,
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_PARAMETER_ERROR,
+            "msg",          "%s", "gobj NULL or DESTROYED, or cb NULL",
+            NULL
+        );
+        return -1;
+    }
+
+    state_listener_t *new_listeners = gbmem_malloc(
+        (gobj->n_state_listeners + 1) * sizeof(state_listener_t)
+    );
+    if(!new_listeners) {
+        log_error(0,
+            "gobj",         "%s", gobj_full_name(gobj),
+            "function",     "%s", __FUNCTION__,
+            "msgset",       "%s", MSGSET_MEMORY_ERROR,
+            "msg",          "%s", "no memory for state listener",
+            NULL
+        );
+        return -1;
+    }
+    if(gobj->state_listeners) {
+        memcpy(
+            new_listeners,
+            gobj->state_listeners,
+            gobj->n_state_listeners * sizeof(state_listener_t)
+        );
+        gbmem_free(gobj->state_listeners);
+    }
+    new_listeners[gobj->n_state_listeners].cb = cb;
+    new_listeners[gobj->n_state_listeners].user_data = user_data;
+    gobj->state_listeners = new_listeners;
+    gobj->n_state_listeners++;
+
+    return 0;
+}
 
-    if(state_changed && gobj_is_running(gobj)) {
-        BOOL tracea_states = __trace_gobj_states__(gobj)?TRUE:FALSE;
-        BOOL tracea = is_machine_tracing(gobj) && !is_machine_not_tracing(gobj);
-        SMachine_t * mach = gobj->mach;
+/***************************************************************************
+ *  Remove a state listener added with gobj_add_state_listener()
+ ***************************************************************************/
+PUBLIC int gobj_remove_state_listener(
+    hgobj gobj_,
+    gobj_state_listener_fn cb,
+    void *user_data)
+{
+    GObj_t * gobj = gobj_;
 
-        if(tracea && tracea_states) {
-            trace_machine("🔀🔀 mach(%s%s^%s), st(%d:%s%s%s)",
-                (!gobj->running)?"!!":"",
-                gobj_gclass_name(gobj), gobj_name(gobj),
-                mach->current_state,
-                On_Black RGreen,
-                mach->fsm->state_names[mach->current_state],
-                Color_Off
+    if(!gobj) {
+        return -1;
+    }
+    for(int i=0; i<gobj->n_state_listeners; i++) {
+        state_listener_t *listener = gobj->state_listeners + i;
+        if(listener->cb == cb && listener->user_data == user_data) {
+            memmove(
+                listener,
+                listener + 1,
+                (gobj->n_state_listeners - i - 1) * sizeof(state_listener_t)
             );
-        }
-
-        json_t *kw_st = json_object();
-        json_object_set_new(
-            kw_st,
-            "previous_state",
-            json_string(mach->fsm->state_names[mach->last_state])
-        );
-        json_object_set_new(
-            kw_st,
-            "current_state",
-            json_string(mach->fsm->state_names[mach->current_state])
-        );
-
-        if(gobj->gclass->gmt.mt_state_changed) {
-            gobj->gclass->gmt.mt_state_changed(gobj, __EV_STATE_CHANGED__, kw_st);
-        } else {
-            gobj_publish_event(gobj, __EV_STATE_CHANGED__, kw_st);
+            gobj->n_state_listeners--;
+            if(gobj->n_state_listeners == 0) {
+                gbmem_free(gobj->state_listeners);
+                gobj->state_listeners = 0;
+            }
+            return 0;
         }
     }
-
-    return state_changed;
+    return -1;
 }
 
 /***************************************************************************
@@ -10027,9 +13754,14 @@ PUBLIC const EVENT *gobj_input_event(hgobj gobj_, const char *event)
 {
     GObj_t *gobj = gobj_;
     const EVENT *events = gobj->mach->fsm->input_events;
-    if(!events) {
+    if(!events || !event) {
         return 0;
     }
+    fsm_table_t *fsm_table = gobj_fsm_table(gobj);
+    if(fsm_table) {
+        int ev = fsm_table_event_index(fsm_table, event);
+        return (ev < 0)? 0 : events + ev;
+    }
     for(int i=0; events->event!=0; i++, events++) {
         if(strcasecmp(events->event, event)==0) {
             return events;
@@ -10318,6 +14050,28 @@ PUBLIC json_t *gobj_stats(hgobj gobj_, const char *stats, json_t *kw, hgobj src)
         return 0;
     }
 
+    /*--------------------------------------*
+     *  Global stats of gobj system
+     *--------------------------------------*/
+    if(stats && strcmp(stats, "__action_latency__")==0) {
+        json_t *jn_data = gobj_action_latency_stats(
+            kw_get_str(kw, "gclass_name", 0, 0)
+        );
+        if(kw_get_bool(kw, "reset", 0, KW_WILD_NUMBER)) {
+            gobj_reset_action_latency_stats();
+        }
+        KW_DECREF(kw)
+        return build_webix(0, 0, 0, jn_data);
+    }
+    if(stats && strcmp(stats, "__publish_stats__")==0) {
+        json_t *jn_data = gobj_publish_stats(gobj);
+        if(kw_get_bool(kw, "reset", 0, KW_WILD_NUMBER)) {
+            gobj_reset_publish_stats(gobj);
+        }
+        KW_DECREF(kw)
+        return build_webix(0, 0, 0, jn_data);
+    }
+
     /*--------------------------------------*
      *  The local mt_stats has preference
      *--------------------------------------*/
@@ -11739,6 +15493,7 @@ PUBLIC int gobj_set_gclass_trace(GCLASS *gclass, const char *level, BOOL set)
          */
         gclass->__gclass_trace_level__ &= ~bitmask;
     }
+    INVALIDATE_TRACE_MASKS()
 
     return 0;
 }
@@ -11749,6 +15504,7 @@ PUBLIC int gobj_set_gclass_trace(GCLASS *gclass, const char *level, BOOL set)
 PUBLIC int gobj_set_panic_trace(BOOL panic_trace)
 {
     __panic_trace__ = panic_trace?TRUE:FALSE;
+    INVALIDATE_TRACE_MASKS()
 
     return 0;
 }
@@ -11760,6 +15516,7 @@ PUBLIC int gobj_set_panic_trace(BOOL panic_trace)
 PUBLIC int gobj_set_deep_tracing(int level)
 {
     __deep_trace__ = level;
+    INVALIDATE_TRACE_MASKS()
 
     return 0;
 }
@@ -11811,6 +15568,7 @@ PRIVATE int _set_gobj_trace_level(GObj_t * gobj, const char *level, BOOL set)
          */
         gobj->__gobj_trace_level__ &= ~bitmask;
     }
+    gobj->__trace_generation__ = 0;
 
     return 0;
 }
@@ -11857,9 +15615,34 @@ PUBLIC int gobj_set_global_trace(const char *level, BOOL set)
          */
         __global_trace_level__ &= ~bitmask;
     }
+    INVALIDATE_TRACE_MASKS()
     return 0;
 }
 
+/****************************************************************************
+ *  Count the gclasses filtering each attr, after a change of trace filters
+ ****************************************************************************/
+PRIVATE void update_trace_filtered_attrs(void)
+{
+    JSON_DECREF(__jn_trace_filtered_attrs__)
+
+    gclass_register_t *gclass_reg = dl_first(&dl_gclass);
+    while(gclass_reg) {
+        const char *attr; json_t *jn_value;
+        json_object_foreach(gclass_reg->gclass->__jn_trace_filter__, attr, jn_value) {
+            if(!__jn_trace_filtered_attrs__) {
+                __jn_trace_filtered_attrs__ = json_object();
+            }
+            json_object_set_new(
+                __jn_trace_filtered_attrs__,
+                attr,
+                json_integer(kw_get_int(__jn_trace_filtered_attrs__, attr, 0, 0) + 1)
+            );
+        }
+        gclass_reg = dl_next(gclass_reg);
+    }
+}
+
 /****************************************************************************
  *
  ****************************************************************************/
@@ -11867,6 +15650,8 @@ PUBLIC int gobj_load_trace_filter(GCLASS *gclass, json_t *jn_trace_filter) // ow
 {
     JSON_DECREF(gclass->__jn_trace_filter__)
     gclass->__jn_trace_filter__ = jn_trace_filter;
+    update_trace_filtered_attrs();
+    INVALIDATE_TRACE_MASKS()
     return 0;
 }
 
@@ -11922,6 +15707,8 @@ PUBLIC int gobj_add_trace_filter(GCLASS *gclass, const char *attr, const char *v
     if(idx < 0) {
         json_array_append_new(jn_list, json_string(value));
     }
+    update_trace_filtered_attrs();
+    INVALIDATE_TRACE_MASKS()
     return 0;
 }
 
@@ -11932,6 +15719,8 @@ PUBLIC int gobj_remove_trace_filter(GCLASS *gclass, const char *attr, const char
 {
     if(empty_string(attr)) {
         JSON_DECREF(gclass->__jn_trace_filter__)
+        update_trace_filtered_attrs();
+        INVALIDATE_TRACE_MASKS()
         return 0;
     }
     if(!gclass->__jn_trace_filter__) {
@@ -11958,6 +15747,8 @@ PUBLIC int gobj_remove_trace_filter(GCLASS *gclass, const char *attr, const char
         if(json_object_size(gclass->__jn_trace_filter__)==0) {
             JSON_DECREF(gclass->__jn_trace_filter__)
         }
+        update_trace_filtered_attrs();
+        INVALIDATE_TRACE_MASKS()
         return 0;
     }
 
@@ -11983,6 +15774,8 @@ PUBLIC int gobj_remove_trace_filter(GCLASS *gclass, const char *attr, const char
             JSON_DECREF(gclass->__jn_trace_filter__)
         }
     }
+    update_trace_filtered_attrs();
+    INVALIDATE_TRACE_MASKS()
 
     return 0;
 }
@@ -12038,6 +15831,7 @@ PUBLIC int gobj_set_gclass_no_trace(GCLASS *gclass, const char *level, BOOL set)
          */
         gclass->__gclass_no_trace_level__ &= ~bitmask;
     }
+    INVALIDATE_TRACE_MASKS()
 
     return 0;
 }
@@ -12089,6 +15883,7 @@ PRIVATE int _set_gobj_no_trace_level(hgobj gobj_, const char *level, BOOL set)
          */
         gobj->__gobj_no_trace_level__ &= ~bitmask;
     }
+    gobj->__trace_generation__ = 0;
 
     return 0;
 }
@@ -12107,45 +15902,84 @@ PUBLIC int gobj_set_gobj_no_trace(hgobj gobj_, const char *level, BOOL set)
     return 0;
 }
 
+#ifndef NOT_INCLUDE_TRACING
 /****************************************************************************
- *  Return gobj trace level
+ *  Compute the effective trace masks of gobj and stamp them
+ *  with the current generation.
+ *  Only here the trace filter is evaluated against the gobj's attributes.
  ****************************************************************************/
-PUBLIC uint32_t gobj_trace_level(hgobj gobj_)
+PRIVATE void refresh_trace_masks(GObj_t *gobj)
 {
-    GObj_t * gobj = gobj_;
-
-    if(__deep_trace__ || __panic_trace__) {
-        return -1;
-    }
     uint32_t bitmask = __global_trace_level__;
-    if(gobj) {
-        if(!gobj->gclass->__jn_trace_filter__ || !gobj->hsdata_attr) {
-            bitmask |= gobj->__gobj_trace_level__;
-            if(gobj->gclass) {
-                bitmask |= gobj->gclass->__gclass_trace_level__;
-            }
-        } else {
-            const char *attr; json_t *jn_list_values;
-            json_object_foreach(gobj->gclass->__jn_trace_filter__, attr, jn_list_values) {
-                int idx; json_t *jn_value;
-                json_array_foreach(jn_list_values, idx, jn_value) {
-                    const char *value = json_string_value(jn_value);
-                    // TODO consider other types than str
-                    // TODO int attr_type = gobj_attr_type(gobj, attr);
-                    const char *value_ = gobj_read_str_attr(gobj, attr);
-                    if(value && value_ && strcmp(value, value_)==0) {
-                        bitmask |= gobj->__gobj_trace_level__;
-                        if(gobj->gclass) {
-                            bitmask |= gobj->gclass->__gclass_trace_level__;
-                        }
-                        break;
-                    }
+    uint32_t no_bitmask = gobj->__gobj_no_trace_level__ |
+        gobj->gclass->__gclass_no_trace_level__;
+    uint32_t flags = 0;
+
+    if(!gobj->gclass->__jn_trace_filter__ || !gobj->hsdata_attr) {
+        bitmask |= gobj->__gobj_trace_level__;
+        bitmask |= gobj->gclass->__gclass_trace_level__;
+    } else {
+        const char *attr; json_t *jn_list_values;
+        json_object_foreach(gobj->gclass->__jn_trace_filter__, attr, jn_list_values) {
+            int idx; json_t *jn_value;
+            json_array_foreach(jn_list_values, idx, jn_value) {
+                const char *value = json_string_value(jn_value);
+                // TODO consider other types than str
+                // TODO int attr_type = gobj_attr_type(gobj, attr);
+                const char *value_ = gobj_read_str_attr(gobj, attr);
+                if(value && value_ && strcmp(value, value_)==0) {
+                    bitmask |= gobj->__gobj_trace_level__;
+                    bitmask |= gobj->gclass->__gclass_trace_level__;
+                    break;
                 }
             }
         }
     }
 
-    return bitmask;
+    /*
+     *  Machine tracing doesn't apply the trace filter
+     */
+    if(__deep_trace__ || __panic_trace__ ||
+            (__global_trace_level__ | gobj->__gobj_trace_level__ |
+                gobj->gclass->__gclass_trace_level__) & TRACE_MACHINE) {
+        flags |= TRACE_FLAG_MACHINE_TRACING;
+    }
+    if(!(abs(__deep_trace__) > 1 || __panic_trace__) && (no_bitmask & TRACE_MACHINE)) {
+        flags |= TRACE_FLAG_MACHINE_NOT_TRACING;
+    }
+    if(__deep_trace__ || __panic_trace__) {
+        bitmask = -1;
+    }
+
+    gobj->__trace_mask__ = bitmask;
+    gobj->__no_trace_mask__ = no_bitmask;
+    gobj->__trace_flags__ = flags;
+    gobj->__trace_generation__ = __trace_generation__;
+}
+
+#endif
+
+/****************************************************************************
+ *  Return gobj trace level
+ ****************************************************************************/
+PUBLIC uint32_t gobj_trace_level(hgobj gobj_)
+{
+#ifdef NOT_INCLUDE_TRACING
+    return 0;
+#else
+    GObj_t * gobj = gobj_;
+
+    if(!gobj || !gobj->gclass) {
+        if(__deep_trace__ || __panic_trace__) {
+            return -1;
+        }
+        return __global_trace_level__;
+    }
+    if(gobj->__trace_generation__ != __trace_generation__) {
+        refresh_trace_masks(gobj);
+    }
+    return gobj->__trace_mask__;
+#endif
 }
 
 /****************************************************************************
@@ -12153,13 +15987,18 @@ PUBLIC uint32_t gobj_trace_level(hgobj gobj_)
  ****************************************************************************/
 PUBLIC uint32_t gobj_no_trace_level(hgobj gobj_)
 {
+#ifdef NOT_INCLUDE_TRACING
+    return 0;
+#else
     GObj_t * gobj = gobj_;
     if(!gobj || !gobj->gclass) {
         return 0;
     }
-    uint32_t bitmask = gobj->__gobj_no_trace_level__ | gobj->gclass->__gclass_no_trace_level__;
-
-    return bitmask;
+    if(gobj->__trace_generation__ != __trace_generation__) {
+        refresh_trace_masks(gobj);
+    }
+    return gobj->__no_trace_mask__;
+#endif
 }
 
 /***************************************************************************
@@ -12419,22 +16258,19 @@ PUBLIC json_t *gobj_get_gobj_no_trace_level(hgobj gobj_)
     return jn_list;
 }
 
+#ifndef NOT_INCLUDE_TRACING
 /***************************************************************************
  *  Must trace?
  ***************************************************************************/
 PRIVATE inline BOOL is_machine_tracing(GObj_t * gobj)
 {
-    if(__deep_trace__ || __panic_trace__) {
-        return TRUE;
-    }
     if(!gobj) {
-        return FALSE;
+        return (__deep_trace__ || __panic_trace__)?TRUE:FALSE;
     }
-    int trace = __global_trace_level__ & TRACE_MACHINE ||
-        gobj->__gobj_trace_level__ & TRACE_MACHINE ||
-        gobj->gclass->__gclass_trace_level__ & TRACE_MACHINE;
-
-    return trace?TRUE:FALSE;
+    if(gobj->__trace_generation__ != __trace_generation__) {
+        refresh_trace_masks(gobj);
+    }
+    return (gobj->__trace_flags__ & TRACE_FLAG_MACHINE_TRACING)?TRUE:FALSE;
 }
 
 /***************************************************************************
@@ -12442,16 +16278,13 @@ PRIVATE inline BOOL is_machine_tracing(GObj_t * gobj)
  ***************************************************************************/
 PRIVATE inline BOOL is_machine_not_tracing(GObj_t * gobj)
 {
-    if(abs(__deep_trace__) > 1 || __panic_trace__) {
-        return FALSE;
-    }
     if(!gobj) {
-        return TRUE;
+        return (abs(__deep_trace__) > 1 || __panic_trace__)?FALSE:TRUE;
     }
-    int no_trace = gobj->__gobj_no_trace_level__ & TRACE_MACHINE ||
-        gobj->gclass->__gclass_no_trace_level__ & TRACE_MACHINE;
-
-    return no_trace?TRUE:FALSE;
+    if(gobj->__trace_generation__ != __trace_generation__) {
+        refresh_trace_masks(gobj);
+    }
+    return (gobj->__trace_flags__ & TRACE_FLAG_MACHINE_NOT_TRACING)?TRUE:FALSE;
 }
 
 /****************************************************************************
@@ -12470,11 +16303,14 @@ PRIVATE char *tab(char *bf, int bflen)
     return bf;
 }
 
+#endif
+
 /****************************************************************************
  *  Trace machine function
  ****************************************************************************/
 PUBLIC void trace_machine(const char *fmt, ...)
 {
+#ifndef NOT_INCLUDE_TRACING
     va_list ap;
     char bf[4*1024];
     tab(bf, sizeof(bf));
@@ -12485,6 +16321,7 @@ PUBLIC void trace_machine(const char *fmt, ...)
     va_end(ap);
 
     trace_msg("%s", bf);
+#endif
 }
 
 
@@ -12678,6 +16515,7 @@ PUBLIC const sdata_desc_t *gobj_get_global_authz_table(void)
  *  and then use a reliable udp protocol to another host.
  */
 
+#ifndef NOT_INCLUDE_TRACING
 /***************************************************************************
  *
  ***************************************************************************/
@@ -12837,6 +16675,7 @@ PRIVATE void monitor_state(GObj_t *gobj)
         NULL
     );
 }
+#endif
 
 
 
@@ -12981,6 +16820,286 @@ PUBLIC json_t *gobj_jn_stats(hgobj gobj)
     return ((GObj_t *)gobj)->jn_stats;
 }
 
+/***************************************************************************
+ *  Bucket of latency
+ ***************************************************************************/
+PRIVATE inline int latency_bucket(uint64_t ns)
+{
+    if(ns < LATENCY_SUB_COUNT) {
+        return (int)ns;
+    }
+    if(ns >= ((uint64_t)1 << LATENCY_MAX_EXP)) {
+        ns = ((uint64_t)1 << LATENCY_MAX_EXP) - 1;
+    }
+    int e = 63 - __builtin_clzll(ns);
+    int group = e - LATENCY_SUB_BITS + 1;
+    int sub = (int)((ns >> (e - LATENCY_SUB_BITS)) & (LATENCY_SUB_COUNT - 1));
+    return group * LATENCY_SUB_COUNT + sub;
+}
+
+/***************************************************************************
+ *  Highest value of bucket
+ ***************************************************************************/
+PRIVATE uint64_t latency_bucket_value(int bucket)
+{
+    if(bucket < LATENCY_SUB_COUNT) {
+        return bucket;
+    }
+    int group = bucket / LATENCY_SUB_COUNT;
+    int sub = bucket % LATENCY_SUB_COUNT;
+    int e = group + LATENCY_SUB_BITS - 1;
+    uint64_t width = (uint64_t)1 << (e - LATENCY_SUB_BITS);
+    return ((uint64_t)1 << e) + sub * width + width - 1;
+}
+
+/***************************************************************************
+ *  Record the latency of an action
+ ***************************************************************************/
+PRIVATE void record_action_latency(fsm_table_t *fsm_table, fsm_cell_t *cell, uint64_t ns)
+{
+    int n_cells = fsm_table->n_states * fsm_table->n_events;
+    if(!fsm_table->latency) {
+        fsm_table->latency = gbmem_malloc(sizeof(latency_histogram_t *) * n_cells);
+        if(!fsm_table->latency) {
+            return;
+        }
+    }
+    int idx = cell - fsm_table->cells;
+    latency_histogram_t *histogram = fsm_table->latency[idx];
+    if(!histogram) {
+        histogram = gbmem_malloc(sizeof(latency_histogram_t));
+        if(!histogram) {
+            return;
+        }
+        fsm_table->latency[idx] = histogram;
+    }
+    histogram->count++;
+    if(ns > histogram->max_ns) {
+        histogram->max_ns = ns;
+    }
+    histogram->buckets[latency_bucket(ns)]++;
+}
+
+/***************************************************************************
+ *  Value of the percentile
+ ***************************************************************************/
+PRIVATE uint64_t latency_percentile(latency_histogram_t *histogram, double percentile)
+{
+    uint64_t rank = (uint64_t)(percentile * histogram->count / 100.0 + 0.5);
+    if(rank < 1) {
+        rank = 1;
+    }
+    uint64_t acc = 0;
+    for(int i=0; i<LATENCY_BUCKETS; i++) {
+        acc += histogram->buckets[i];
+        if(acc >= rank) {
+            uint64_t value = latency_bucket_value(i);
+            return (value > histogram->max_ns)? histogram->max_ns : value;
+        }
+    }
+    return histogram->max_ns;
+}
+
+/***************************************************************************
+ *  Enable/disable the measure of action latencies
+ ***************************************************************************/
+PUBLIC void gobj_set_action_latency_stats(BOOL enable)
+{
+    __action_latency_enabled__ = enable;
+}
+
+/***************************************************************************
+ *  Return if the measure of action latencies is enabled
+ ***************************************************************************/
+PUBLIC BOOL gobj_action_latency_stats_enabled(void)
+{
+    return __action_latency_enabled__;
+}
+
+/***************************************************************************
+ *  Reset the histograms of action latencies
+ ***************************************************************************/
+PUBLIC void gobj_reset_action_latency_stats(void)
+{
+    gclass_register_t *gclass_reg = dl_first(&dl_gclass);
+    while(gclass_reg) {
+        fsm_table_t *fsm_table = gclass_reg->gclass->__fsm_table__;
+        if(fsm_table && fsm_table->latency) {
+            for(int i=0; i<fsm_table->n_states * fsm_table->n_events; i++) {
+                GBMEM_FREE(fsm_table->latency[i]);
+            }
+        }
+        gclass_reg = dl_next(gclass_reg);
+    }
+}
+
+/***************************************************************************
+ *  Return a list with the action latencies (nanoseconds)
+ *  [{gclass, state, event, count, p50, p99, p999, max}]
+ ***************************************************************************/
+PUBLIC json_t *gobj_action_latency_stats(const char *gclass_name)
+{
+    json_t *jn_list = json_array();
+
+    gclass_register_t *gclass_reg = dl_first(&dl_gclass);
+    while(gclass_reg) {
+        GCLASS *gclass = gclass_reg->gclass;
+        fsm_table_t *fsm_table = gclass->__fsm_table__;
+        if(!fsm_table || !fsm_table->latency) {
+            gclass_reg = dl_next(gclass_reg);
+            continue;
+        }
+        if(!empty_string(gclass_name) && strcasecmp(gclass_name, gclass->gclass_name)!=0) {
+            gclass_reg = dl_next(gclass_reg);
+            continue;
+        }
+        for(int st=0; st<fsm_table->n_states; st++) {
+            for(int ev=0; ev<fsm_table->n_events; ev++) {
+                latency_histogram_t *histogram = fsm_table->latency[st * fsm_table->n_events + ev];
+                if(!histogram || !histogram->count) {
+                    continue;
+                }
+                json_array_append_new(
+                    jn_list,
+                    json_pack("{s:s, s:s, s:s, s:I, s:I, s:I, s:I, s:I}",
+                        "gclass", gclass->gclass_name,
+                        "state", fsm_table->fsm->state_names[st],
+                        "event", fsm_table->fsm->input_events[ev].event,
+                        "count", (json_int_t)histogram->count,
+                        "p50", (json_int_t)latency_percentile(histogram, 50),
+                        "p99", (json_int_t)latency_percentile(histogram, 99),
+                        "p999", (json_int_t)latency_percentile(histogram, 99.9),
+                        "max", (json_int_t)histogram->max_ns
+                    )
+                );
+            }
+        }
+        gclass_reg = dl_next(gclass_reg);
+    }
+    return jn_list;
+}
+
+
+/***************************************************************************
+ *  Return the publish stats of the event, created if not exist.
+ *  Open addressing by event atom, like the subscriptions index.
+ ***************************************************************************/
+PRIVATE publish_stats_t *publish_stats_get(GObj_t *publisher, event_id_t event_id)
+{
+    if(!event_id) {
+        return 0;
+    }
+    uint32_t i;
+    if(publisher->publish_stats) {
+        i = event_atom_hash(event_id) & publisher->publish_stats_mask;
+        while(publisher->publish_stats[i].event_id) {
+            if(publisher->publish_stats[i].event_id == event_id) {
+                return &publisher->publish_stats[i];
+            }
+            i = (i + 1) & publisher->publish_stats_mask;
+        }
+    }
+
+    uint32_t size = publisher->publish_stats? publisher->publish_stats_mask + 1 : 0;
+    if((publisher->n_publish_stats + 1) * 2 > size) {
+        uint32_t new_size = size? size * 2 : 8;
+        publish_stats_t *new_stats = gbmem_malloc(sizeof(publish_stats_t) * new_size);
+        if(!new_stats) {
+            return 0;
+        }
+        for(uint32_t j=0; j<size; j++) {
+            publish_stats_t *stats = &publisher->publish_stats[j];
+            if(stats->event_id) {
+                uint32_t k = event_atom_hash(stats->event_id) & (new_size - 1);
+                while(new_stats[k].event_id) {
+                    k = (k + 1) & (new_size - 1);
+                }
+                new_stats[k] = *stats;
+            }
+        }
+        GBMEM_FREE(publisher->publish_stats);
+        publisher->publish_stats = new_stats;
+        publisher->publish_stats_mask = new_size - 1;
+    }
+
+    i = event_atom_hash(event_id) & publisher->publish_stats_mask;
+    while(publisher->publish_stats[i].event_id) {
+        i = (i + 1) & publisher->publish_stats_mask;
+    }
+    publish_stats_t *stats = &publisher->publish_stats[i];
+    memset(stats, 0, sizeof(publish_stats_t));
+    stats->event_id = event_id;
+    publisher->n_publish_stats++;
+    return stats;
+}
+
+/***************************************************************************
+ *  Enable/disable the publish stats
+ ***************************************************************************/
+PUBLIC void gobj_set_publish_stats(BOOL enable)
+{
+    __publish_stats_enabled__ = enable;
+}
+
+/***************************************************************************
+ *  Return if the publish stats are enabled
+ ***************************************************************************/
+PUBLIC BOOL gobj_publish_stats_enabled(void)
+{
+    return __publish_stats_enabled__;
+}
+
+/***************************************************************************
+ *  Reset the publish stats of the publisher
+ ***************************************************************************/
+PUBLIC void gobj_reset_publish_stats(hgobj publisher_)
+{
+    GObj_t *publisher = publisher_;
+    if(publisher && publisher->publish_stats) {
+        memset(
+            publisher->publish_stats,
+            0,
+            sizeof(publish_stats_t) * (publisher->publish_stats_mask + 1)
+        );
+        publisher->n_publish_stats = 0;
+    }
+}
+
+/***************************************************************************
+ *  Return a list with the publish stats of the publisher
+ *  [{event, publications, skipped, matched, filtered, deliveries, queued, copies, owned, time_ns}]
+ ***************************************************************************/
+PUBLIC json_t *gobj_publish_stats(hgobj publisher_)
+{
+    GObj_t *publisher = publisher_;
+    json_t *jn_list = json_array();
+    if(!publisher) {
+        return jn_list;
+    }
+
+    for(uint32_t i=0; publisher->publish_stats && i<=publisher->publish_stats_mask; i++) {
+        publish_stats_t *stats = &publisher->publish_stats[i];
+        if(!stats->event_id) {
+            continue;
+        }
+        json_array_append_new(
+            jn_list,
+            json_pack("{s:s, s:I, s:I, s:I, s:I, s:I, s:I, s:I, s:I, s:I}",
+                "event", gobj_event_atom_name(stats->event_id),
+                "publications", (json_int_t)stats->publications,
+                "skipped", (json_int_t)stats->skipped,
+                "matched", (json_int_t)stats->matched,
+                "filtered", (json_int_t)stats->filtered,
+                "deliveries", (json_int_t)stats->deliveries,
+                "queued", (json_int_t)stats->queued,
+                "copies", (json_int_t)stats->copies,
+                "owned", (json_int_t)stats->owned,
+                "time_ns", (json_int_t)stats->time_ns
+            )
+        );
+    }
+    return jn_list;
+}
 
 
 
@@ -127,6 +127,13 @@ typedef struct {
     const char *description;
 } EVENT;
 
+/*
+ *  Event atom: the event name interned as a small integer.
+ *  Names are case-insensitive: "EV_TIMEOUT" and "ev_timeout" have the same atom.
+ *  0 is not a valid atom.
+ */
+typedef uint32_t event_id_t;
+
 typedef struct {
     const EVENT *input_events;    //const char **event_names;
     const EVENT *output_events;   //const char **output_event_list;
@@ -134,6 +141,14 @@ typedef struct {
     EV_ACTION **states;
 } FSM;
 
+/*
+ *  Specialized dispatcher of a FSM, generated by ginsfsm_fsmgen.
+ *  Return the EV_ACTION of `event` (index in input_events) in `state` (index in state_names),
+ *  or NULL if the event is not accepted in the state.
+ *  Set *next_state to the index of next state, -1 if none.
+ */
+typedef const EV_ACTION *(*fsm_dispatcher_fn)(int state, int event, int *next_state);
+
 typedef int   (*mt_start_fn)(hgobj gobj);
 typedef int   (*mt_stop_fn)(hgobj gobj);
 typedef int   (*mt_play_fn)(hgobj gobj);
@@ -419,6 +434,8 @@ typedef struct _GCLASS {
     uint32_t __gclass_no_trace_level__;
     BOOL fsm_checked;
     json_t *__jn_trace_filter__;
+    void *__fsm_table__;        // compiled state x event dispatch table, built by smachine_check()
+    fsm_dispatcher_fn __fsm_dispatcher__; // set by gobj_set_fsm_dispatcher()
 } GCLASS;
 
 
@@ -466,6 +483,11 @@ PUBLIC hgobj gobj_yuno_factory(
     json_t *jn_yuno_settings // own
 );
 PUBLIC int gobj_register_gclass(GCLASS *gclass);
+/*
+ *  Use a dispatcher generated by ginsfsm_fsmgen instead of the tables walk.
+ *  It's verified against the gclass's fsm, ignored (and logged) if it doesn't match.
+ */
+PUBLIC int gobj_set_fsm_dispatcher(GCLASS *gclass, fsm_dispatcher_fn dispatcher);
 PUBLIC GCLASS * gobj_find_gclass(const char *gclass_name, BOOL verbose);
 PUBLIC int gobj_walk_gclass_list(
     int (*cb_walking)(GCLASS *gclass, void *user_data),
@@ -1049,12 +1071,15 @@ PUBLIC dl_list_t *gobj_filter_childs_by_re_name(dl_list_t *dl_childs, const char
  *      gobj_subscribe_event()
  *      gobj_unsubscribe_event()
  *
+ *  The subscription hsdata is a read-only view of the native subscription record:
+ *  only mt_subscription_added() can write it, after that the writes are rejected.
+ *
 
 SDATA Schema of subs (subscription)
 ===================================
 "publisher":            (pointer)int    // publisher gobj
 "subscriber:            (pointer)int    // subscriber gobj
-"event":                str             // event name subscribed
+"event":                str             // event name or pattern subscribed
 "rename_event_name":    str             // publish with other event name
 "subs_flag":            int             // subscription flag. See subs_flag
 "__config__":           json            // subscription config.
@@ -1090,9 +1115,30 @@ Possible values for config arguments:
     Use the same kw to all publications. This let subscribers modify the same kw.
     If not __share_kw__ then each publication receives a twin of kw.
 
+* "__cow_kw__": bool
+    Copy-on-write: the subscriber receives the publisher's kw, shared and READ-ONLY.
+    The kw is twined only when the publication has to change it:
+    __local__, __global__ or __trans_filter__ in the subscription,
+    or the subscriber's input event is EVF_KW_WRITING.
+    The publisher can set `__cow_kw__` in kw for all subscriptions, like `__share_kw__`.
+    Ignored if the publisher's gclass has mt_publication_filter (each publication is twined).
+
 * "__trans_filter__": string or string's list
     Transform kw to publish with transformation filters
 
+* "__coalesce_ms__": int
+    Coalescing window in milliseconds: within the window only the latest kw
+    (by event) is kept and delivered once at the end of the window.
+
+* "__max_rate__": real
+    Maximum deliveries by second: a publication is delivered at once
+    if the interval is elapsed, else it's coalesced until the interval ends.
+    With __coalesce_ms__ the greater interval is used.
+    The coalesced deliveries use libuv timers of the core, created with the first
+    publication: they require gobj_start_event_queue() (without it the publications
+    are sent at once, logging an error); __own_event__ has no effect on them.
+    The coalesced publications are not counted in the return of gobj_publish_event().
+
 * "__own_event__": bool
     If __own_event__ defined and gobj_send_event inside of gobj_publish_event return -1 don't continue publishing
 
@@ -1111,6 +1157,8 @@ HACK Only these four subdictionaries keys are let, remain of keywords will be ig
 
     __filter__  Selection Filter: Enable to publish only messages matching the filter.
                 Used by gobj_publish_event().
+                It's compiled at subscribe time (kw_match_simple() semantic),
+                a custom selection filter function uses the json filter.
 
 
 */
@@ -1121,6 +1169,7 @@ typedef enum {
     __first_shot__          = 0x00000004,
     __share_kw__            = 0x00000008,   // Don't twin kw, use the same.
     __own_event__           = 0x00000010,   // If gobj_send_event return -1 don't continue publishing
+    __cow_kw__              = 0x00000020,   // Share kw, twin it only if the publication changes it
 } subs_flag_t;
 
 
@@ -1162,6 +1211,14 @@ PUBLIC dl_list_t *gobj_find_subscribings(
     hgobj publisher
 );
 
+/*
+ *  The event can be:
+ *      - an event name
+ *      - empty or "*": all events (catch-all)
+ *      - a pattern: prefix ("EV_TRACK_*") or glob ('*' any sequence, '?' any char),
+ *        case-insensitive. Matched with a trie of the publisher, keyed by the
+ *        literal prefix of the patterns. Unsubscribe with the same pattern.
+ */
 PUBLIC hsdata gobj_subscribe_event( // Idempotent function
     hgobj publisher,
     const char *event,
@@ -1174,9 +1231,30 @@ PUBLIC int gobj_unsubscribe_event(
     json_t *kw, // kw (__config__, __global__, __local__, __filter__)
     hgobj subscriber
 );
+/*
+ *  Unsubscribe by handle (the hsdata returned by gobj_subscribe_event()),
+ *  O(1): the hsdata points to its native record (sdata user_data),
+ *  and the record is unlinked from the doubly linked identity hash chain.
+ */
 PUBLIC int gobj_unsubscribe_event2(
     hsdata subs
 );
+/*
+ *  Bulk subscription management, events is a null terminated list.
+ *  The same kw is used for all the events (kw owned).
+ */
+PUBLIC int gobj_subscribe_events( // Return the number of subscriptions done
+    hgobj publisher,
+    const char **events,
+    json_t *kw, // kw (__config__, __global__, __local__, __filter__)
+    hgobj subscriber
+);
+PUBLIC int gobj_unsubscribe_events( // Return 0, -1 if some error
+    hgobj publisher,
+    const char **events,
+    json_t *kw, // kw (__config__, __global__, __local__, __filter__)
+    hgobj subscriber
+);
 PUBLIC int gobj_unsubscribe_list(
     dl_list_t *dl_subs, // iter of subscription hsdata
     BOOL free_iter,
@@ -1185,7 +1263,7 @@ PUBLIC int gobj_unsubscribe_list(
 
 /*
  *  Set funtion to be applied in Selection Filter __filter__
- *  Default is kw_match_simple()
+ *  Default is kw_match_simple(), evaluated with the compiled __filter__
  *  Return old function
  */
 PUBLIC kw_match_fn gobj_set_publication_selection_filter_fn(kw_match_fn kw_match);
@@ -1222,7 +1300,8 @@ PUBLIC int gobj_add_publication_transformation_filter_fn(
  *      if return <= 0 return (all publishing process done by gclass)
  *      if return >0 continue with publishing process of gobj.c
  *
- *  2) LOOP over subscriptions:
+ *  2) LOOP over subscriptions of the event and catch-all subscriptions (empty event),
+ *     in subscription order (subscriptions are indexed by event in the publisher):
  *      1) Pre-filter: If publisher gclass has mt_publication_pre_filter call it (before KW filling)
  *          kw NOT owned! you can modify the publishing kw
  *          Return:
@@ -1233,6 +1312,8 @@ PUBLIC int gobj_add_publication_transformation_filter_fn(
  *      2) Check renamed_event
  *      3) Duplicate the kw to publish if not shared (subscription flag ``__share_kw__``)
  *          New: if kw has `__share_kw__` (set by publisher) then share the kw to all subscribers
+ *          Copy-on-write (subscription flag or kw key ``__cow_kw__``): share the kw,
+ *          and twin it before KW filling only if it has to be changed (see __cow_kw__)
  *      4) Filter with filter if either not null:
  *          - call publisher mt_publication_filter() method or
  *          - filter with subscription parameter ``__filter__`` (kw_match_simple())
@@ -1244,9 +1325,9 @@ PUBLIC int gobj_add_publication_transformation_filter_fn(
  *      5) Check if System event: don't send if subscriber has not it
  *          ev->flag & EVF_SYSTEM_EVENT
  *
- *      6) KW filling
+ *      6) KW filling, with the publish plan resolved at subscribe time
  *          - Remove local keys (defined in __local__)
- *          - Apply transformation filters (defined in __trans_filter__ and calling apply_trans_filters())
+ *          - Apply transformation filters (defined in __trans_filter__)
  *          - Add global keys (defined in __global__)
  *
  *      7) Publish (gobj_send_event to subscriber)
@@ -1265,6 +1346,106 @@ PUBLIC int gobj_send_event(
     json_t *kw,
     hgobj src
 );
+
+/*
+ *  Event atoms.
+ *  The input and output events of gclasses are interned when they are registered.
+ *  gobj_event_atom() interns the name if it doesn't exist yet, and return his atom.
+ *  gobj_find_event_atom() only searchs, return 0 if the name is not interned.
+ *  Atoms are valid until gobj_end().
+ */
+PUBLIC event_id_t gobj_event_atom(const char *event);
+PUBLIC event_id_t gobj_find_event_atom(const char *event);
+PUBLIC const char *gobj_event_atom_name(event_id_t event_id);
+
+/*
+ *  Same as gobj_publish_event() and gobj_send_event() but with the event atom,
+ *  without string comparisons to locate the event.
+ *  The action receives the event name as it's written in the gclass's input_events.
+ */
+PUBLIC int gobj_publish_event_id(
+    hgobj publisher,
+    event_id_t event_id,
+    json_t *kw
+);
+PUBLIC int gobj_send_event_id(
+    hgobj dst,
+    event_id_t event_id,
+    json_t *kw,
+    hgobj src
+);
+/*
+ *  Run-to-completion event queue of the yuno.
+ *
+ *  gobj_post_event() enqueues the event, it will be sent with gobj_send_event()
+ *  in posting order, never inside the current dispatch:
+ *  the queue is drained in the check phase of the next loop iteration
+ *  (the loop doesn't block in poll while there are posted events),
+ *  in batches, with a maximum of events and a maximum of time by loop iteration.
+ *  The yuno must call gobj_start_event_queue() with his loop.
+ *  The handles of the queue don't keep the loop alive (uv_unref),
+ *  except while there are posted events.
+ *  Without loop the queue can be drained with gobj_drain_event_queue().
+ *  After gobj_stop_event_queue() the loop must run (to close the handles)
+ *  before gobj_start_event_queue() can start it again, else it returns -1.
+ *
+ *  Events posted to a gobj that is destroyed before the delivery are discarded.
+ */
+PUBLIC int gobj_post_event( // Return 0 if enqueued, < 0 if error (kw is decref)
+    hgobj dst,
+    const char *event,
+    json_t *kw,
+    hgobj src
+);
+PUBLIC int gobj_start_event_queue(uv_loop_t *loop);
+PUBLIC void gobj_stop_event_queue(void);
+PUBLIC void gobj_set_event_queue_limits( // 0 keeps the current value. Default: 1024 events, 5000 us
+    uint32_t batch_size,
+    uint32_t max_drain_us
+);
+PUBLIC int gobj_drain_event_queue(void); // Return the number of events sent
+PUBLIC uint32_t gobj_event_queue_size(void);
+
+/*
+ *  Publish with asynchronous fan-out.
+ *  Same matching as gobj_publish_event() (pre-filter, filters, publish plan),
+ *  done now over the current subscriptions, but the deliveries are posted
+ *  with gobj_post_event() and the function returns without running
+ *  the subscribers actions.
+ *  Deliveries to a subscriber destroyed before the delivery are discarded,
+ *  __own_event__ has no effect (the return of the subscriber is not known).
+ *  Without gobj_start_event_queue() it's a gobj_publish_event():
+ *  the deliveries are sent now (and its return is that of gobj_publish_event()).
+ */
+PUBLIC int gobj_publish_event_async( // Return the number of posted events (>=0)
+    hgobj publisher,
+    const char *event,
+    json_t *kw
+);
+
+/*
+ *  Send event from a foreign thread (the only thread-safe function of gobj).
+ *  The event is pushed in a lock-free mailbox of the yuno,
+ *  the yuno's loop is woken up once by batch (coalesced uv_async_send())
+ *  and it sends the events with gobj_send_event(), in order by producer, with src NULL.
+ *  Requires gobj_start_event_queue(), else return -1.
+ *  The kw is a json string (or NULL), parsed in the yuno's thread:
+ *  don't build json_t in the foreign thread, jansson allocates with gbmem
+ *  and gbmem is not thread-safe. A kw that is not a valid json discards the event.
+ *  The dst is identified by its pointer and its gobj_instance_id(),
+ *  both got in the yuno's thread before handing them to the foreign thread.
+ *  Events to a gobj destroyed before the delivery are discarded,
+ *  even if another gobj is created later at the same address.
+ *  gobj_stop_event_queue() rejects new events and waits for the producers inside the call.
+ */
+PUBLIC uint64_t gobj_instance_id(hgobj gobj); // unique in the yuno, never reused
+PUBLIC int gobj_send_event_from_thread(
+    hgobj dst,
+    uint64_t dst_instance_id,
+    const char *event,
+    const char *kw  // json string, not owned, can be NULL
+);
+
 PUBLIC int gobj_send_event_to_gclass_instances(
     hgobj gobj,
     const char *gclass_name,
@@ -1430,6 +1611,48 @@ PUBLIC int gobj_update_writable_attrs( // with authz
 );
 PUBLIC int gobj_reset_volatil_attrs(hgobj gobj); // Reset SDF_VOLATIL attrs (to their default values)
 
+/*-------------------------------------------------------*
+ *  Attribute handles
+ *  Resolve the attribute name once (with bottom inheritance),
+ *  then read/write without name lookup.
+ *  The handle is valid while the owner gobj lives
+ *  and its bottom chain doesn't change. Resolve it again in other case.
+ *  The write functions will cause mt_writing() call.
+ *  The type checks are those of sdata_read_*() and sdata_write_*().
+ *  The pseudo-attributes (__state__, __disabled__, __running__, __playing__, __service__)
+ *  have no handle.
+ *-------------------------------------------------------*/
+typedef struct {
+    hgobj gobj;                 // Owner of the attribute, the gobj or one of its bottoms
+    hsdata hs;
+    const sdata_desc_t *it;
+    void *ptr;                  // Pointer to the value in the sdata buffer
+} gobj_attr_handle_t;
+
+PUBLIC int gobj_attr_handle(hgobj gobj, const char *name, gobj_attr_handle_t *handle);
+
+PUBLIC const char *gobj_read_str_by_handle(const gobj_attr_handle_t *handle);
+PUBLIC BOOL gobj_read_bool_by_handle(const gobj_attr_handle_t *handle);
+PUBLIC int32_t gobj_read_int32_by_handle(const gobj_attr_handle_t *handle);
+PUBLIC uint32_t gobj_read_uint32_by_handle(const gobj_attr_handle_t *handle);
+PUBLIC int64_t gobj_read_int64_by_handle(const gobj_attr_handle_t *handle);
+PUBLIC uint64_t gobj_read_uint64_by_handle(const gobj_attr_handle_t *handle);
+PUBLIC uint64_t gobj_read_integer_by_handle(const gobj_attr_handle_t *handle);
+PUBLIC double gobj_read_real_by_handle(const gobj_attr_handle_t *handle);
+PUBLIC json_t *gobj_read_json_by_handle(const gobj_attr_handle_t *handle); // WARNING not incref, it's not your own.
+PUBLIC void *gobj_read_pointer_by_handle(const gobj_attr_handle_t *handle);
+
+PUBLIC int gobj_write_str_by_handle(const gobj_attr_handle_t *handle, const char *value);
+PUBLIC int gobj_write_bool_by_handle(const gobj_attr_handle_t *handle, BOOL value);
+PUBLIC int gobj_write_int32_by_handle(const gobj_attr_handle_t *handle, int32_t value);
+PUBLIC int gobj_write_uint32_by_handle(const gobj_attr_handle_t *handle, uint32_t value);
+PUBLIC int gobj_write_int64_by_handle(const gobj_attr_handle_t *handle, int64_t value);
+PUBLIC int gobj_write_uint64_by_handle(const gobj_attr_handle_t *handle, uint64_t value);
+PUBLIC int gobj_write_integer_by_handle(const gobj_attr_handle_t *handle, uint64_t value);
+PUBLIC int gobj_write_real_by_handle(const gobj_attr_handle_t *handle, double value);
+PUBLIC int gobj_write_json_by_handle(const gobj_attr_handle_t *handle, json_t *value); // WARNING json is incref
+PUBLIC int gobj_write_pointer_by_handle(const gobj_attr_handle_t *handle, void *value);
+
 /*--------------------------------------------*
  *  Info functions
  *--------------------------------------------*/
@@ -1469,6 +1692,28 @@ PUBLIC BOOL gobj_typeof_subgclass(hgobj gobj, const char *gclass_name);
 PUBLIC BOOL gobj_typeof_inherited_gclass(hgobj gobj, const char *gclass_name);  /* check inherited (bottom) gclass */
 
 PUBLIC BOOL gobj_change_state(hgobj gobj, const char *new_state);
+
+/*
+ *  Lightweight state listener: called in every state change with
+ *  the indexes (in fsm's state_names) of previous and current state.
+ *  No json is built, no event is published.
+ */
+typedef void (*gobj_state_listener_fn)(
+    hgobj gobj,
+    int previous_state,
+    int current_state,
+    void *user_data
+);
+PUBLIC int gobj_add_state_listener(
+    hgobj gobj,
+    gobj_state_listener_fn cb,
+    void *user_data
+);
+PUBLIC int gobj_remove_state_listener(
+    hgobj gobj,
+    gobj_state_listener_fn cb,
+    void *user_data
+);
 PUBLIC const char *gobj_current_state(hgobj gobj);
 PUBLIC const char *gobj_last_state(hgobj gobj);
 PUBLIC BOOL gobj_in_this_state(hgobj gobj, const char *state);
@@ -1548,6 +1793,45 @@ PUBLIC json_t * gobj_stats( // Call mt_stats() or build_stats()
     hgobj src
 );
 
+/*
+ *  Latency of actions, by gclass, state and event.
+ *  When enabled, gobj_send_event() times every action with a monotonic clock
+ *  and records it in a log-linear histogram.
+ *  When disabled, the cost is a branch.
+ *
+ *  gobj_action_latency_stats() returns a list (nanoseconds):
+ *      [{gclass, state, event, count, p50, p99, p999, max}]
+ *  filtered by gclass_name if not empty.
+ *
+ *  It's available too as global stats of any gobj:
+ *      gobj_stats(gobj, "__action_latency__", {gclass_name:s, reset:b}, src)
+ */
+PUBLIC void gobj_set_action_latency_stats(BOOL enable);
+PUBLIC BOOL gobj_action_latency_stats_enabled(void);
+PUBLIC void gobj_reset_action_latency_stats(void);
+PUBLIC json_t *gobj_action_latency_stats(const char *gclass_name);
+
+/*
+ *  Publish stats, by publisher and event.
+ *  When enabled, gobj_publish_event() counts:
+ *      publications, skipped (not published by mt_publish_event),
+ *      matched subscriptions, filtered (pre-filter or filter),
+ *      deliveries (sent), queued (posted by gobj_publish_event_async() or coalesced),
+ *      copies of kw, owned (__own_event__ short-circuits)
+ *      and the time spent (nanoseconds).
+ *  When disabled, the cost is a branch.
+ *
+ *  gobj_publish_stats() returns a list:
+ *      [{event, publications, skipped, matched, filtered, deliveries, queued, copies, owned, time_ns}]
+ *
+ *  It's available too as stats of the publisher:
+ *      gobj_stats(gobj, "__publish_stats__", {reset:b}, src)
+ */
+PUBLIC void gobj_set_publish_stats(BOOL enable);
+PUBLIC BOOL gobj_publish_stats_enabled(void);
+PUBLIC void gobj_reset_publish_stats(hgobj publisher);
+PUBLIC json_t *gobj_publish_stats(hgobj publisher);
+
 
 /*
  *  Set stats, path relative to gobj, including the attribute
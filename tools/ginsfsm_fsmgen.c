@@ -0,0 +1,666 @@
+/***********************************************************************
+ *          GINSFSM_FSMGEN.C
+ *
+ *          FSM-to-C code generator.
+ *
+ *          Read the source of a gclass, locate his FSM
+ *          (input_events, state_names and the EV_ACTION tables),
+ *          and write a specialized dispatcher: a `switch` on the
+ *          state index and the input event index.
+ *
+ *          The generated code must be included in the gclass source,
+ *          after the FSM definition, and registered before creating gobjs:
+ *              gobj_set_fsm_dispatcher(&_gclass, <name>);
+ *
+ *          The dispatcher returns the same EV_ACTION (and next state)
+ *          that gobj_send_event() would find walking the tables.
+ *          The core verifies it when compiling the fsm,
+ *          and ignores the dispatcher if they don't match.
+ *
+ *          Usage: ginsfsm_fsmgen [-f fsm] [-n name] [-o output] gclass.c
+ *              -f fsm      name of the FSM variable (default the first FSM found)
+ *              -n name     name of dispatcher function (default <fsm>_dispatcher)
+ *              -o output   output file (default stdout)
+ *
+ *          Events and states must be string literals
+ *          or #define's of string literals.
+ *
+ *          Copyright (c) 2026 Niyamaka.
+ *          All Rights Reserved.
+ ***********************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#ifndef PRIVATE
+  #define PRIVATE static
+#endif
+
+/***************************************************************
+ *              Structures
+ ***************************************************************/
+typedef enum {
+    TK_END = 0,
+    TK_IDENT,
+    TK_STRING,
+    TK_NUMBER,
+    TK_PUNCT,
+} token_type_t;
+
+typedef struct {
+    token_type_t type;
+    char *text;         // string literals without quotes
+    int line;
+} token_t;
+
+typedef struct {
+    char *name;
+    char *value;        // NAME of #define NAME "value"
+} define_t;
+
+typedef struct {
+    const char *event;      // resolved event name
+    const char *action;     // action function or 0
+    const char *next_state; // resolved next state or 0
+} action_t;
+
+typedef struct {
+    const char *array;      // name of EV_ACTION array
+    action_t *actions;
+    int n_actions;
+} state_t;
+
+/***************************************************************
+ *              Data
+ ***************************************************************/
+PRIVATE const char *filename = "";
+PRIVATE token_t *tokens = 0;
+PRIVATE int n_tokens = 0;
+PRIVATE define_t *defines = 0;
+PRIVATE int n_defines = 0;
+
+/***************************************************************************
+ *  Exit with error
+ ***************************************************************************/
+PRIVATE void die(int line, const char *msg, const char *arg)
+{
+    if(line > 0) {
+        fprintf(stderr, "%s:%d: ERROR %s%s%s\n", filename, line, msg, arg?": ":"", arg?arg:"");
+    } else {
+        fprintf(stderr, "%s: ERROR %s%s%s\n", filename, msg, arg?": ":"", arg?arg:"");
+    }
+    exit(-1);
+}
+
+/***************************************************************************
+ *  Alloc or die
+ ***************************************************************************/
+PRIVATE void *xrealloc(void *p, size_t size)
+{
+    p = realloc(p, size);
+    if(!p) {
+        die(0, "no memory", 0);
+    }
+    return p;
+}
+
+PRIVATE char *xstrndup(const char *s, size_t len)
+{
+    char *p = xrealloc(0, len + 1);
+    memcpy(p, s, len);
+    p[len] = 0;
+    return p;
+}
+
+/***************************************************************************
+ *  Add token
+ ***************************************************************************/
+PRIVATE void add_token(token_type_t type, const char *s, size_t len, int line)
+{
+    if((n_tokens % 1024) == 0) {
+        tokens = xrealloc(tokens, sizeof(token_t) * (n_tokens + 1024 + 1));
+    }
+    tokens[n_tokens].type = type;
+    tokens[n_tokens].text = xstrndup(s, len);
+    tokens[n_tokens].line = line;
+    n_tokens++;
+    tokens[n_tokens].type = TK_END;
+    tokens[n_tokens].text = "";
+    tokens[n_tokens].line = line;
+}
+
+/***************************************************************************
+ *  Get `#define NAME "value"`
+ ***************************************************************************/
+PRIVATE void parse_define(const char *p, const char *end)
+{
+    while(p < end && isspace((unsigned char)*p)) p++;
+    if(strncmp(p, "define", 6) != 0) {
+        return;
+    }
+    p += 6;
+    while(p < end && isspace((unsigned char)*p)) p++;
+    const char *name = p;
+    while(p < end && (isalnum((unsigned char)*p) || *p=='_')) p++;
+    size_t name_len = p - name;
+    if(!name_len || *p == '(') {
+        return;
+    }
+    while(p < end && isspace((unsigned char)*p)) p++;
+    if(*p != '"') {
+        return;
+    }
+    const char *value = ++p;
+    while(p < end && *p != '"') {
+        if(*p == '\\') p++;
+        p++;
+    }
+    if(p >= end) {
+        return;
+    }
+    defines = xrealloc(defines, sizeof(define_t) * (n_defines + 1));
+    defines[n_defines].name = xstrndup(name, name_len);
+    defines[n_defines].value = xstrndup(value, p - value);
+    n_defines++;
+}
+
+/***************************************************************************
+ *  Split the source in tokens, without comments and preprocessor lines
+ ***************************************************************************/
+PRIVATE void tokenize(const char *src)
+{
+    const char *p = src;
+    int line = 1;
+    int bol = 1;    // begin of line
+
+    while(*p) {
+        if(*p == '\n') {
+            line++;
+            bol = 1;
+            p++;
+            continue;
+        }
+        if(isspace((unsigned char)*p)) {
+            p++;
+            continue;
+        }
+        if(bol && *p == '#') {
+            const char *start = p + 1;
+            while(*p && !(*p == '\n' && *(p-1) != '\\')) {
+                if(*p == '\n') line++;
+                p++;
+            }
+            parse_define(start, p);
+            continue;
+        }
+        bol = 0;
+        if(p[0] == '/' && p[1] == '/') {
+            while(*p && *p != '\n') p++;
+            continue;
+        }
+        if(p[0] == '/' && p[1] == '*') {
+            p += 2;
+            while(*p && !(p[0] == '*' && p[1] == '/')) {
+                if(*p == '\n') line++;
+                p++;
+            }
+            if(*p) p += 2;
+            continue;
+        }
+        if(*p == '"') {
+            const char *start = ++p;
+            while(*p && *p != '"') {
+                if(*p == '\\' && p[1]) p++;
+                p++;
+            }
+            add_token(TK_STRING, start, p - start, line);
+            if(*p) p++;
+            continue;
+        }
+        if(*p == '\'') {
+            const char *start = p++;
+            while(*p && *p != '\'') {
+                if(*p == '\\' && p[1]) p++;
+                p++;
+            }
+            if(*p) p++;
+            add_token(TK_NUMBER, start, p - start, line);
+            continue;
+        }
+        if(isalpha((unsigned char)*p) || *p == '_') {
+            const char *start = p;
+            while(isalnum((unsigned char)*p) || *p == '_') p++;
+            add_token(TK_IDENT, start, p - start, line);
+            continue;
+        }
+        if(isdigit((unsigned char)*p)) {
+            const char *start = p;
+            while(isalnum((unsigned char)*p) || *p == '.') p++;
+            add_token(TK_NUMBER, start, p - start, line);
+            continue;
+        }
+        add_token(TK_PUNCT, p, 1, line);
+        p++;
+    }
+}
+
+/***************************************************************************
+ *  Is the token this punctuation?
+ ***************************************************************************/
+PRIVATE int is_punct(int i, char c)
+{
+    return tokens[i].type == TK_PUNCT && tokens[i].text[0] == c;
+}
+
+/***************************************************************************
+ *  Is the token a null (0, NULL)?
+ ***************************************************************************/
+PRIVATE int is_null(int i)
+{
+    return (tokens[i].type == TK_NUMBER && strcmp(tokens[i].text, "0")==0) ||
+        (tokens[i].type == TK_IDENT && strcmp(tokens[i].text, "NULL")==0);
+}
+
+/***************************************************************************
+ *  Resolve an event/state name: literal or #define of literal.
+ *  Return 0 if null
+ ***************************************************************************/
+PRIVATE const char *resolve_name(int i)
+{
+    if(is_null(i)) {
+        return 0;
+    }
+    if(tokens[i].type == TK_STRING) {
+        return tokens[i].text;
+    }
+    if(tokens[i].type == TK_IDENT) {
+        for(int d=n_defines-1; d>=0; d--) {
+            if(strcmp(defines[d].name, tokens[i].text)==0) {
+                return defines[d].value;
+            }
+        }
+    }
+    die(tokens[i].line, "event or state must be a string literal", tokens[i].text);
+    return 0;
+}
+
+/***************************************************************************
+ *  Find `name[] = {` or `name = {`, return the index of '{'
+ ***************************************************************************/
+PRIVATE int find_initializer(const char *name)
+{
+    for(int i=0; i<n_tokens; i++) {
+        if(tokens[i].type != TK_IDENT || strcmp(tokens[i].text, name)!=0) {
+            continue;
+        }
+        int j = i + 1;
+        if(is_punct(j, '[')) {
+            while(tokens[j].type != TK_END && !is_punct(j, ']')) j++;
+            j++;
+        }
+        if(is_punct(j, '=') && is_punct(j+1, '{')) {
+            return j + 1;
+        }
+    }
+    die(0, "initializer not found", name);
+    return -1;
+}
+
+/***************************************************************************
+ *  Return the index of the matching '}'
+ ***************************************************************************/
+PRIVATE int skip_braces(int i)
+{
+    int level = 0;
+    for(; tokens[i].type != TK_END; i++) {
+        if(is_punct(i, '{')) {
+            level++;
+        } else if(is_punct(i, '}')) {
+            level--;
+            if(level == 0) {
+                return i;
+            }
+        }
+    }
+    die(0, "unbalanced braces", 0);
+    return -1;
+}
+
+/***************************************************************************
+ *  Split a `{ a, b, c }` list: return the index of the first token
+ *  of each item (maximum max_items). Items end at ',' of the same level.
+ ***************************************************************************/
+PRIVATE int split_items(int open, int *items, int max_items)
+{
+    int close = skip_braces(open);
+    int n = 0;
+    int level = 0;
+    int start = open + 1;
+
+    for(int i=open+1; i<=close; i++) {
+        if(is_punct(i, '{') || is_punct(i, '(')) {
+            level++;
+        } else if((is_punct(i, '}') || is_punct(i, ')')) && i != close) {
+            level--;
+        } else if(level == 0 && (is_punct(i, ',') || i == close)) {
+            if(i > start) {
+                if(n >= max_items) {
+                    die(tokens[i].line, "too many items", 0);
+                }
+                items[n++] = start;
+            }
+            start = i + 1;
+        }
+    }
+    return n;
+}
+
+/***************************************************************************
+ *  Find the FSM variable, return the index of '{'
+ ***************************************************************************/
+PRIVATE int find_fsm(const char **fsm_name)
+{
+    for(int i=0; i<n_tokens; i++) {
+        if(tokens[i].type != TK_IDENT || strcmp(tokens[i].text, "FSM")!=0) {
+            continue;
+        }
+        int j = i + 1;
+        if(tokens[j].type != TK_IDENT) {
+            continue;   // FSM *, FSM), etc
+        }
+        if(*fsm_name && strcmp(tokens[j].text, *fsm_name)!=0) {
+            continue;
+        }
+        if(is_punct(j+1, '=') && is_punct(j+2, '{')) {
+            *fsm_name = tokens[j].text;
+            return j + 2;
+        }
+    }
+    die(0, "FSM not found", *fsm_name);
+    return -1;
+}
+
+/***************************************************************************
+ *  Index of name in names (case-insensitive, like the core), -1 not found
+ ***************************************************************************/
+PRIVATE int name_index(const char **names, int n, const char *name)
+{
+    for(int i=0; i<n; i++) {
+        if(strcasecmp(names[i], name)==0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/***************************************************************************
+ *  Make a C identifier
+ ***************************************************************************/
+PRIVATE char *c_identifier(const char *s)
+{
+    char *id = xstrndup(s, strlen(s));
+    for(char *p=id; *p; p++) {
+        if(!isalnum((unsigned char)*p)) {
+            *p = '_';
+        }
+    }
+    return id;
+}
+
+/***************************************************************************
+ *  Read the file
+ ***************************************************************************/
+PRIVATE char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if(!fp) {
+        die(0, "cannot open file", path);
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *src = xrealloc(0, size + 1);
+    if(fread(src, 1, size, fp) != (size_t)size) {
+        die(0, "cannot read file", path);
+    }
+    src[size] = 0;
+    fclose(fp);
+    return src;
+}
+
+/***************************************************************************
+ *  Usage
+ ***************************************************************************/
+PRIVATE void usage(void)
+{
+    fprintf(stderr,
+        "Usage: ginsfsm_fsmgen [-f fsm] [-n name] [-o output] gclass.c\n"
+        "  -f fsm      name of the FSM variable (default the first FSM found)\n"
+        "  -n name     name of dispatcher function (default <fsm>_dispatcher)\n"
+        "  -o output   output file (default stdout)\n"
+    );
+    exit(-1);
+}
+
+/***************************************************************************
+ *                      Main
+ ***************************************************************************/
+int main(int argc, char *argv[])
+{
+    const char *fsm_name = 0;
+    const char *fn_name = 0;
+    const char *output = 0;
+
+    int i;
+    for(i=1; i<argc; i++) {
+        if(strcmp(argv[i], "-f")==0 && i+1<argc) {
+            fsm_name = argv[++i];
+        } else if(strcmp(argv[i], "-n")==0 && i+1<argc) {
+            fn_name = argv[++i];
+        } else if(strcmp(argv[i], "-o")==0 && i+1<argc) {
+            output = argv[++i];
+        } else if(argv[i][0] == '-') {
+            usage();
+        } else {
+            break;
+        }
+    }
+    if(i != argc-1) {
+        usage();
+    }
+    filename = argv[i];
+
+    char *src = read_file(filename);
+    tokenize(src);
+
+    /*--------------------------------------*
+     *  FSM = {input_events, output_events, state_names, states}
+     *--------------------------------------*/
+    int fsm_items[8];
+    int open = find_fsm(&fsm_name);
+    if(split_items(open, fsm_items, 8) != 4) {
+        die(tokens[open].line, "FSM must have 4 items", fsm_name);
+    }
+    for(int k=0; k<4; k++) {
+        if(tokens[fsm_items[k]].type != TK_IDENT) {
+            die(tokens[fsm_items[k]].line, "FSM item must be an array name", tokens[fsm_items[k]].text);
+        }
+    }
+
+    /*--------------------------------------*
+     *  Input events
+     *--------------------------------------*/
+    int max_items = n_tokens;
+    int *items = xrealloc(0, sizeof(int) * max_items);
+    open = find_initializer(tokens[fsm_items[0]].text);
+    int n = split_items(open, items, max_items);
+    const char **events = xrealloc(0, sizeof(char *) * (n + 1));
+    int n_events = 0;
+    for(int k=0; k<n; k++) {
+        if(!is_punct(items[k], '{')) {
+            die(tokens[items[k]].line, "EVENT must be {event, flag, authz, description}", 0);
+        }
+        const char *event = resolve_name(items[k] + 1);
+        if(!event) {
+            break;
+        }
+        events[n_events++] = event;
+    }
+
+    /*--------------------------------------*
+     *  State names
+     *--------------------------------------*/
+    open = find_initializer(tokens[fsm_items[2]].text);
+    n = split_items(open, items, max_items);
+    const char **state_names = xrealloc(0, sizeof(char *) * (n + 1));
+    int n_states = 0;
+    for(int k=0; k<n; k++) {
+        const char *state = resolve_name(items[k]);
+        if(!state) {
+            break;
+        }
+        state_names[n_states++] = state;
+    }
+
+    /*--------------------------------------*
+     *  States: EV_ACTION arrays
+     *--------------------------------------*/
+    open = find_initializer(tokens[fsm_items[3]].text);
+    n = split_items(open, items, max_items);
+    state_t *states = xrealloc(0, sizeof(state_t) * (n + 1));
+    int n_arrays = 0;
+    for(int k=0; k<n; k++) {
+        if(is_null(items[k])) {
+            break;
+        }
+        if(tokens[items[k]].type != TK_IDENT) {
+            die(tokens[items[k]].line, "state must be an EV_ACTION array name", tokens[items[k]].text);
+        }
+        states[n_arrays].array = tokens[items[k]].text;
+        n_arrays++;
+    }
+    if(n_arrays != n_states) {
+        die(0, "number of states and state_names don't match", fsm_name);
+    }
+
+    for(int st=0; st<n_states; st++) {
+        state_t *state = states + st;
+        int ev_open = find_initializer(state->array);
+        int *ev_items = xrealloc(0, sizeof(int) * max_items);
+        int n_ev = split_items(ev_open, ev_items, max_items);
+        state->actions = xrealloc(0, sizeof(action_t) * (n_ev + 1));
+        state->n_actions = 0;
+        for(int k=0; k<n_ev; k++) {
+            int action_items[4];
+            if(!is_punct(ev_items[k], '{')) {
+                die(tokens[ev_items[k]].line, "EV_ACTION must be {event, action, next_state}", 0);
+            }
+            int n_fields = split_items(ev_items[k], action_items, 4);
+            if(n_fields < 1) {
+                break;
+            }
+            const char *event = resolve_name(action_items[0]);
+            if(!event) {
+                break;
+            }
+            action_t *action = state->actions + state->n_actions;
+            action->event = event;
+            action->action = (n_fields > 1 && !is_null(action_items[1]))?
+                tokens[action_items[1]].text : 0;
+            action->next_state = (n_fields > 2)? resolve_name(action_items[2]) : 0;
+            state->n_actions++;
+        }
+        free(ev_items);
+    }
+
+    /*--------------------------------------*
+     *  Write the dispatcher
+     *--------------------------------------*/
+    FILE *fp = stdout;
+    if(output) {
+        fp = fopen(output, "w");
+        if(!fp) {
+            die(0, "cannot create file", output);
+        }
+    }
+    if(!fn_name) {
+        char bf[512];
+        snprintf(bf, sizeof(bf), "%s_dispatcher", fsm_name);
+        fn_name = c_identifier(bf);
+    }
+
+    const char *base = strrchr(filename, '/');
+    base = base? base+1 : filename;
+    fprintf(fp,
+        "/***************************************************************************\n"
+        " *  Generated by ginsfsm_fsmgen from %s (FSM %s). DO NOT EDIT.\n"
+        " *  %d states, %d input events.\n"
+        " *\n"
+        " *  Include it after the FSM definition and register it with:\n"
+        " *      gobj_set_fsm_dispatcher(&_gclass, %s);\n"
+        " ***************************************************************************/\n",
+        base, fsm_name, n_states, n_events, fn_name
+    );
+    fprintf(fp, "PRIVATE const EV_ACTION *%s(int state, int event, int *next_state)\n{\n", fn_name);
+    fprintf(fp, "    switch(state) {\n");
+    for(int st=0; st<n_states; st++) {
+        state_t *state = states + st;
+        if(!state->n_actions) {
+            continue;
+        }
+        fprintf(fp, "        case %d: /* %s */\n", st, state_names[st]);
+        fprintf(fp, "            switch(event) {\n");
+
+        /*
+         *  The first action of each event wins, like the table walk
+         */
+        char *done = xrealloc(0, n_events + 1);
+        memset(done, 0, n_events + 1);
+        for(int k=0; k<state->n_actions; k++) {
+            action_t *action = state->actions + k;
+            int ev = name_index(events, n_events, action->event);
+            if(ev < 0) {
+                fprintf(stderr, "%s: WARNING %s: event %s not in input_events, ignored\n",
+                    filename, state->array, action->event
+                );
+                continue;
+            }
+            if(done[ev]) {
+                continue;
+            }
+            done[ev] = 1;
+            int nx = -1;
+            if(action->next_state) {
+                nx = name_index(state_names, n_states, action->next_state);
+                if(nx < 0) {
+                    fprintf(stderr, "%s: WARNING %s: next state %s not in state_names\n",
+                        filename, state->array, action->next_state
+                    );
+                }
+            }
+            fprintf(fp, "                case %d: /* %s -> %s */\n",
+                ev, events[ev], action->action?action->action:"no action"
+            );
+            if(nx >= 0) {
+                fprintf(fp, "                    *next_state = %d; /* %s */\n", nx, state_names[nx]);
+            } else {
+                fprintf(fp, "                    *next_state = -1;\n");
+            }
+            fprintf(fp, "                    return &%s[%d];\n", state->array, k);
+        }
+        free(done);
+        fprintf(fp, "            }\n");
+        fprintf(fp, "            break;\n");
+    }
+    fprintf(fp, "    }\n");
+    fprintf(fp, "    *next_state = -1;\n");
+    fprintf(fp, "    return 0;\n");
+    fprintf(fp, "}\n");
+
+    if(fp != stdout) {
+        fclose(fp);
+    }
+    return 0;
+}